@@ -0,0 +1,6 @@
+// affine transform uploaded as 3 rows of the upper 3x4 part of a matrix (see geometry/affine.h)
+// a mat3x4 (vertex input of 3 locations, or std430 buffer member) holds one row per column
+mat4 AffineToMat4(mat3x4 rows)
+{
+	return transpose(mat4(rows[0], rows[1], rows[2], vec4(0.0, 0.0, 0.0, 1.0)));
+}
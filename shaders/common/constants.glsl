@@ -1,2 +1,7 @@
+#ifndef CONSTANTS_GLSL
+#define CONSTANTS_GLSL
+
 const float PI    = 3.14159265359;
 const float TAU = 6.2831853071;
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef LIGHTS_H
+#define LIGHTS_H
+
+#include constants.glsl
+#include brdf.glsl
+
+// clustered point lights (see graphics/light_cluster.h)
+// view frustum is split into froxels: screen-space tiles times exponential slices of view depth,
+// every froxel (cluster) lists the lights overlapping it
+
+// light culling defines CLUSTER_WRITER to fill cluster lists
+#ifdef CLUSTER_WRITER
+#define CLUSTER_ACCESS writeonly
+#else
+#define CLUSTER_ACCESS readonly
+#endif
+
+struct PointLight
+{
+    vec4 posRadius; // world position, radius
+    vec4 color; // color scaled by intensity, w: 1 if light volume is rendered
+};
+
+layout (std430, binding = 1) readonly buffer PointLights
+{
+    uvec4 clusterGrid; // clusters in x, y, z, number of lights
+    vec4 clusterParams; // slice scale, slice bias, tiles per pixel in x, y
+    PointLight pointLights[];
+};
+
+layout (std430, binding = 2) CLUSTER_ACCESS buffer ClusterGrid
+{
+    uvec2 clusters[]; // first index, number of lights
+};
+
+layout (std430, binding = 3) CLUSTER_ACCESS buffer ClusterIndices
+{
+    uint clusterLights[];
+};
+
+// slice k starts at view depth exp((k - bias) / scale)
+uint ClusterSlice(float viewDepth)
+{
+    float slice = log(max(viewDepth, 1e-4)) * clusterParams.x + clusterParams.y;
+    return uint(clamp(slice, 0.0, float(clusterGrid.z - 1)));
+}
+
+uint ClusterIndex(vec2 fragCoord, float viewDepth)
+{
+    uvec2 tile = min(uvec2(fragCoord * clusterParams.zw), clusterGrid.xy - 1);
+    return (ClusterSlice(viewDepth) * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
+}
+
+#ifndef CLUSTER_WRITER
+// radiance of all point lights in the cluster of the fragment (UE4's light attenuation model)
+vec3 ClusteredPointLighting(vec3 worldPos, vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec2 fragCoord, float viewDepth)
+{
+    vec3 F0 = mix(vec3(0.04), albedo, metallic);
+    float NdotV = max(dot(N, V), 0.0);
+
+    uvec2 cluster = clusters[ClusterIndex(fragCoord, viewDepth)];
+    vec3 Lo = vec3(0.0);
+
+    for (uint i = 0; i < cluster.y; ++i)
+    {
+        PointLight light = pointLights[clusterLights[cluster.x + i]];
+
+        vec3 L = light.posRadius.xyz - worldPos;
+        float distance = length(L);
+        L /= max(distance, 1e-4);
+        vec3 H = normalize(V + L);
+
+        float attenuation = pow(clamp(1.0 - distance / light.posRadius.w, 0.0, 1.0), 2.0) / (distance * distance + 1.0);
+        vec3 radiance = light.color.rgb * attenuation;
+
+        // cook-torrance brdf
+        float NdotL = max(dot(N, L), 0.0);
+        float NDF = DistributionGGX(N, H, roughness);
+        float G   = GeometryGGX(NdotV, NdotL, roughness);
+        vec3 F    = FresnelSchlick(max(dot(H, V), 0.0), F0);
+
+        vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+        vec3 specular = NDF * G * F / (4 * NdotV * NdotL + 0.001);
+
+        Lo += (kD * albedo / PI + specular) * radiance * NdotL;
+    }
+
+    return Lo;
+}
+#endif
+
+#endif
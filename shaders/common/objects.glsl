@@ -0,0 +1,21 @@
+#ifndef OBJECTS_H
+#define OBJECTS_H
+
+#include affine.glsl
+
+// per-object data of all commands, written once per frame (see graphics/object_buffer.h)
+// instanced draws receive the object index as a per-instance attribute
+struct Object
+{
+    mat3x4 model;
+    mat3x4 prevModel;
+};
+
+layout (std430, binding = 0) readonly buffer Objects
+{
+    Object objects[];
+};
+
+layout (location = 8) in uint aObject;
+
+#endif
@@ -17,7 +17,8 @@ layout (std140, binding = 0) uniform GlobalCamera
 
 layout (std140, binding = 1) uniform GlobalLights
 {
-    // lighting
+    // first 4 parallel lights (Renderer::kMaxBlockParallelLights), forward shading ignores the others
+    // point lights are clustered, see lights.glsl
     vec4 dirLight0_Dir;
     vec4 dirLight0_Col;
     vec4 dirLight1_Dir;
@@ -25,22 +26,6 @@ layout (std140, binding = 1) uniform GlobalLights
     vec4 dirLight2_Dir;
     vec4 dirLight2_Col;
     vec4 dirLight3_Dir;
-    vec4 dirLight4_Col;
-    vec4 pointLight0_Pos;
-    vec4 pointLight0_Col;
-    vec4 pointLight1_Pos;
-    vec4 pointLight1_Col;
-    vec4 pointLight2_Pos;
-    vec4 pointLight2_Col;
-    vec4 pointLight3_Pos;
-    vec4 pointLight3_Col;
-    vec4 pointLight4_Pos;
-    vec4 pointLight4_Col;
-    vec4 pointLight5_Pos;
-    vec4 pointLight5_Col;
-    vec4 pointLight6_Pos;
-    vec4 pointLight6_Col;
-    vec4 pointLight7_Pos;
-    vec4 pointLight7_Col;
+    vec4 dirLight3_Col;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#version 430 core
+
+// one invocation per cluster, a work group covers one slice of the grid
+layout (local_size_x = 16, local_size_y = 9, local_size_z = 1) in;
+
+#define CLUSTER_WRITER
+#include ../common/uniforms.glsl
+#include ../common/lights.glsl
+
+#define BATCH_SIZE 144
+
+uniform uint maxLightsPerCluster;
+
+// view-space position and radius of lights loaded by the work group
+shared vec4 batch[BATCH_SIZE];
+
+// view-space point on the ray through ndc, at view depth
+vec3 PointAtDepth(vec2 ndc, float depth)
+{
+    vec4 p = invProjection * vec4(ndc, -1.0, 1.0);
+    p.xyz /= p.w;
+    return p.xyz * (depth / -p.z);
+}
+
+void main()
+{
+    uvec3 id = gl_GlobalInvocationID;
+    bool active = all(lessThan(id, clusterGrid.xyz));
+
+    // froxel bounds in view space
+    vec2 ndcMin = vec2(id.xy) / vec2(clusterGrid.xy) * 2.0 - 1.0;
+    vec2 ndcMax = vec2(id.xy + 1) / vec2(clusterGrid.xy) * 2.0 - 1.0;
+    float depthNear = exp((float(id.z) - clusterParams.y) / clusterParams.x);
+    float depthFar = exp((float(id.z + 1) - clusterParams.y) / clusterParams.x);
+
+    vec3 p0 = PointAtDepth(ndcMin, depthNear);
+    vec3 p1 = PointAtDepth(ndcMax, depthNear);
+    vec3 p2 = PointAtDepth(ndcMin, depthFar);
+    vec3 p3 = PointAtDepth(ndcMax, depthFar);
+    vec3 boxMin = min(min(p0, p1), min(p2, p3));
+    vec3 boxMax = max(max(p0, p1), max(p2, p3));
+
+    uint cluster = (id.z * clusterGrid.y + id.y) * clusterGrid.x + id.x;
+    uint first = cluster * maxLightsPerCluster;
+    uint count = 0;
+
+    uint numLights = clusterGrid.w;
+
+    for (uint base = 0; base < numLights; base += BATCH_SIZE)
+    {
+        uint k = base + gl_LocalInvocationIndex;
+
+        if (k < numLights)
+        {
+            vec4 light = pointLights[k].posRadius;
+            batch[gl_LocalInvocationIndex] = vec4((view * vec4(light.xyz, 1.0)).xyz, light.w);
+        }
+
+        barrier();
+
+        uint size = min(numLights - base, uint(BATCH_SIZE));
+
+        for (uint i = 0; active && i < size && count < maxLightsPerCluster; ++i)
+        {
+            // sphere overlaps box if the closest point in box is within radius
+            vec3 d = batch[i].xyz - clamp(batch[i].xyz, boxMin, boxMax);
+
+            if (dot(d, d) <= batch[i].w * batch[i].w)
+            {
+                clusterLights[first + count] = base + i;
+                ++count;
+            }
+        }
+
+        barrier();
+    }
+
+    if (active) clusters[cluster] = uvec2(first, count);
+}
\ No newline at end of file
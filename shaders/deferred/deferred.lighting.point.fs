@@ -4,22 +4,25 @@ out vec4 FragColor;
 
 in vec3 FragPos;
 in vec4 ScreenPos;
+flat in uint LightIndex;
 
 #include ../common/constants.glsl
 #include ../common/brdf.glsl
 #include ../common/uniforms.glsl
+#include ../common/lights.glsl
 
 uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedo;
 uniform sampler2D gPbrParam;
 
-uniform vec3 lightPos;
-uniform vec3 lightColor;
-uniform float lightRadius;
-
 void main()
 {
+    PointLight light = pointLights[LightIndex];
+    vec3 lightPos = light.posRadius.xyz;
+    float lightRadius = light.posRadius.w;
+    vec3 lightColor = light.color.rgb;
+
     vec2 TexCoord = (ScreenPos.xy / ScreenPos.w) * 0.5 + 0.5;
     
     vec3 worldPos   = texture(gPosition, TexCoord).xyz;
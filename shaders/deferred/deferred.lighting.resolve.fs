@@ -0,0 +1,109 @@
+#version 430 core
+
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+#include ../common/uniforms.glsl
+#include ../common/shadows.glsl
+#include ../common/lights.glsl
+#include ssr.glsl
+
+// parallel lights resolved in this pass (see DeferredRenderer::kMaxResolveLights)
+#define MAX_PARALLEL_LIGHTS 4
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedo;
+uniform sampler2D gPbrParam;
+
+uniform samplerCube envIrradiance;
+uniform samplerCube envReflection;
+uniform sampler2D   BRDFLUT;
+
+uniform int UseSSAO;
+uniform sampler2D TexSSAO;
+
+uniform int UseSSR;
+uniform sampler2D LastImage;
+
+uniform int UseClusteredLights;
+
+uniform int numParallelLights;
+uniform vec3 lightDir[MAX_PARALLEL_LIGHTS];
+uniform vec3 lightColor[MAX_PARALLEL_LIGHTS];
+uniform mat4 lightShadowViewProjection[MAX_PARALLEL_LIGHTS];
+uniform sampler2D lightShadowMap[MAX_PARALLEL_LIGHTS];
+
+// g-buffer is read once, every lighting term accumulates in registers
+// pixels without geometry are rejected by stencil before shading
+void main()
+{
+    vec3 worldPos   = texture(gPosition, TexCoord).xyz;
+    vec3 normal     = texture(gNormal, TexCoord).xyz;
+    vec3 albedo     = texture(gAlbedo, TexCoord).rgb;
+    vec3 pbrParam   = texture(gPbrParam, TexCoord).rgb;
+    float metallic  = pbrParam.r;
+    float roughness = pbrParam.g;
+    float ao        = pbrParam.b;
+
+    if (UseSSAO == 1)
+    {
+        ao *= texture(TexSSAO, TexCoord).r;
+    }
+
+    vec3 N = normalize(normal);
+    vec3 V = normalize(camPos.xyz - worldPos);
+    vec3 R = reflect(-V, N);
+    float NdotV = max(dot(N, V), 0.0);
+
+    vec3 F0 = vec3(0.04);
+    F0 = mix(F0, albedo, metallic);
+
+    // ambient light (image-based lighting w/ Epic's split-sum approximation)
+    const float MAX_REFLECTION_LOD = 5.0;
+    vec3 F = FresnelSchlickRoughness(NdotV, F0, roughness);
+    vec3 reflectionColor = textureLod(envReflection, R, roughness * MAX_REFLECTION_LOD).rgb;
+    vec2 envBRDF = texture(BRDFLUT, vec2(NdotV, roughness)).rg;
+    vec3 specular = reflectionColor * (F * envBRDF.x + envBRDF.y);
+    vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+    vec3 diffuse = albedo * texture(envIrradiance, N).rgb;
+
+    vec3 color = (kD * diffuse + specular) * ao;
+
+    // parallel lights
+    for (int i = 0; i < numParallelLights; ++i)
+    {
+        vec3 L = normalize(-lightDir[i]);
+        vec3 H = normalize(V + L);
+        float NdotL = max(dot(N, L), 0.0);
+
+        vec4 fragPosLightSpace = lightShadowViewProjection[i] * vec4(worldPos, 1.0);
+        float shadow = ShadowFactor(lightShadowMap[i], fragPosLightSpace, N, L);
+
+        // cook-torrance brdf
+        float NDF = DistributionGGX(N, H, roughness);
+        float G   = GeometryGGX(NdotV, NdotL, roughness);
+        vec3 Fd   = FresnelSchlick(max(dot(H, V), 0.0), F0);
+
+        vec3 kDd = (vec3(1.0) - Fd) * (1.0 - metallic);
+        vec3 spec = NDF * G * Fd / (4 * NdotV * NdotL + 0.001);
+
+        color += (kDd * albedo / PI + spec) * lightColor[i] * NdotL * (1.0 - shadow) * ao;
+    }
+
+    // point lights
+    if (UseClusteredLights == 1)
+    {
+        float viewDepth = -(view * vec4(worldPos, 1.0)).z;
+        color += ClusteredPointLighting(worldPos, N, V, albedo, metallic, roughness, gl_FragCoord.xy, viewDepth);
+    }
+
+    // reflect light
+    if (UseSSR == 1)
+    {
+        color += ScreenSpaceReflection(gPosition, LastImage, TexCoord, worldPos, N, V, metallic, roughness);
+    }
+
+    FragColor = vec4(color, 1.0);
+}
\ No newline at end of file
@@ -4,15 +4,19 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 FragPos;
 out vec4 ScreenPos;
+flat out uint LightIndex;
 
 #include ../common/uniforms.glsl
+#include ../common/lights.glsl
 
-uniform mat4 model;
-
+// one instance per light, unit sphere scaled to light radius
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    vec4 light = pointLights[gl_InstanceID].posRadius;
+
+    FragPos = light.xyz + aPos * light.w;
     ScreenPos = projection * view * vec4(FragPos, 1.0);
+    LightIndex = gl_InstanceID;
     
 	gl_Position = ScreenPos;
 }
\ No newline at end of file
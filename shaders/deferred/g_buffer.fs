@@ -1,4 +1,4 @@
-#version 330 core
+#version 430 core
 
 layout (location = 0) out vec4 gPosition; // RBG: position, A: discard flag
 layout (location = 1) out vec4 gNormal; // RBG: normal, A: NA
@@ -15,11 +15,22 @@ in mat3 TBN;
 in vec4 currClipSpacePos;
 in vec4 prevClipSpacePos;
 
-uniform sampler2D TexAlbedo;
-uniform sampler2D TexNormal;
-uniform sampler2D TexMetallic;
-uniform sampler2D TexRoughness;
-uniform sampler2D TexAO;
+// material textures are pooled into texture arrays by size and format (see TextureManager),
+// materials sharing arrays only differ in layers
+uniform sampler2DArray TexAlbedo;
+uniform sampler2DArray TexNormal;
+uniform sampler2DArray TexMetallic;
+uniform sampler2DArray TexRoughness;
+uniform sampler2DArray TexAO;
+
+layout (std140, binding = 2) uniform Material
+{
+    int TexAlbedoLayer;
+    int TexNormalLayer;
+    int TexMetallicLayer;
+    int TexRoughnessLayer;
+    int TexAOLayer;
+};
 
 void main()
 {
@@ -30,8 +41,9 @@ void main()
     // world space normal
     vec3 N = Normal;
 #ifdef MESH_TBN
-    N = texture(TexNormal, TexCoord).rgb;    
-    N = normalize(N * 2.0 - 1.0);
+    // normal maps may be stored in two channels (BC5), z is rebuilt from x and y
+    N.xy = texture(TexNormal, vec3(TexCoord, TexNormalLayer)).rg * 2.0 - 1.0;
+    N.z = sqrt(max(1.0 - dot(N.xy, N.xy), 0.0));
     N = normalize(TBN * N);
 #endif
 
@@ -39,13 +51,13 @@ void main()
     gNormal.a = 1.0;
 
     // color
-    gAlbedo.rgb = texture(TexAlbedo, TexCoord).rgb;
+    gAlbedo.rgb = texture(TexAlbedo, vec3(TexCoord, TexAlbedoLayer)).rgb;
     gAlbedo.a = 1.0;
 
     // pbr parameters
-    gPbrParam.r = texture(TexMetallic, TexCoord).r;
-    gPbrParam.g = texture(TexRoughness, TexCoord).r;
-    gPbrParam.b = texture(TexAO, TexCoord).r;
+    gPbrParam.r = texture(TexMetallic, vec3(TexCoord, TexMetallicLayer)).r;
+    gPbrParam.g = texture(TexRoughness, vec3(TexCoord, TexRoughnessLayer)).r;
+    gPbrParam.b = texture(TexAO, vec3(TexCoord, TexAOLayer)).r;
     gPbrParam.a = 1.0;
 
     // motion blur
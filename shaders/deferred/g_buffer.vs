@@ -17,8 +17,14 @@ out vec4 prevClipSpacePos;
 
 #include ../common/uniforms.glsl
 
+#ifdef INSTANCED
+#include ../common/objects.glsl
+#define model AffineToMat4(objects[aObject].model)
+#define prevModel AffineToMat4(objects[aObject].prevModel)
+#else
 uniform mat4 model;
 uniform mat4 prevModel;
+#endif
 
 float time;
 
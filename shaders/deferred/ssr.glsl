@@ -1,17 +1,8 @@
-#version 430 core
+#ifndef SSR_GLSL
+#define SSR_GLSL
 
-out vec4 FragColor;
-
-noperspective in vec2 TexCoord;
-
-uniform sampler2D gPosition;
-uniform sampler2D gNormal;
-uniform sampler2D gPbrParam;
-uniform sampler2D LastImage;
-
-#include ../common/constants.glsl
-#include ../common/brdf.glsl
-#include ../common/uniforms.glsl
+// screen-space reflection, rays are marched against g-buffer positions and hit color is read from last frame
+// requires uniforms.glsl and brdf.glsl
 
 vec2 WorldPositionToScreenCoord(vec3 world_pos)
 {
@@ -43,7 +34,7 @@ vec3 WorldSpaceHash(vec3 a)
 const int RT_MaxNumBinSteps = 50;
 const float RT_Epsilon = 1e-3;
 
-float RayTraceBinarySearch(vec3 ray_org, vec3 ray_dir, float ray_len_a, float ray_len_b)
+float RayTraceBinarySearch(sampler2D gPosition, vec3 ray_org, vec3 ray_dir, float ray_len_a, float ray_len_b)
 {
     float ray_len = 0;
 
@@ -77,7 +68,7 @@ float RayTraceBinarySearch(vec3 ray_org, vec3 ray_dir, float ray_len_a, float ra
 
 const float RT_MaxNumMarchSteps = 200;
 
-vec2 RayTraceMarch(vec3 ray_org, vec3 ray_dir, float march_step)
+vec2 RayTraceMarch(sampler2D gPosition, vec3 ray_org, vec3 ray_dir, float march_step)
 {
     float ray_len_curr = 0; // current march length
     float ray_len_last = 0; // last march length
@@ -115,21 +106,14 @@ vec2 RayTraceMarch(vec3 ray_org, vec3 ray_dir, float march_step)
     return vec2(0, 0);
 }
 
-void main()
+// reflected color at a g-buffer texel, black if reflection is too weak or the ray leaves the screen
+vec3 ScreenSpaceReflection(sampler2D gPosition, sampler2D LastImage, vec2 TexCoord, vec3 worldPos, vec3 N, vec3 V, float metallic, float roughness)
 {
-    vec3 pbrParam = texture(gPbrParam, TexCoord).rgb;
-    float metallic = pbrParam.r;
-    float roughness = pbrParam.g;
-
     float reflect_falloff = pow(metallic, 3.0);
-    if (reflect_falloff < 0.1) discard;
+    if (reflect_falloff < 0.1) return vec3(0.0);
 
-    vec3 worldPos = texture(gPosition, TexCoord).xyz;
-    vec3 worldNor = texture(gNormal, TexCoord).xyz;
     vec3 lastImg = texture(LastImage, TexCoord).rgb;
 
-    vec3 V = normalize(camPos.xyz - worldPos);
-    vec3 N = normalize(worldNor);
     vec3 R = normalize(reflect(-V, N));
 
     // Noise
@@ -143,13 +127,13 @@ void main()
     vec3 ray_dir = normalize(R + jitt * noise_factor);
     float march_step = 2.0;
 
-    vec2 ray_len_range = RayTraceMarch(ray_org, ray_dir, march_step); // rough search
+    vec2 ray_len_range = RayTraceMarch(gPosition, ray_org, ray_dir, march_step); // rough search
 
     float ray_len_left = ray_len_range.x;
     float ray_len_right = ray_len_range.y;
-    if (ray_len_left >= ray_len_right) discard; // tracing failed
+    if (ray_len_left >= ray_len_right) return vec3(0.0); // tracing failed
 
-    float ray_len = RayTraceBinarySearch(ray_org, ray_dir, ray_len_left, ray_len_right); // fine search
+    float ray_len = RayTraceBinarySearch(gPosition, ray_org, ray_dir, ray_len_left, ray_len_right); // fine search
 
     vec3 ray_front = ray_org + ray_dir * ray_len;
     vec2 pixel_hit_coord = WorldPositionToScreenCoord(ray_front);
@@ -165,7 +149,7 @@ void main()
     float reflect_factor = reflect_falloff * screen_edge_factor;
 
     // Get color
-    vec3 reflectColor = texture(LastImage, pixel_hit_coord).rgb * fresnel_factor * clamp(reflect_factor, 0.0, 1.0);
+    return texture(LastImage, pixel_hit_coord).rgb * fresnel_factor * clamp(reflect_factor, 0.0, 1.0);
+}
 
-    FragColor = vec4(reflectColor, 1.0);
-}
\ No newline at end of file
+#endif
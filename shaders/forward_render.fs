@@ -8,6 +8,7 @@ in vec3 Normal;
 
 #include common/shadows.glsl
 #include common/uniforms.glsl
+#include common/lights.glsl
 #include pbr/pbr.glsl
 
 uniform sampler2D TexAlbedo;
@@ -37,6 +38,11 @@ void main()
     vec4 fragPosLightSpace = lightShadowViewProjection1 * vec4(FragPos, 1.0);
     float shadow = ShadowFactor(lightShadowMap1, fragPosLightSpace, N, L);
     color.rgb *= max(1.0 - shadow, 0.1);
+
+    // point lights of the cluster containing the fragment
+    vec3 V = normalize(camPos.xyz - FragPos);
+    float viewDepth = -(view * vec4(FragPos, 1.0)).z;
+    color += ClusteredPointLighting(FragPos, N, V, albedo.rgb, metallic, roughness, gl_FragCoord.xy, viewDepth);
                       
     #ifdef ALPHA_DISCARD
         if(albedo.a <= 0.5) 
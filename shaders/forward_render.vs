@@ -9,7 +9,12 @@ out vec3 Normal;
 
 #include common/uniforms.glsl
 
+#ifdef INSTANCED
+#include common/objects.glsl
+#define model AffineToMat4(objects[aObject].model)
+#else
 uniform mat4 model;
+#endif
 
 void main()
 {
@@ -2,10 +2,21 @@
 layout (location = 0) in vec3 pos;
 
 #include common/uniforms.glsl
+#include common/lights.glsl
 
-uniform mat4 model;
+uniform float volumeRadius; // light radius if negative
 
+flat out vec3 lightColor;
+
+// one instance per light, unit sphere scaled to volume radius
 void main()
 {
-	gl_Position =  projection * view * model * vec4(pos, 1.0);
+	PointLight light = pointLights[gl_InstanceID];
+	float radius = volumeRadius < 0.0 ? light.posRadius.w : volumeRadius;
+
+	// lights without volume collapse to a point (culled as degenerate)
+	radius *= light.color.w;
+
+	lightColor = light.color.rgb * 0.25;
+	gl_Position =  projection * view * vec4(light.posRadius.xyz + pos * radius, 1.0);
 }
\ No newline at end of file
@@ -13,9 +13,13 @@ uniform mat4 model;
 
 uniform sampler2D TexPerllin;
 
-uniform float Time;
-uniform float Strength;
-uniform float Speed;
+// material parameters (see MaterialBuffer)
+layout (std140, binding = 2) uniform Material
+{
+    float Time;
+    float Strength;
+    float Speed;
+};
 
 void main()
 {
@@ -1,10 +1,15 @@
-#version 330 core
+#version 430 core
 
 layout (location = 0) in vec3 aPos;
 
 uniform mat4 projection;
 uniform mat4 view;
+#ifdef INSTANCED
+#include common/objects.glsl
+#define model AffineToMat4(objects[aObject].model)
+#else
 uniform mat4 model;
+#endif
 
 void main()
 {	
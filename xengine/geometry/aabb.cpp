@@ -1,5 +1,6 @@
 #include "aabb.h"
 
+#include <glm/glm.hpp>
 #include <glm/gtx/matrix_operation.hpp>
 
 #include "constant.h"
@@ -45,6 +46,22 @@ namespace xengine
 		}
 	}
 
+	void AABB::BuildFromTransform(const AABB& aabb, const Affine& transform)
+	{
+		// transform center, and extent by absolute linear part (tight box of the transformed box)
+		glm::vec3 center = (aabb.vmin + aabb.vmax) * 0.5f;
+		glm::vec3 extent = (aabb.vmax - aabb.vmin) * 0.5f;
+
+		glm::vec3 c = transform.TransformPoint(center);
+		glm::vec3 e;
+
+		for (int i = 0; i < 3; ++i)
+			e[i] = glm::dot(glm::abs(glm::vec3(transform.rows[i])), extent);
+
+		vmin = c - e;
+		vmax = c + e;
+	}
+
 	void AABB::UpdateMin(const glm::vec3& umin)
 	{
 		vmin = glm::min(vmin, umin);
@@ -108,4 +125,63 @@ namespace xengine
 		vmin = umin;
 		vmax = umax;
 	}
+
+	bool AABB::Valid() const
+	{
+		return vmin.x <= vmax.x && vmin.y <= vmax.y && vmin.z <= vmax.z;
+	}
+
+	bool AABB::Contains(const AABB& aabb) const
+	{
+		return
+			vmin.x <= aabb.vmin.x && vmin.y <= aabb.vmin.y && vmin.z <= aabb.vmin.z &&
+			vmax.x >= aabb.vmax.x && vmax.y >= aabb.vmax.y && vmax.z >= aabb.vmax.z;
+	}
+
+	bool AABB::Intersect(const AABB& aabb) const
+	{
+		return
+			vmin.x <= aabb.vmax.x && vmin.y <= aabb.vmax.y && vmin.z <= aabb.vmax.z &&
+			vmax.x >= aabb.vmin.x && vmax.y >= aabb.vmin.y && vmax.z >= aabb.vmin.z;
+	}
+
+	bool AABB::Intersect(const glm::vec3& center, float radius) const
+	{
+		// distance from sphere center to closest point in box
+		glm::vec3 closest = glm::clamp(center, vmin, vmax);
+		glm::vec3 d = center - closest;
+
+		return glm::dot(d, d) <= radius * radius;
+	}
+
+	bool AABB::Intersect(const glm::vec3& origin, const glm::vec3& invDir, float tmax, float& t) const
+	{
+		// slab test
+		glm::vec3 t0 = (vmin - origin) * invDir;
+		glm::vec3 t1 = (vmax - origin) * invDir;
+		glm::vec3 tnear = glm::min(t0, t1);
+		glm::vec3 tfar = glm::max(t0, t1);
+
+		float enter = glm::max(glm::max(tnear.x, tnear.y), glm::max(tnear.z, 0.0f));
+		float leave = glm::min(glm::min(tfar.x, tfar.y), glm::min(tfar.z, tmax));
+
+		t = enter;
+		return enter <= leave;
+	}
+
+	float AABB::HalfArea() const
+	{
+		glm::vec3 d = vmax - vmin;
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+
+	glm::vec3 AABB::Center() const
+	{
+		return (vmin + vmax) * 0.5f;
+	}
+
+	glm::vec3 AABB::Extent() const
+	{
+		return (vmax - vmin) * 0.5f;
+	}
 }
@@ -6,6 +6,8 @@
 
 #include <glm/common.hpp>
 
+#include "affine.h"
+
 namespace xengine
 {
 	class AABB
@@ -20,6 +22,7 @@ namespace xengine
 
 		// build box based on other box after transformation
 		void BuildFromTransform(const AABB& aabb, const glm::mat4& transform);
+		void BuildFromTransform(const AABB& aabb, const Affine& transform);
 
 		// update box
 		void UpdateMin(const glm::vec3& umin);
@@ -28,6 +31,27 @@ namespace xengine
 		// union this box with other box
 		void UnionAABB(const AABB& aabb);
 
+		// box is not empty (built from at least one point)
+		bool Valid() const;
+
+		// box contains other box entirely
+		bool Contains(const AABB& aabb) const;
+
+		// box overlaps other box
+		bool Intersect(const AABB& aabb) const;
+
+		// box overlaps sphere
+		bool Intersect(const glm::vec3& center, float radius) const;
+
+		// ray (origin + t * dir, t in [0, tmax]) hits box, return entry distance in t
+		bool Intersect(const glm::vec3& origin, const glm::vec3& invDir, float tmax, float& t) const;
+
+		// half of surface area (cost metric of bounding volume hierarchy)
+		float HalfArea() const;
+
+		glm::vec3 Center() const;
+		glm::vec3 Extent() const;
+
 	public:
 		glm::vec3 vmin;
 		glm::vec3 vmax;
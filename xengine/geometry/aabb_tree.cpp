@@ -0,0 +1,338 @@
+#include "aabb_tree.h"
+
+#include <algorithm>
+
+namespace xengine
+{
+	////////////////////////////////////////////////////////////////
+	// AABB Tree
+	//
+	// Binary tree whose leaves hold (fattened) object boxes and
+	// whose inner nodes hold the union of their children.
+	//
+	// Dynamic use: Insert walks down choosing the child with the
+	// least surface area increase, Update refits ancestors when a
+	// leaf leaves its fat box.
+	// Static use: Build splits leaves top-down at the median of the
+	// longest axis of their centers.
+	////////////////////////////////////////////////////////////////
+
+	AABBTree::AABBTree(float margin)
+		:
+		m_root(kNull),
+		m_freeList(kNull),
+		m_numLeaves(0),
+		m_margin(margin)
+	{
+	}
+
+	void AABBTree::Clear()
+	{
+		m_nodes.clear();
+		m_root = kNull;
+		m_freeList = kNull;
+		m_numLeaves = 0;
+	}
+
+	int AABBTree::allocateNode()
+	{
+		int node;
+
+		if (m_freeList != kNull)
+		{
+			node = m_freeList;
+			m_freeList = m_nodes[node].parent;
+		}
+		else
+		{
+			node = static_cast<int>(m_nodes.size());
+			m_nodes.emplace_back();
+		}
+
+		Node& n = m_nodes[node];
+		n.aabb = AABB();
+		n.data = nullptr;
+		n.parent = kNull;
+		n.left = kNull;
+		n.right = kNull;
+
+		return node;
+	}
+
+	void AABBTree::freeNode(int node)
+	{
+		m_nodes[node].parent = m_freeList;
+		m_nodes[node].left = kNull;
+		m_nodes[node].data = nullptr;
+		m_freeList = node;
+	}
+
+	int AABBTree::Insert(const AABB& aabb, void* data)
+	{
+		int leaf = allocateNode();
+		m_nodes[leaf].aabb = AABB(aabb.vmin - glm::vec3(m_margin), aabb.vmax + glm::vec3(m_margin));
+		m_nodes[leaf].data = data;
+
+		insertLeaf(leaf);
+		++m_numLeaves;
+
+		return leaf;
+	}
+
+	void AABBTree::Remove(int proxy)
+	{
+		removeLeaf(proxy);
+		freeNode(proxy);
+		--m_numLeaves;
+	}
+
+	bool AABBTree::Update(int proxy, const AABB& aabb)
+	{
+		if (m_nodes[proxy].aabb.Contains(aabb)) return false;
+
+		bool teleported = !m_nodes[proxy].aabb.Intersect(aabb);
+
+		m_nodes[proxy].aabb = AABB(aabb.vmin - glm::vec3(m_margin), aabb.vmax + glm::vec3(m_margin));
+
+		// far jump would leave a badly placed leaf, reinsert it instead of refitting
+		if (teleported)
+		{
+			removeLeaf(proxy);
+			insertLeaf(proxy);
+		}
+		else
+		{
+			refit(m_nodes[proxy].parent);
+		}
+
+		return true;
+	}
+
+	void AABBTree::insertLeaf(int leaf)
+	{
+		if (m_root == kNull)
+		{
+			m_root = leaf;
+			m_nodes[leaf].parent = kNull;
+			return;
+		}
+
+		const AABB box = m_nodes[leaf].aabb;
+
+		// find the best sibling: least area increase of the union
+		int index = m_root;
+
+		while (!m_nodes[index].IsLeaf())
+		{
+			const Node& node = m_nodes[index];
+
+			AABB combined = node.aabb;
+			combined.UnionAABB(box);
+
+			float area = node.aabb.HalfArea();
+			float combinedArea = combined.HalfArea();
+
+			// cost of making a new parent for this node and leaf
+			float cost = 2.0f * combinedArea;
+
+			// minimum cost of pushing leaf further down
+			float inheritance = 2.0f * (combinedArea - area);
+
+			auto descendCost = [&](int child) {
+				AABB u = m_nodes[child].aabb;
+				u.UnionAABB(box);
+
+				if (m_nodes[child].IsLeaf()) return u.HalfArea() + inheritance;
+				return u.HalfArea() - m_nodes[child].aabb.HalfArea() + inheritance;
+			};
+
+			float costLeft = descendCost(node.left);
+			float costRight = descendCost(node.right);
+
+			if (cost < costLeft && cost < costRight) break;
+
+			index = costLeft < costRight ? node.left : node.right;
+		}
+
+		// make a new parent for sibling and leaf
+		int sibling = index;
+		int oldParent = m_nodes[sibling].parent;
+		int newParent = allocateNode();
+
+		m_nodes[newParent].parent = oldParent;
+		m_nodes[newParent].left = sibling;
+		m_nodes[newParent].right = leaf;
+		m_nodes[newParent].aabb = m_nodes[sibling].aabb;
+		m_nodes[newParent].aabb.UnionAABB(box);
+
+		m_nodes[sibling].parent = newParent;
+		m_nodes[leaf].parent = newParent;
+
+		if (oldParent == kNull)
+		{
+			m_root = newParent;
+		}
+		else
+		{
+			if (m_nodes[oldParent].left == sibling) m_nodes[oldParent].left = newParent;
+			else m_nodes[oldParent].right = newParent;
+
+			refit(oldParent);
+		}
+	}
+
+	void AABBTree::removeLeaf(int leaf)
+	{
+		if (leaf == m_root)
+		{
+			m_root = kNull;
+			return;
+		}
+
+		// sibling takes the place of parent
+		int parent = m_nodes[leaf].parent;
+		int grandParent = m_nodes[parent].parent;
+		int sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+		if (grandParent == kNull)
+		{
+			m_root = sibling;
+			m_nodes[sibling].parent = kNull;
+		}
+		else
+		{
+			if (m_nodes[grandParent].left == parent) m_nodes[grandParent].left = sibling;
+			else m_nodes[grandParent].right = sibling;
+
+			m_nodes[sibling].parent = grandParent;
+			refit(grandParent);
+		}
+
+		freeNode(parent);
+		m_nodes[leaf].parent = kNull;
+	}
+
+	void AABBTree::refit(int node)
+	{
+		while (node != kNull)
+		{
+			Node& n = m_nodes[node];
+
+			AABB aabb = m_nodes[n.left].aabb;
+			aabb.UnionAABB(m_nodes[n.right].aabb);
+
+			n.aabb = aabb;
+			node = n.parent;
+		}
+	}
+
+	void AABBTree::Build(const std::vector<AABB>& aabbs, const std::vector<void*>& data)
+	{
+		Clear();
+
+		m_buildLeaves.clear();
+
+		for (size_t i = 0; i < aabbs.size(); ++i)
+		{
+			int leaf = allocateNode();
+			m_nodes[leaf].aabb = AABB(aabbs[i].vmin - glm::vec3(m_margin), aabbs[i].vmax + glm::vec3(m_margin));
+			m_nodes[leaf].data = data[i];
+			m_buildLeaves.push_back(leaf);
+		}
+
+		m_numLeaves = static_cast<unsigned int>(aabbs.size());
+
+		if (!m_buildLeaves.empty())
+			m_root = buildRecursive(0, static_cast<int>(m_buildLeaves.size()));
+	}
+
+	int AABBTree::buildRecursive(int first, int last)
+	{
+		if (last - first == 1) return m_buildLeaves[first];
+
+		// bounds of leaf centers decide split axis
+		AABB centers;
+
+		for (int i = first; i < last; ++i)
+		{
+			glm::vec3 c = m_nodes[m_buildLeaves[i]].aabb.Center();
+			centers.UpdateMin(c);
+			centers.UpdateMax(c);
+		}
+
+		glm::vec3 size = centers.vmax - centers.vmin;
+		int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+
+		int mid = (first + last) / 2;
+
+		std::nth_element(m_buildLeaves.begin() + first, m_buildLeaves.begin() + mid, m_buildLeaves.begin() + last,
+			[this, axis](int a, int b) { return m_nodes[a].aabb.Center()[axis] < m_nodes[b].aabb.Center()[axis]; });
+
+		int left = buildRecursive(first, mid);
+		int right = buildRecursive(mid, last);
+
+		int node = allocateNode();
+		Node& n = m_nodes[node];
+		n.left = left;
+		n.right = right;
+		n.aabb = m_nodes[left].aabb;
+		n.aabb.UnionAABB(m_nodes[right].aabb);
+
+		m_nodes[left].parent = node;
+		m_nodes[right].parent = node;
+
+		return node;
+	}
+
+	template<typename Test>
+	void AABBTree::query(const Test& test, std::vector<void*>& results) const
+	{
+		if (m_root == kNull) return;
+
+		std::vector<int> stack;
+		stack.reserve(64);
+		stack.push_back(m_root);
+
+		while (!stack.empty())
+		{
+			int index = stack.back();
+			stack.pop_back();
+
+			const Node& node = m_nodes[index];
+
+			if (!test(node.aabb)) continue;
+
+			if (node.IsLeaf())
+			{
+				results.push_back(node.data);
+			}
+			else
+			{
+				stack.push_back(node.left);
+				stack.push_back(node.right);
+			}
+		}
+	}
+
+	void AABBTree::QueryFrustum(const Frustum& frustum, std::vector<void*>& results) const
+	{
+		query([&frustum](const AABB& aabb) { return frustum.Intersect(aabb.vmin, aabb.vmax); }, results);
+	}
+
+	void AABBTree::QuerySphere(const glm::vec3& center, float radius, std::vector<void*>& results) const
+	{
+		query([&center, radius](const AABB& aabb) { return aabb.Intersect(center, radius); }, results);
+	}
+
+	void AABBTree::QueryBox(const AABB& box, std::vector<void*>& results) const
+	{
+		query([&box](const AABB& aabb) { return aabb.Intersect(box); }, results);
+	}
+
+	void AABBTree::QueryRay(const glm::vec3& origin, const glm::vec3& dir, float tmax, std::vector<void*>& results) const
+	{
+		glm::vec3 invDir = 1.0f / dir; // division by zero gives inf, which slab test handles
+
+		query([&origin, &invDir, tmax](const AABB& aabb) { float t; return aabb.Intersect(origin, invDir, tmax, t); }, results);
+	}
+}
\ No newline at end of file
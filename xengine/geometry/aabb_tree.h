@@ -0,0 +1,94 @@
+#pragma once
+#ifndef XE_AABB_TREE_H
+#define XE_AABB_TREE_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "aabb.h"
+#include "frustum.h"
+
+namespace xengine
+{
+	////////////////////////////////////////////////////////////////
+	// AABB Tree (bounding volume hierarchy)
+	////////////////////////////////////////////////////////////////
+
+	class AABBTree
+	{
+	public:
+		static const int kNull = -1;
+
+		struct Node
+		{
+			AABB aabb; // fat box for leaves
+			void* data; // leaf only
+
+			int parent;
+			int left;
+			int right;
+
+			inline bool IsLeaf() const { return left == kNull; }
+		};
+
+	public:
+		// margin added around leaf boxes so that small movement needs no tree change
+		explicit AABBTree(float margin = 0.1f);
+
+		void Clear();
+
+		// insert a leaf, return its proxy id (stable until removed)
+		int Insert(const AABB& aabb, void* data);
+
+		// remove a leaf by proxy id
+		void Remove(int proxy);
+
+		// leaf moved: nothing happens if new box still fits in the fat box
+		// otherwise the leaf box is replaced and ancestors are refit (return true)
+		// a leaf jumping out of its old box entirely is reinserted
+		bool Update(int proxy, const AABB& aabb);
+
+		// rebuild tree top-down from scratch (used for static objects, better quality than insertion)
+		void Build(const std::vector<AABB>& aabbs, const std::vector<void*>& data);
+
+		// collect data of leaves overlapping the volume
+		void QueryFrustum(const Frustum& frustum, std::vector<void*>& results) const;
+		void QuerySphere(const glm::vec3& center, float radius, std::vector<void*>& results) const;
+		void QueryBox(const AABB& aabb, std::vector<void*>& results) const;
+		void QueryRay(const glm::vec3& origin, const glm::vec3& dir, float tmax, std::vector<void*>& results) const;
+
+		inline void* GetData(int proxy) const { return m_nodes[proxy].data; }
+		inline const AABB& GetFatAABB(int proxy) const { return m_nodes[proxy].aabb; }
+		inline unsigned int Size() const { return m_numLeaves; }
+
+	private:
+		int allocateNode();
+		void freeNode(int node);
+
+		void insertLeaf(int leaf);
+		void removeLeaf(int leaf);
+
+		// recompute boxes from node up to root
+		void refit(int node);
+
+		// build subtree over leaves [first, last) of m_buildLeaves
+		int buildRecursive(int first, int last);
+
+		// generic traversal, test(aabb) decides whether to descend
+		template<typename Test>
+		void query(const Test& test, std::vector<void*>& results) const;
+
+	private:
+		std::vector<Node> m_nodes;
+		int m_root;
+		int m_freeList; // free nodes linked through Node::parent
+		unsigned int m_numLeaves;
+		float m_margin;
+
+		// scratch of Build
+		std::vector<int> m_buildLeaves;
+	};
+}
+
+#endif // !XE_AABB_TREE_H
@@ -0,0 +1,79 @@
+#include "affine.h"
+
+namespace xengine
+{
+	Affine::Affine()
+	{
+		rows[0] = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+		rows[1] = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+		rows[2] = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+	}
+
+	Affine::Affine(const glm::mat4& matrix)
+	{
+		// glm is column major: matrix[column][row]
+		for (int i = 0; i < 3; ++i)
+			rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+	}
+
+	Affine Affine::Compose(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+	{
+		glm::mat3 r = glm::mat3_cast(rotation);
+		Affine result;
+
+		for (int i = 0; i < 3; ++i)
+			result.rows[i] = glm::vec4(r[0][i] * scale.x, r[1][i] * scale.y, r[2][i] * scale.z, translation[i]);
+
+		return result;
+	}
+
+	glm::mat4 Affine::ToMat4() const
+	{
+		glm::mat4 matrix;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			matrix[0][i] = rows[i].x;
+			matrix[1][i] = rows[i].y;
+			matrix[2][i] = rows[i].z;
+			matrix[3][i] = rows[i].w;
+		}
+
+		matrix[0][3] = 0.0f;
+		matrix[1][3] = 0.0f;
+		matrix[2][3] = 0.0f;
+		matrix[3][3] = 1.0f;
+
+		return matrix;
+	}
+
+	Affine Affine::operator* (const Affine& other) const
+	{
+		Affine result;
+
+		for (int i = 0; i < 3; ++i)
+		{
+			const glm::vec4& row = rows[i];
+
+			result.rows[i] =
+				row.x * other.rows[0] +
+				row.y * other.rows[1] +
+				row.z * other.rows[2] +
+				glm::vec4(0.0f, 0.0f, 0.0f, row.w);
+		}
+
+		return result;
+	}
+
+	glm::vec3 Affine::TransformPoint(const glm::vec3& point) const
+	{
+		glm::vec4 p(point, 1.0f);
+		return glm::vec3(glm::dot(rows[0], p), glm::dot(rows[1], p), glm::dot(rows[2], p));
+	}
+
+	glm::vec3 Affine::TransformVector(const glm::vec3& vector) const
+	{
+		glm::vec4 v(vector, 0.0f);
+		return glm::vec3(glm::dot(rows[0], v), glm::dot(rows[1], v), glm::dot(rows[2], v));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef XE_AFFINE_H
+#define XE_AFFINE_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace xengine
+{
+	// affine transform stored as the upper 3 rows of a 4x4 matrix (last row is always 0, 0, 0, 1)
+	// p' = (dot(rows[0], p), dot(rows[1], p), dot(rows[2], p)) for p = (x, y, z, 1)
+	// Note: rows are laid out as they are uploaded (3 x vec4, 48 bytes instead of 64)
+	struct Affine
+	{
+		glm::vec4 rows[3];
+
+		// identity
+		Affine();
+
+		explicit Affine(const glm::mat4& matrix);
+
+		// translate * rotate * scale
+		static Affine Compose(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+		glm::mat4 ToMat4() const;
+
+		// this transform applied after other
+		Affine operator* (const Affine& other) const;
+
+		glm::vec3 TransformPoint(const glm::vec3& point) const;
+		glm::vec3 TransformVector(const glm::vec3& vector) const;
+
+		inline glm::vec3 Translation() const { return glm::vec3(rows[0].w, rows[1].w, rows[2].w); }
+	};
+}
+
+#endif // !XE_AFFINE_H
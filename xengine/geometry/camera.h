@@ -43,6 +43,9 @@ namespace xengine
 		inline const glm::mat4& GetView() const { return matView; }
 		inline const glm::mat4& GetPrevView() const { return matPrevView; }
 		inline const glm::mat4& GetProjection() const { return matProjection; }
+		inline const Frustum& GetFrustum() const { return frustum; }
+		inline float GetNear() const { return zNear; }
+		inline float GetFar() const { return zFar; }
 
 	protected:
 		void updateProjPerspective();
@@ -0,0 +1,248 @@
+#include "frustum_cull.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define XE_CULL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace xengine
+{
+	////////////////////////////////////////////////////////////////
+	// Batch Frustum Culling
+	//
+	// Box (c, e) is outside of plane \pi_i <=>
+	// n_i \dot c + d_i - |n_i| \dot e > 0
+	//
+	// which is the same positive vertex test as Frustum::Intersect.
+	// 4 (SSE) or 8 (AVX) boxes are loaded per iteration and tested
+	// against all views before moving on, so bounds are read once
+	// no matter how many frusta there are. Bit v of a box's mask is
+	// set if the box is (possibly) visible in view v.
+	// Kernel is picked on first use based on cpu support; non-x86
+	// targets use the scalar loop.
+	////////////////////////////////////////////////////////////////
+
+	void BoundsSoA::Resize(size_t n)
+	{
+		cx.resize(n); cy.resize(n); cz.resize(n);
+		ex.resize(n); ey.resize(n); ez.resize(n);
+	}
+
+	void BoundsSoA::Set(size_t i, const AABB& aabb)
+	{
+		glm::vec3 c = (aabb.vmin + aabb.vmax) * 0.5f;
+		glm::vec3 e = (aabb.vmax - aabb.vmin) * 0.5f;
+
+		cx[i] = c.x; cy[i] = c.y; cz[i] = c.z;
+		ex[i] = e.x; ey[i] = e.y; ez[i] = e.z;
+	}
+
+	namespace
+	{
+		struct PlaneSoA
+		{
+			float nx[6], ny[6], nz[6], d[6];
+			float ax[6], ay[6], az[6]; // |n|
+		};
+
+		void splitPlanes(const Frustum& frustum, PlaneSoA& p)
+		{
+			for (int i = 0; i < 6; ++i)
+			{
+				const Frustum::Plane& plane = frustum.planes[i];
+				p.nx[i] = plane.normal.x; p.ny[i] = plane.normal.y; p.nz[i] = plane.normal.z;
+				p.ax[i] = std::fabs(plane.normal.x); p.ay[i] = std::fabs(plane.normal.y); p.az[i] = std::fabs(plane.normal.z);
+				p.d[i] = plane.D;
+			}
+		}
+
+		bool outsideScalar(const PlaneSoA& p, const BoundsSoA& b, size_t k)
+		{
+			for (int i = 0; i < 6; ++i)
+			{
+				float dist = p.nx[i] * b.cx[k] + p.ny[i] * b.cy[k] + p.nz[i] * b.cz[k] + p.d[i];
+				float radius = p.ax[i] * b.ex[k] + p.ay[i] * b.ey[k] + p.az[i] * b.ez[k];
+
+				if (dist - radius > 0.0f) return true;
+			}
+
+			return false;
+		}
+
+#ifdef XE_CULL_X86
+		// SSE2 is baseline on x86-64, no dispatch needed
+		struct BoxSSE { __m128 cx, cy, cz, ex, ey, ez; };
+
+		// lanes of outside boxes are all ones
+		inline __m128 outsideSSE(const PlaneSoA& p, const BoxSSE& box)
+		{
+			__m128 outside = _mm_setzero_ps();
+
+			for (int i = 0; i < 6; ++i)
+			{
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.nx[i]), box.cx), _mm_mul_ps(_mm_set1_ps(p.ny[i]), box.cy)),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.nz[i]), box.cz), _mm_set1_ps(p.d[i])));
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.ax[i]), box.ex), _mm_mul_ps(_mm_set1_ps(p.ay[i]), box.ey)),
+					_mm_mul_ps(_mm_set1_ps(p.az[i]), box.ez));
+
+				outside = _mm_or_ps(outside, _mm_cmpgt_ps(_mm_sub_ps(dist, radius), _mm_setzero_ps()));
+			}
+
+			return outside;
+		}
+
+		size_t cullSSE(const PlaneSoA* planes, unsigned int numViews, const BoundsSoA& b, size_t first, size_t last, unsigned int* masks)
+		{
+			size_t k = first;
+			BoxSSE box;
+
+			for (; k + 4 <= last; k += 4)
+			{
+				// box is loaded once for all views
+				box.cx = _mm_loadu_ps(&b.cx[k]); box.cy = _mm_loadu_ps(&b.cy[k]); box.cz = _mm_loadu_ps(&b.cz[k]);
+				box.ex = _mm_loadu_ps(&b.ex[k]); box.ey = _mm_loadu_ps(&b.ey[k]); box.ez = _mm_loadu_ps(&b.ez[k]);
+
+				__m128 visible = _mm_setzero_ps();
+
+				for (unsigned int v = 0; v < numViews; ++v)
+				{
+					__m128 bit = _mm_castsi128_ps(_mm_set1_epi32(1 << v));
+					visible = _mm_or_ps(visible, _mm_andnot_ps(outsideSSE(planes[v], box), bit));
+				}
+
+				_mm_storeu_ps(reinterpret_cast<float*>(&masks[k]), visible);
+			}
+
+			return k;
+		}
+
+#ifdef _MSC_VER
+#define XE_TARGET_AVX
+#else
+#define XE_TARGET_AVX __attribute__((target("avx")))
+#endif
+		struct BoxAVX { __m256 cx, cy, cz, ex, ey, ez; };
+
+		// lanes of outside boxes are all ones
+		XE_TARGET_AVX
+		inline __m256 outsideAVX(const PlaneSoA& p, const BoxAVX& box)
+		{
+			__m256 outside = _mm256_setzero_ps();
+
+			for (int i = 0; i < 6; ++i)
+			{
+				__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.nx[i]), box.cx), _mm256_mul_ps(_mm256_set1_ps(p.ny[i]), box.cy)),
+					_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.nz[i]), box.cz), _mm256_set1_ps(p.d[i])));
+				__m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(p.ax[i]), box.ex), _mm256_mul_ps(_mm256_set1_ps(p.ay[i]), box.ey)),
+					_mm256_mul_ps(_mm256_set1_ps(p.az[i]), box.ez));
+
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_sub_ps(dist, radius), _mm256_setzero_ps(), _CMP_GT_OQ));
+			}
+
+			return outside;
+		}
+
+		XE_TARGET_AVX
+		size_t cullAVX(const PlaneSoA* planes, unsigned int numViews, const BoundsSoA& b, size_t first, size_t last, unsigned int* masks)
+		{
+			size_t k = first;
+			BoxAVX box;
+
+			for (; k + 8 <= last; k += 8)
+			{
+				// box is loaded once for all views
+				box.cx = _mm256_loadu_ps(&b.cx[k]); box.cy = _mm256_loadu_ps(&b.cy[k]); box.cz = _mm256_loadu_ps(&b.cz[k]);
+				box.ex = _mm256_loadu_ps(&b.ex[k]); box.ey = _mm256_loadu_ps(&b.ey[k]); box.ez = _mm256_loadu_ps(&b.ez[k]);
+
+				__m256 visible = _mm256_setzero_ps();
+
+				for (unsigned int v = 0; v < numViews; ++v)
+				{
+					__m256 bit = _mm256_castsi256_ps(_mm256_set1_epi32(1 << v));
+					visible = _mm256_or_ps(visible, _mm256_andnot_ps(outsideAVX(planes[v], box), bit));
+				}
+
+				_mm256_storeu_ps(reinterpret_cast<float*>(&masks[k]), visible);
+			}
+
+			return k;
+		}
+
+		bool supportAVX()
+		{
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 1);
+
+			// avx and osxsave, then make sure os saves ymm registers
+			bool cpu = (info[2] & (1 << 28)) && (info[2] & (1 << 27));
+			return cpu && (_xgetbv(0) & 0x6) == 0x6;
+#else
+			return __builtin_cpu_supports("avx");
+#endif
+		}
+#endif // XE_CULL_X86
+
+		FrustumCull::PATH detectPath()
+		{
+#ifdef XE_CULL_X86
+			return supportAVX() ? FrustumCull::AVX : FrustumCull::SSE;
+#else
+			return FrustumCull::SCALAR;
+#endif
+		}
+	}
+
+	FrustumCull::PATH FrustumCull::Path()
+	{
+		static const PATH path = detectPath();
+		return path;
+	}
+
+	void FrustumCull::Cull(const Frustum* const* frusta, unsigned int numViews, const BoundsSoA& bounds, unsigned int* masks)
+	{
+		Cull(frusta, numViews, bounds, 0, bounds.Size(), masks);
+	}
+
+	void FrustumCull::Cull(const Frustum* const* frusta, unsigned int numViews, const BoundsSoA& bounds, size_t first, size_t last, unsigned int* masks)
+	{
+		PlaneSoA planes[kMaxViews];
+
+		if (numViews > kMaxViews) numViews = kMaxViews;
+
+		for (unsigned int v = 0; v < numViews; ++v)
+			splitPlanes(*frusta[v], planes[v]);
+
+		size_t k = first;
+
+#ifdef XE_CULL_X86
+		if (Path() == AVX) k = cullAVX(planes, numViews, bounds, first, last, masks);
+		else if (Path() == SSE) k = cullSSE(planes, numViews, bounds, first, last, masks);
+#endif
+
+		// tail (or everything without simd)
+		for (; k < last; ++k)
+		{
+			unsigned int visible = 0;
+
+			for (unsigned int v = 0; v < numViews; ++v)
+			{
+				if (!outsideScalar(planes[v], bounds, k))
+					visible |= 1u << v;
+			}
+
+			masks[k] = visible;
+		}
+	}
+
+	void FrustumCull::Cull(const Frustum& frustum, const BoundsSoA& bounds, unsigned int* masks)
+	{
+		const Frustum* frusta[] = { &frustum };
+		Cull(frusta, 1, bounds, masks);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef XE_FRUSTUM_CULL_H
+#define XE_FRUSTUM_CULL_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "aabb.h"
+#include "frustum.h"
+
+namespace xengine
+{
+	// structure-of-arrays box bounds (center and half extent) for batch culling
+	struct BoundsSoA
+	{
+		std::vector<float> cx, cy, cz;
+		std::vector<float> ex, ey, ez;
+
+		void Resize(size_t n);
+		void Set(size_t i, const AABB& aabb);
+		inline size_t Size() const { return cx.size(); }
+	};
+
+	class FrustumCull
+	{
+	public:
+		enum PATH
+		{
+			SCALAR,
+			SSE,
+			AVX,
+		};
+
+		// maximum number of frusta culled in one pass (one bit per view)
+		static const unsigned int kMaxViews = 32;
+
+		// test all boxes against all frusta in a single pass
+		// bit v of masks[i] is set if ith box is (possibly) visible in vth frustum
+		// masks must hold at least bounds.Size() elements
+		static void Cull(const Frustum* const* frusta, unsigned int numViews, const BoundsSoA& bounds, unsigned int* masks);
+
+		// cull boxes in [first, last) only (e.g. a chunk of a parallel job)
+		static void Cull(const Frustum* const* frusta, unsigned int numViews, const BoundsSoA& bounds, size_t first, size_t last, unsigned int* masks);
+
+		// single frustum version (masks[i] is either 1 or 0)
+		static void Cull(const Frustum& frustum, const BoundsSoA& bounds, unsigned int* masks);
+
+		// kernel picked by runtime cpu detection
+		static PATH Path();
+	};
+}
+
+#endif // !XE_FRUSTUM_CULL_H
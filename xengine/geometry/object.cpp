@@ -11,7 +11,8 @@ namespace xengine
 		rotation(glm::quat{}),
 		transform(),
 		prevTrans(),
-		dirty(false)
+		dirty(false),
+		updated(false)
 	{
 	}
 
@@ -53,19 +54,17 @@ namespace xengine
 
 	void GeometryObject::UpdateTransform()
 	{
-		UpdateTransform(glm::mat4{});
+		UpdateTransform(Affine());
 	}
 
-	void GeometryObject::UpdateTransform(const glm::mat4 & parentTrans)
+	void GeometryObject::UpdateTransform(const Affine & parentTrans)
 	{
 		prevTrans = transform;
+		updated = dirty;
 		if (!dirty) return;
 
 		// first scale, then rotate, then translation
-		glm::mat4 matTranslate = glm::translate(glm::mat4{}, position);
-		glm::mat4 matScaling = glm::scale(glm::mat4{}, scale);
-		glm::mat4 matRotation = glm::mat4_cast(rotation);
-		transform = matTranslate * matRotation * matScaling;
+		transform = Affine::Compose(position, rotation, scale);
 
 		// transmit transform from parent
 		transform = parentTrans * transform;
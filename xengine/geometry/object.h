@@ -6,6 +6,7 @@
 #include <glm/gtc/quaternion.hpp>
 
 #include <geometry/aabb.h>
+#include <geometry/affine.h>
 
 namespace xengine
 {
@@ -32,7 +33,7 @@ namespace xengine
 		virtual void UpdateTransform();
 
 		// update model's and all its children's transform matrices, given a parent transform matrix
-		virtual void UpdateTransform(const glm::mat4& parentTrans);
+		virtual void UpdateTransform(const Affine& parentTrans);
 
 	public:
 		// bounding box
@@ -40,12 +41,13 @@ namespace xengine
 		AABB aabbGlobal;
 
 		// transform
-		glm::mat4 transform;
-		glm::mat4 prevTrans;
+		Affine transform;
+		Affine prevTrans;
 		glm::quat rotation;
 		glm::vec3 position;
 		glm::vec3 scale;
 		bool dirty;
+		bool updated; // transform was rebuilt by latest UpdateTransform
 	};
 }
 
@@ -75,20 +75,23 @@ namespace xengine
 		m_filterShader.AttachVertexShader(ReadShaderSource("shaders/effect/effect.quad.vs"));
 		m_filterShader.AttachFragmentShader(ReadShaderSource("shaders/effect/effect.bloom.filter.fs"));
 		m_filterShader.GenerateAndLink();
-		m_filterShader.Bind();
-		m_filterShader.SetUniform("TexSrc", 0);
-		m_filterShader.Unbind();
 
 		m_blurShader.AttachVertexShader(ReadShaderSource("shaders/effect/effect.quad.vs"));
 		m_blurShader.AttachFragmentShader(ReadShaderSource("shaders/effect/effect.bloom.blur.fs"));
 		m_blurShader.GenerateAndLink();
-		m_blurShader.Bind();
-		m_blurShader.SetUniform("TexSrc", 0);
-		m_blurShader.Unbind();
 
 		m_postShader.AttachVertexShader(ReadShaderSource("shaders/effect/effect.quad.vs"));
 		m_postShader.AttachFragmentShader(ReadShaderSource("shaders/effect/effect.bloom.post.fs"));
 		m_postShader.GenerateAndLink();
+
+		m_filterShader.Bind();
+		m_filterShader.SetUniform("TexSrc", 0);
+		m_filterShader.Unbind();
+
+		m_blurShader.Bind();
+		m_blurShader.SetUniform("TexSrc", 0);
+		m_blurShader.Unbind();
+
 		m_postShader.Bind();
 		m_postShader.SetUniform("TexSrc", 0);
 		m_postShader.SetUniform("TexBloom1", 1);
@@ -11,9 +11,21 @@
 
 #include "render_config.h"
 #include "general_renderer.h"
+#include "instance_buffer.h"
+#include "light_cluster.h"
 
 namespace xengine
 {
+	namespace
+	{
+		// uniforms set per draw / per light
+		const UniformID kModel("model");
+		const UniformID kPrevModel("prevModel");
+		const UniformID kLightDir("lightDir");
+		const UniformID kLightColor("lightColor");
+		const UniformID kLightShadowViewProjection("lightShadowViewProjection");
+	}
+
 	DeferredRenderer::DeferredRenderer()
 	{
 		// geometry buffer requires 4 color attachments (PositionMetallic, NormalRoughness, AlbedoAO, Motion)
@@ -30,25 +42,35 @@ namespace xengine
 		//m_gBuffer.GenerateDepthAttachment(1, 1, GL_HALF_FLOAT);
 
 		// actually depth value will not be used except depth test, so an RBO is a better choice
-		m_gBuffer.GenerateDepthRenderBuffer(1, 1);
-
-		m_ambientLightShader.AttachVertexShader(ReadShaderSource("shaders/deferred/deferred.quad.vs"));
-		m_ambientLightShader.AttachFragmentShader(ReadShaderSource("shaders/deferred/deferred.lighting.ambient.fs"));
-		m_ambientLightShader.GenerateAndLink();
-		m_ambientLightShader.Bind();
-		m_ambientLightShader.SetUniform("gPosition", 0);
-		m_ambientLightShader.SetUniform("gNormal", 1);
-		m_ambientLightShader.SetUniform("gAlbedo", 2);
-		m_ambientLightShader.SetUniform("gPbrParam", 3);
-		m_ambientLightShader.SetUniform("envIrradiance", 4);
-		m_ambientLightShader.SetUniform("envReflection", 5);
-		m_ambientLightShader.SetUniform("BRDFLUT", 6);
-		m_ambientLightShader.SetUniform("TexSSAO", 7);
-		m_ambientLightShader.Unbind();
+		// stencil marks pixels covered by geometry, lighting passes skip the rest
+		m_gBuffer.GenerateDepthStencilRenderBuffer(1, 1);
+
+		// submit all programs before any of them is used, so their compiles overlap
+		m_resolveShader.AttachVertexShader(ReadShaderSource("shaders/deferred/deferred.quad.vs"));
+		m_resolveShader.AttachFragmentShader(ReadShaderSource("shaders/deferred/deferred.lighting.resolve.fs"));
+		m_resolveShader.GenerateAndLink();
 
 		m_parallelLightShader.AttachVertexShader(ReadShaderSource("shaders/deferred/deferred.quad.vs"));
 		m_parallelLightShader.AttachFragmentShader(ReadShaderSource("shaders/deferred/deferred.lighting.parallel.fs"));
 		m_parallelLightShader.GenerateAndLink();
+
+		m_pointLightShader.AttachVertexShader(ReadShaderSource("shaders/deferred/deferred.sphere.vs"));
+		m_pointLightShader.AttachFragmentShader(ReadShaderSource("shaders/deferred/deferred.lighting.point.fs"));
+		m_pointLightShader.GenerateAndLink();
+
+		m_resolveShader.Bind();
+		m_resolveShader.SetUniform("gPosition", 0);
+		m_resolveShader.SetUniform("gNormal", 1);
+		m_resolveShader.SetUniform("gAlbedo", 2);
+		m_resolveShader.SetUniform("gPbrParam", 3);
+		m_resolveShader.SetUniform("envIrradiance", 4);
+		m_resolveShader.SetUniform("envReflection", 5);
+		m_resolveShader.SetUniform("BRDFLUT", 6);
+		m_resolveShader.SetUniform("TexSSAO", 7);
+		m_resolveShader.SetUniform("LastImage", 8);
+		m_resolveShader.SetUniform("lightShadowMap", kMaxResolveLights, std::vector<int>{ 9, 10, 11, 12 });
+		m_resolveShader.Unbind();
+
 		m_parallelLightShader.Bind();
 		m_parallelLightShader.SetUniform("gPosition", 0);
 		m_parallelLightShader.SetUniform("gNormal", 1);
@@ -58,9 +80,6 @@ namespace xengine
 		m_parallelLightShader.SetUniform("lightShadowMap", 5);
 		m_parallelLightShader.Unbind();
 
-		m_pointLightShader.AttachVertexShader(ReadShaderSource("shaders/deferred/deferred.sphere.vs"));
-		m_pointLightShader.AttachFragmentShader(ReadShaderSource("shaders/deferred/deferred.lighting.point.fs"));
-		m_pointLightShader.GenerateAndLink();
 		m_pointLightShader.Bind();
 		m_pointLightShader.SetUniform("gPosition", 0);
 		m_pointLightShader.SetUniform("gNormal", 1);
@@ -68,16 +87,6 @@ namespace xengine
 		m_pointLightShader.SetUniform("gPbrParam", 3);
 		m_pointLightShader.Unbind();
 
-		m_reflectLightShader.AttachVertexShader(ReadShaderSource("shaders/deferred/deferred.quad.vs"));
-		m_reflectLightShader.AttachFragmentShader(ReadShaderSource("shaders/deferred/deferred.lighting.reflect.fs"));
-		m_reflectLightShader.GenerateAndLink();
-		m_reflectLightShader.Bind();
-		m_reflectLightShader.SetUniform("gPosition", 0);
-		m_reflectLightShader.SetUniform("gNormal", 1);
-		m_reflectLightShader.SetUniform("gPbrParam", 2);
-		m_reflectLightShader.SetUniform("LastImage", 3);
-		m_reflectLightShader.Unbind();
-
 		m_quad = MeshManager::LoadGlobalPrimitive("quad");
 		m_sphere = MeshManager::LoadGlobalPrimitive("sphere", 16, 8);
 	}
@@ -87,7 +96,7 @@ namespace xengine
 		m_gBuffer.Resize(width, height);
 	}
 
-	void DeferredRenderer::Generate(const std::vector<RenderCommand>& commands)
+	void DeferredRenderer::Generate(const RenderCommandList& commands)
 	{
 		m_gBuffer.Bind();
 
@@ -102,24 +111,49 @@ namespace xengine
 		glDrawBuffers(5, attachments);
 
 		glViewport(0, 0, m_gBuffer.Width(), m_gBuffer.Height());
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+		InstanceBuffer::Upload(commands);
+
+		OglStatus::SetStencilTest(GL_TRUE);
+		OglStatus::SetStencilFunc(GL_ALWAYS, 1, 0xff);
+		OglStatus::SetStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 
 		OglStatus::Lock(); // we don't want materials change OpenGL settings in this pass
 		{
-			for (const RenderCommand& command : commands)
+			// draw a run of commands sharing material (and mesh, or vertex format of MeshBuffer) at once
+			// single commands go instanced as well, instanced shaders read transforms from ObjectBuffer
+			for (const IndirectBuffer::Run& run : IndirectBuffer::Build(commands))
 			{
-				Material * material = command.material;
-				Mesh * mesh = command.mesh;
-
-				material->shader.Bind();
-				material->shader.SetUniform("model", command.transform);
-				material->shader.SetUniform("prevModel", command.prevTrans);
-
-				RenderMesh(mesh, material);
+				Material * material = commands[run.first].material;
+				Shader instanced = ShaderManager::GetInstanced(material->shader);
+
+				if (instanced)
+				{
+					if (run.numDraws > 0)
+						RenderMeshIndirect(material, instanced, run);
+					else
+						RenderMeshInstanced(commands[run.first].mesh, material, instanced, static_cast<unsigned int>(run.first), static_cast<unsigned int>(run.count));
+					continue;
+				}
+
+				// shader without instanced variant, fall back to per-draw uniforms
+				for (size_t i = run.first; i < run.first + run.count; ++i)
+				{
+					const RenderCommand& command = commands[i];
+
+					material->shader.Bind();
+					material->shader.SetUniform(kModel, command.transform.ToMat4());
+					material->shader.SetUniform(kPrevModel, command.prevTrans.ToMat4());
+
+					RenderMesh(command.mesh, material);
+				}
 			}
 		}
 		OglStatus::Unlock();
 
+		OglStatus::SetStencilTest(GL_FALSE);
+
 		// disable usage of attachments
 		attachments[1] = GL_NONE;
 		attachments[2] = GL_NONE;
@@ -151,9 +185,9 @@ namespace xengine
 			ParallelShadow& shadow = light->shadow;
 			shadow.GetFrameBuffer()->GetDepthStencilAttachment(0).Bind(5); // lightShadowMap
 
-			m_parallelLightShader.SetUniform("lightDir", light->direction);
-			m_parallelLightShader.SetUniform("lightColor", glm::normalize(light->color) * light->intensity);
-			m_parallelLightShader.SetUniform("lightShadowViewProjection", shadow.GetViewProj());
+			m_parallelLightShader.SetUniform(kLightDir, light->direction);
+			m_parallelLightShader.SetUniform(kLightColor, glm::normalize(light->color) * light->intensity);
+			m_parallelLightShader.SetUniform(kLightShadowViewProjection, shadow.GetViewProj());
 
 			RenderMesh(&m_quad);
 		}
@@ -165,7 +199,7 @@ namespace xengine
 		OglStatus::SetDepthTest(GL_TRUE);
 	}
 
-	void DeferredRenderer::RenderPointLights(const std::vector<PointLight*>& lights, Camera * camera)
+	void DeferredRenderer::RenderPointLights()
 	{
 		GetTexPosition().Bind(0); // gPositionMetallic
 		GetTexNormal().Bind(1); // gNormalRoughness
@@ -182,22 +216,8 @@ namespace xengine
 
 		m_pointLightShader.Bind();
 
-		for (PointLight* light : lights)
-		{
-			if (!camera->IntersectFrustum(light->position, light->radius)) continue;
-
-			glm::mat4 model;
-			glm::mat4 translate = glm::translate(glm::mat4{}, light->position);
-			glm::mat4 scale = glm::scale(glm::mat4{}, glm::vec3(light->radius));
-			model = translate * scale;
-
-			m_pointLightShader.SetUniform("model", model);
-			m_pointLightShader.SetUniform("lightPos", light->position);
-			m_pointLightShader.SetUniform("lightRadius", light->radius);
-			m_pointLightShader.SetUniform("lightColor", glm::normalize(light->color) * light->intensity);
-
-			RenderMesh(&m_sphere);
-		}
+		// one volume per light uploaded by LightCluster (already culled against camera)
+		RenderMeshInstances(&m_sphere, LightCluster::NumLights());
 
 		m_pointLightShader.Unbind();
 
@@ -208,52 +228,51 @@ namespace xengine
 		OglStatus::SetDepthTest(GL_TRUE);
 	}
 
-	void DeferredRenderer::RenderAmbientLight(const CubeMap & irradiance, const CubeMap & reflection, const Texture & ao, const Texture & brdflut)
+	void DeferredRenderer::RenderResolve(const std::vector<ParallelLight*>& lights, const CubeMap & irradiance, const CubeMap & reflection, const Texture & ao, const Texture & brdflut, const Texture & last_frame)
 	{
-		GetTexPosition().Bind(0); // gPositionMetallic
-		GetTexNormal().Bind(1); // gNormalRoughness
-		GetTexAlbedo().Bind(2); // gAlbedoAO
+		GetTexPosition().Bind(0); // gPosition
+		GetTexNormal().Bind(1); // gNormal
+		GetTexAlbedo().Bind(2); // gAlbedo
 		GetTexPbrParam().Bind(3); // gPbrParam
 		if (irradiance) irradiance.Bind(4); // envIrradiance
 		if (reflection) reflection.Bind(5); // envReflection
 		brdflut.Bind(6); // BRDFLUT
 		ao.Bind(7); // TexSSAO
+		last_frame.Bind(8); // LastImage
 
-		OglStatus::SetDepthTest(GL_FALSE);
-		OglStatus::SetBlend(GL_TRUE);
-		OglStatus::SetBlendFunc(GL_ONE, GL_ONE);
-
-		m_ambientLightShader.Bind();
-		m_ambientLightShader.SetUniform("UseSSAO", RenderConfig::UseSSAO());
+		unsigned int numLights = lights.size() < kMaxResolveLights ? static_cast<unsigned int>(lights.size()) : kMaxResolveLights;
 
-		RenderMesh(&m_quad);
-
-		m_ambientLightShader.Unbind();
+		std::vector<glm::vec3> directions(kMaxResolveLights);
+		std::vector<glm::vec3> colors(kMaxResolveLights);
+		std::vector<glm::mat4> viewProjs(kMaxResolveLights);
 
-		OglStatus::SetBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-		OglStatus::SetBlend(GL_FALSE);
-		OglStatus::SetDepthTest(GL_TRUE);
-	}
+		for (unsigned int i = 0; i < numLights; ++i)
+		{
+			ParallelShadow& shadow = lights[i]->shadow;
+			shadow.GetFrameBuffer()->GetDepthStencilAttachment(0).Bind(9 + i); // lightShadowMap[i]
 
-	void DeferredRenderer::RenderReflectLight(const Texture & last_frame)
-	{
-		GetTexPosition().Bind(0); // gPositionMetallic
-		GetTexNormal().Bind(1); // gNormalRoughness
-		GetTexPbrParam().Bind(2); // gPbrParam
-		last_frame.Bind(3); // LastImage
+			directions[i] = lights[i]->direction;
+			colors[i] = glm::normalize(lights[i]->color) * lights[i]->intensity;
+			viewProjs[i] = shadow.GetViewProj();
+		}
 
+		// writes the whole lighting result, nothing to blend with
 		OglStatus::SetDepthTest(GL_FALSE);
-		OglStatus::SetBlend(GL_TRUE);
-		OglStatus::SetBlendFunc(GL_ONE, GL_ONE);
 
-		m_reflectLightShader.Bind();
+		m_resolveShader.Bind();
+		m_resolveShader.SetUniform("UseParallelShadow", RenderConfig::UseParallelShadow());
+		m_resolveShader.SetUniform("UseSSAO", RenderConfig::UseSSAO());
+		m_resolveShader.SetUniform("UseSSR", RenderConfig::UseSSR());
+		m_resolveShader.SetUniform("UseClusteredLights", RenderConfig::UseClusteredLights());
+		m_resolveShader.SetUniform("numParallelLights", static_cast<int>(numLights));
+		m_resolveShader.SetUniform(kLightDir, kMaxResolveLights, directions);
+		m_resolveShader.SetUniform(kLightColor, kMaxResolveLights, colors);
+		m_resolveShader.SetUniform(kLightShadowViewProjection, kMaxResolveLights, viewProjs);
 
 		RenderMesh(&m_quad);
 
-		m_reflectLightShader.Unbind();
+		m_resolveShader.Unbind();
 
-		OglStatus::SetBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-		OglStatus::SetBlend(GL_FALSE);
 		OglStatus::SetDepthTest(GL_TRUE);
 	}
 }
\ No newline at end of file
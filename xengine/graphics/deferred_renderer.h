@@ -18,20 +18,19 @@ namespace xengine
 		// resize frame buffer
 		void Resize(unsigned int width, unsigned int height);
 
-		// render scene to get geometry information
-		void Generate(const std::vector<RenderCommand>& commands);
+		// render scene to get geometry information, stencil is set to 1 where geometry is drawn
+		void Generate(const RenderCommandList& commands);
 
 		// render deferred parallel lights
 		void RenderParallelLights(const std::vector<ParallelLight*>& lights, Camera* camera, const Texture & ao);
 
-		// render deferred volumn point lights
-		void RenderPointLights(const std::vector<PointLight*>& lights, Camera* camera);
+		// render deferred volumn point lights in one instanced draw (lights must be uploaded by LightCluster beforehand)
+		void RenderPointLights();
 
-		// render deferred ambient light (Image-based lighting environment)
-		void RenderAmbientLight(const CubeMap & irradiance, const CubeMap & reflection, const Texture & ao, const Texture & brdflut);
-
-		// render reflect light (Screen-space reflection)
-		void RenderReflectLight(const Texture & last_frame);
+		// resolve ambient light (Image-based lighting environment), first kMaxResolveLights parallel lights,
+		// clustered point lights and reflect light (Screen-space reflection) in one screen pass
+		// pixels without geometry are skipped if stencil test against g-buffer stencil is enabled by caller
+		void RenderResolve(const std::vector<ParallelLight*>& lights, const CubeMap & irradiance, const CubeMap & reflection, const Texture & ao, const Texture & brdflut, const Texture & last_frame);
 
 		inline const FrameBuffer & GetFrameBuffer() { return m_gBuffer; }
 
@@ -42,6 +41,8 @@ namespace xengine
 		inline const Texture & GetTexMotion() { return m_gBuffer.GetColorAttachment(4); }
 
 	public:
+		// parallel lights resolved by RenderResolve, the rest goes through RenderParallelLights
+		static const unsigned int kMaxResolveLights = 4;
 
 	private:
 		// related frame buffer
@@ -50,8 +51,7 @@ namespace xengine
 		// related shaders
 		Shader m_parallelLightShader; // deferred parallel light shader
 		Shader m_pointLightShader; // deferred point light shader
-		Shader m_ambientLightShader; // deferred ambient light shader
-		Shader m_reflectLightShader; // deferred reflect light shader
+		Shader m_resolveShader; // deferred ambient, parallel, clustered point and reflect light shader
 
 		// related primitives
 		Mesh m_quad; // mesh for g-buffer quad sampling (parallel light)
@@ -11,14 +11,41 @@
 #include "ogl_status.h"
 #include "render_config.h"
 #include "general_renderer.h"
+#include "instance_buffer.h"
+#include "light_cluster.h"
 
 namespace xengine
 {
+	namespace
+	{
+		// uniforms set per draw / per light
+		const UniformID kModel("model");
+		const UniformID kProjection("projection");
+		const UniformID kView("view");
+		const UniformID kVolumeRadius("volumeRadius");
+		const UniformID kUseParallelShadow("UseParallelShadow");
+
+		// per light shadow names ("lightShadowMap1", "lightShadowViewProjection1", ...), built once per light index
+		const std::string& shadowMapName(unsigned int i)
+		{
+			static std::vector<std::string> names;
+			while (names.size() <= i) names.push_back("lightShadowMap" + std::to_string(names.size() + 1));
+			return names[i];
+		}
+
+		UniformID shadowViewProjection(unsigned int i)
+		{
+			static std::vector<UniformID> ids;
+			while (ids.size() <= i) ids.push_back(UniformID("lightShadowViewProjection" + std::to_string(ids.size() + 1)));
+			return ids[i];
+		}
+	}
+
 	ForwardRenderer::ForwardRenderer()
 	{
-		m_parallelShadowShader.AttachVertexShader(ReadShaderSource("shaders/shadow_cast.vs"));
-		m_parallelShadowShader.AttachFragmentShader(ReadShaderSource("shaders/shadow_cast.fs"));
-		m_parallelShadowShader.GenerateAndLink();
+		m_parallelShadowShaderInstanced.AttachVertexShader(InsertShaderDefine(ReadShaderSource("shaders/shadow_cast.vs"), { "INSTANCED" }));
+		m_parallelShadowShaderInstanced.AttachFragmentShader(ReadShaderSource("shaders/shadow_cast.fs"));
+		m_parallelShadowShaderInstanced.GenerateAndLink();
 
 		m_volumnLightShader.AttachVertexShader(ReadShaderSource("shaders/light.vs"));
 		m_volumnLightShader.AttachFragmentShader(ReadShaderSource("shaders/light.fs"));
@@ -27,45 +54,45 @@ namespace xengine
 		m_sphere = MeshManager::LoadGlobalPrimitive("sphere", 16, 8);
 	}
 
-	void ForwardRenderer::GenerateParallelShadow(const std::vector<RenderCommand>& commands, const std::vector<ParallelLight*>& lights, Camera* camera)
+	void ForwardRenderer::GenerateParallelShadow(const RenderCommandList& commands, ParallelLight* light)
 	{
 		OglStatus::SetCullFace(GL_FRONT); // no need to render front-facing triangles
 
-		for (ParallelLight* light : lights)
-		{
-			if (!light->useShadowCast) continue;
-
-			// uncomment after implementation of cascaded shadow map
-			// before that shadow view is set at (0, 0, 0)
-			//glm::vec3 camPos = camera->GetPosition();
-			//camPos.y = 0.0f;
-			//light->UpdateShadowView(camPos); // let light follow the camera
+		// uncomment after implementation of cascaded shadow map
+		// before that shadow view is set at (0, 0, 0)
+		//glm::vec3 camPos = camera->GetPosition();
+		//camPos.y = 0.0f;
+		//light->UpdateShadowView(camPos); // let light follow the camera
 
-			ParallelShadow& shadow = light->shadow;
-			shadow.GetFrameBuffer()->Bind();
-			glViewport(0, 0, shadow.GetFrameBuffer()->Width(), shadow.GetFrameBuffer()->Height());
-			glClear(GL_DEPTH_BUFFER_BIT); // each light's framebuffer need be refreshed per frame
+		ParallelShadow& shadow = light->shadow;
+		shadow.GetFrameBuffer()->Bind();
+		glViewport(0, 0, shadow.GetFrameBuffer()->Width(), shadow.GetFrameBuffer()->Height());
+		glClear(GL_DEPTH_BUFFER_BIT); // each light's framebuffer need be refreshed per frame
 
-			m_parallelShadowShader.Bind();
-			m_parallelShadowShader.SetUniform("projection", shadow.GetProj());
-			m_parallelShadowShader.SetUniform("view", shadow.GetView());
+		InstanceBuffer::Upload(commands);
 
-			// we only care about depth info so we don't use RenderCommand(...) which is more expensive
-			for (const RenderCommand& command : commands)
-			{
-				if (!light->shadow.GetCamera()->IntersectFrustum(command.aabb)) continue;
+		m_parallelShadowShaderInstanced.Bind();
+		m_parallelShadowShaderInstanced.SetUniform(kProjection, shadow.GetProj());
+		m_parallelShadowShaderInstanced.SetUniform(kView, shadow.GetView());
 
-				m_parallelShadowShader.SetUniform("model", command.transform);
-				RenderMesh(command.mesh);
-			}
+		// commands are already culled against shadow camera
+		// we only care about depth info so we don't use RenderCommand(...) which is more expensive
+		// material does not matter here, commands sharing a mesh (or vertex format of MeshBuffer) are drawn at once
+		// transforms come from ObjectBuffer uploaded for this frame, so all shadow maps share them with G-buffer pass
+		for (const IndirectBuffer::Run& run : IndirectBuffer::Build(commands, false))
+		{
+			if (run.numDraws > 0)
+				IndirectBuffer::Draw(run);
+			else
+				RenderMeshInstanced(commands[run.first].mesh, static_cast<unsigned int>(run.first), static_cast<unsigned int>(run.count));
 		}
 
 		OglStatus::SetCullFace(GL_BACK); // restore original culling setting
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		OglStatus::BindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
-	void ForwardRenderer::SetParallelShadow(const std::vector<ParallelLight*>& lights, const std::vector<RenderCommand>& commands)
+	void ForwardRenderer::SetParallelShadow(const std::vector<ParallelLight*>& lights, const RenderCommandList& commands)
 	{
 		std::unordered_set<Shader*> shaders;
 
@@ -80,7 +107,7 @@ namespace xengine
 				{
 					// TODO: cascaded shadow map
 					// Set CSM properly (according to camera or so)
-					material->RegisterTexture("lightShadowMap" + std::to_string(i + 1), lights[i]->shadow.GetFrameBuffer()->GetDepthStencilAttachment(0));
+					material->RegisterTexture(shadowMapName(i), lights[i]->shadow.GetFrameBuffer()->GetDepthStencilAttachment(0));
 				}
 
 				// find out relevant shaders
@@ -95,49 +122,55 @@ namespace xengine
 				if (lights[i]->useShadowCast)
 				{
 					shader->Bind();
-					shader->SetUniform("UseParallelShadow", RenderConfig::UseParallelShadow());
-					shader->SetUniform("lightShadowViewProjection" + std::to_string(i + 1), lights[i]->shadow.GetViewProj());
+					shader->SetUniform(kUseParallelShadow, RenderConfig::UseParallelShadow());
+					shader->SetUniform(shadowViewProjection(i), lights[i]->shadow.GetViewProj());
 				}
 			}
 		}
 	}
 
-	void ForwardRenderer::RenderForwardCommands(const std::vector<RenderCommand>& commands)
+	void ForwardRenderer::RenderForwardCommands(const RenderCommandList& commands)
 	{
-		for (const RenderCommand& command : commands)
+		InstanceBuffer::Upload(commands);
+
+		// draw a run of commands sharing material (and mesh, or vertex format of MeshBuffer) at once
+		// Note: run is contiguous in sorted order and multi-draw keeps record order, so back-to-front order of transparent objects holds
+		// single commands go instanced as well, instanced shaders read transforms from ObjectBuffer
+		for (const IndirectBuffer::Run& run : IndirectBuffer::Build(commands))
 		{
-			Material* material = command.material;
-			Mesh * mesh = command.mesh;
+			Material* material = commands[run.first].material;
+			Shader instanced = ShaderManager::GetInstanced(material->shader);
 
-			material->shader.Bind();
-			material->shader.SetUniform("model", command.transform);
+			if (instanced)
+			{
+				if (run.numDraws > 0)
+					RenderMeshIndirect(material, instanced, run);
+				else
+					RenderMeshInstanced(commands[run.first].mesh, material, instanced, static_cast<unsigned int>(run.first), static_cast<unsigned int>(run.count));
+				continue;
+			}
 
-			RenderMesh(mesh, material);
+			// shader without instanced variant, fall back to per-draw uniforms
+			for (size_t i = run.first; i < run.first + run.count; ++i)
+			{
+				const RenderCommand& command = commands[i];
+
+				material->shader.Bind();
+				material->shader.SetUniform(kModel, command.transform.ToMat4());
+
+				RenderMesh(command.mesh, material);
+			}
 		}
 	}
 
-	void ForwardRenderer::RenderEmissionPointLights(const std::vector<PointLight*>& lights, Camera* camera, float radius)
+	void ForwardRenderer::RenderEmissionPointLights(float radius)
 	{
 		m_volumnLightShader.Bind();
+		m_volumnLightShader.SetUniform(kVolumeRadius, radius);
 
-		for (PointLight* light : lights)
-		{
-			if (!light->useVolume) continue;
-
-			float volumnRadius = radius < 0 ? light->radius : radius;
-
-			if (!camera->IntersectFrustum(light->position, volumnRadius)) continue;
-
-			glm::mat4 model;
-			glm::mat4 translate = glm::translate(glm::mat4{}, light->position);
-			glm::mat4 scale = glm::scale(glm::mat4{}, glm::vec3(volumnRadius));
-			model = translate * scale;
-
-			m_volumnLightShader.SetUniform("model", model);
-			m_volumnLightShader.SetUniform("lightColor", glm::normalize(light->color) * light->intensity * 0.25f);
-
-			RenderMesh(&m_sphere);
-		}
+		// lights were culled against camera with their radius, a smaller sphere outside of view is clipped
+		// lights without volume collapse in vertex shader
+		RenderMeshInstances(&m_sphere, LightCluster::NumLights());
 	}
 
 	void ForwardRenderer::RenderParticles(const std::vector<ParticleSystem*>& particles, Camera* camera)
@@ -17,23 +17,23 @@ namespace xengine
 		ForwardRenderer();
 
 		// generate shadow maps of all parallel lights given a scene (shadow-cast commands)
-		void GenerateParallelShadow(const std::vector<RenderCommand>& commands, const std::vector<ParallelLight*>& lights, Camera* camera);
+		void GenerateParallelShadow(const RenderCommandList& commands, ParallelLight* light);
 
-		// render emissive sphere of point lights
-		void RenderEmissionPointLights(const std::vector<PointLight*>& lights, Camera* camera, float radius = -1.0f);
+		// render emissive sphere of point lights uploaded by LightCluster in one instanced draw (light radius if radius < 0)
+		void RenderEmissionPointLights(float radius = -1.0f);
 
 	public:
 		// set shadow maps of all parallel lights to FORWARD commands
-		static void SetParallelShadow(const std::vector<ParallelLight*>& lights, const std::vector<RenderCommand>& commands);
+		static void SetParallelShadow(const std::vector<ParallelLight*>& lights, const RenderCommandList& commands);
 
 		// render a scene (forward commands)
-		static void RenderForwardCommands(const std::vector<RenderCommand>& commands);
+		static void RenderForwardCommands(const RenderCommandList& commands);
 
 		//
 		static void RenderParticles(const std::vector<ParticleSystem*>& particles, Camera* camera);
 
 	private:
-		Shader m_parallelShadowShader;
+		Shader m_parallelShadowShaderInstanced;
 		Shader m_volumnLightShader;
 
 		Mesh m_sphere;
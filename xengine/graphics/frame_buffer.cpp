@@ -6,6 +6,8 @@
 
 #include <utility/log.h>
 
+#include "ogl_status.h"
+
 namespace xengine
 {
 	////////////////////////////////////////////////////////////////
@@ -33,6 +35,7 @@ namespace xengine
 				rbo = 0;
 			}
 
+			OglStatus::ForgetFramebuffer(fbo);
 			glDeleteFramebuffers(1, &fbo);
 			fbo = 0;
 		}
@@ -68,7 +71,7 @@ namespace xengine
 
 	void FrameBuffer::Bind()
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, m_ptr->fbo);
+		OglStatus::BindFramebuffer(GL_FRAMEBUFFER, m_ptr->fbo);
 	}
 
 	void FrameBuffer::BindColorAttachment(unsigned int attachment_id, unsigned int color_id, unsigned int mipmap)
@@ -109,7 +112,7 @@ namespace xengine
 
 	void FrameBuffer::Unbind()
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		OglStatus::BindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
 	void FrameBuffer::Resize(unsigned int width, unsigned int height)
@@ -129,10 +132,10 @@ namespace xengine
 
 		if (m_ptr->rbo > 0)
 		{
-			glBindFramebuffer(GL_FRAMEBUFFER, m_ptr->fbo);
+			OglStatus::BindFramebuffer(GL_FRAMEBUFFER, m_ptr->fbo);
 			glBindRenderbuffer(GL_RENDERBUFFER, m_ptr->rbo);
-			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
-			glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_ptr->rbo);
+			glRenderbufferStorage(GL_RENDERBUFFER, m_ptr->rboFormat, width, height);
+			glFramebufferRenderbuffer(GL_FRAMEBUFFER, m_ptr->rboFormat == GL_DEPTH24_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_ptr->rbo);
 			glBindRenderbuffer(GL_RENDERBUFFER, 0);
 		}
 	}
@@ -230,7 +233,8 @@ namespace xengine
 
 		glGenRenderbuffers(1, &m_ptr->rbo);
 		glBindRenderbuffer(GL_RENDERBUFFER, m_ptr->rbo);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+		m_ptr->rboFormat = GL_DEPTH_COMPONENT24;
+		glRenderbufferStorage(GL_RENDERBUFFER, m_ptr->rboFormat, width, height);
 		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_ptr->rbo);
 		glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
@@ -293,7 +297,8 @@ namespace xengine
 
 		glGenRenderbuffers(1, &m_ptr->rbo);
 		glBindRenderbuffer(GL_RENDERBUFFER, m_ptr->rbo);
-		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+		m_ptr->rboFormat = GL_DEPTH24_STENCIL8;
+		glRenderbufferStorage(GL_RENDERBUFFER, m_ptr->rboFormat, width, height);
 		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_ptr->rbo);
 		glBindRenderbuffer(GL_RENDERBUFFER, 0);
 
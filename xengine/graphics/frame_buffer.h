@@ -23,6 +23,7 @@ namespace xengine
 		unsigned int height = 0;
 		unsigned int fbo = 0; // frame buffer object
 		unsigned int rbo = 0; // render buffer object (optional)
+		unsigned int rboFormat = 0; // internal format of render buffer
 		std::vector<Texture> colors; // color attachments
 		std::vector<Texture> depths; // depth / depth-stencil attachments
 	};
@@ -0,0 +1,62 @@
+#include "frame_sync.h"
+
+#include <glad/glad.h>
+
+#include <utility/log.h>
+
+namespace xengine
+{
+	namespace
+	{
+		// fences are polled in slices of 1 ms, giving up after a second
+		const GLuint64 kWaitSlice = 1000000;
+		const int kWaitSlices = 1000;
+	}
+
+	unsigned int FrameSync::m_region = 0;
+	unsigned long long FrameSync::m_frame = 0;
+	void* FrameSync::m_fences[FrameSync::kFrames] = {};
+
+	void FrameSync::BeginFrame()
+	{
+		++m_frame;
+		m_region = static_cast<unsigned int>(m_frame % kFrames);
+
+		GLsync fence = static_cast<GLsync>(m_fences[m_region]);
+		if (!fence) return;
+
+		// flush on first wait only, otherwise the fence may never reach the GPU
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		GLenum status = GL_TIMEOUT_EXPIRED;
+
+		for (int slice = 0; slice < kWaitSlices && status == GL_TIMEOUT_EXPIRED; ++slice)
+		{
+			status = glClientWaitSync(fence, flags, kWaitSlice);
+			flags = 0;
+		}
+
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			Log::Message("[FrameSync] Frame " + std::to_string(m_frame - kFrames) + " is still in flight, its region is reused anyway", Log::WARN);
+
+		glDeleteSync(fence);
+		m_fences[m_region] = nullptr;
+	}
+
+	void FrameSync::EndFrame()
+	{
+		if (m_fences[m_region]) glDeleteSync(static_cast<GLsync>(m_fences[m_region]));
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	void FrameSync::Clear()
+	{
+		for (void*& fence : m_fences)
+		{
+			if (fence) glDeleteSync(static_cast<GLsync>(fence));
+			fence = nullptr;
+		}
+
+		m_region = 0;
+		m_frame = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef XE_FRAME_SYNC_H
+#define XE_FRAME_SYNC_H
+
+namespace xengine
+{
+	// CPU/GPU frame pacing for ring buffers (e.g. ObjectBuffer, UniformBuffer)
+	// A ring buffer keeps kFrames regions and writes region Region() during a frame. BeginFrame waits
+	// on the fence of the frame that last wrote the same region, so the region can be written unsynchronized.
+	class FrameSync
+	{
+	public:
+		static const unsigned int kFrames = 3; // frames in flight
+
+	public:
+		// advance to next region and wait until GPU is done with it
+		static void BeginFrame();
+
+		// fence commands of current frame
+		static void EndFrame();
+
+		// region to write in current frame
+		static unsigned int Region() { return m_region; }
+
+		// number of frames begun (a region written twice within one frame is not guarded by its fence)
+		static unsigned long long Frame() { return m_frame; }
+
+		static void Clear();
+
+	private:
+		static unsigned int m_region;
+		static unsigned long long m_frame;
+		static void* m_fences[kFrames];
+	};
+}
+
+#endif // !XE_FRAME_SYNC_H
@@ -2,18 +2,24 @@
 
 #include <glad/glad.h>
 
+#include "indirect_buffer.h"
+#include "instance_buffer.h"
+#include "ogl_status.h"
+
 namespace xengine
 {
 	void RenderMesh(Mesh * mesh)
 	{
-		glBindVertexArray(mesh->VAO());
+		OglStatus::BindVertexArray(mesh->VAO());
 
-		if (mesh->IBO())
+		if (mesh->Pooled())
+			glDrawElementsBaseVertex(mesh->Topology(), mesh->NumIds(), GL_UNSIGNED_INT, (GLvoid*)(mesh->FirstIndex() * sizeof(unsigned int)), mesh->BaseVertex());
+		else if (mesh->IBO())
 			glDrawElements(mesh->Topology(), mesh->NumIds(), GL_UNSIGNED_INT, 0);
 		else
 			glDrawArrays(mesh->Topology(), 0, mesh->NumVtx());
 
-		glBindVertexArray(0);
+		// vao stays bound, the next draw of the same mesh (or pool) skips rebinding
 	}
 
 	void RenderMesh(Mesh * mesh, Material * material)
@@ -29,31 +35,106 @@ namespace xengine
 		RenderMesh(mesh);
 	}
 
+	void RenderMeshInstanced(Mesh * mesh, unsigned int first, unsigned int count)
+	{
+		OglStatus::BindVertexArray(mesh->VAO());
+
+		if (mesh->Pooled())
+		{
+			// shared vao uses vertex attrib binding, select instances by base instance instead
+			InstanceBuffer::Bind();
+			glDrawElementsInstancedBaseVertexBaseInstance(mesh->Topology(), mesh->NumIds(), GL_UNSIGNED_INT,
+				(GLvoid*)(mesh->FirstIndex() * sizeof(unsigned int)), count, mesh->BaseVertex(), first);
+			return;
+		}
+
+		InstanceBuffer::Attach(first);
+
+		if (mesh->IBO())
+			glDrawElementsInstanced(mesh->Topology(), mesh->NumIds(), GL_UNSIGNED_INT, 0, count);
+		else
+			glDrawArraysInstanced(mesh->Topology(), 0, mesh->NumVtx(), count);
+	}
+
+	void RenderMeshInstances(Mesh * mesh, unsigned int count)
+	{
+		if (count == 0) return;
+
+		OglStatus::BindVertexArray(mesh->VAO());
+
+		if (mesh->Pooled())
+			glDrawElementsInstancedBaseVertex(mesh->Topology(), mesh->NumIds(), GL_UNSIGNED_INT,
+				(GLvoid*)(mesh->FirstIndex() * sizeof(unsigned int)), count, mesh->BaseVertex());
+		else if (mesh->IBO())
+			glDrawElementsInstanced(mesh->Topology(), mesh->NumIds(), GL_UNSIGNED_INT, 0, count);
+		else
+			glDrawArraysInstanced(mesh->Topology(), 0, mesh->NumVtx(), count);
+	}
+
+	void RenderMeshInstanced(Mesh * mesh, Material * material, Shader & shader, unsigned int first, unsigned int count)
+	{
+		shader.Bind();
+
+		material->UpdateOglStatus();
+
+		material->UpdateShaderUniforms(shader);
+
+		RenderMeshInstanced(mesh, first, count);
+	}
+
+	void RenderMeshIndirect(Material * material, Shader & shader, const IndirectBuffer::Run & run)
+	{
+		shader.Bind();
+
+		material->UpdateOglStatus();
+
+		material->UpdateShaderUniforms(shader);
+
+		IndirectBuffer::Draw(run);
+	}
+
+	size_t InstanceRun(const RenderCommandList& commands, size_t first, bool sameMaterial)
+	{
+		const RenderCommand& head = commands[first];
+		size_t last = first + 1;
+
+		if (sameMaterial)
+		{
+			while (last < commands.size() && commands[last].batch == head.batch && commands[last].mesh->SameData(*head.mesh)) ++last;
+		}
+		else
+		{
+			while (last < commands.size() && commands[last].mesh->SameData(*head.mesh)) ++last;
+		}
+
+		return last - first;
+	}
+
 	void Blit(FrameBuffer * from, FrameBuffer * to, unsigned int type)
 	{
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, from->ID());
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, to->ID());
+		OglStatus::BindFramebuffer(GL_READ_FRAMEBUFFER, from->ID());
+		OglStatus::BindFramebuffer(GL_DRAW_FRAMEBUFFER, to->ID());
 		glBlitFramebuffer(0, 0, from->Width(), from->Height(), 0, 0, to->Width(), to->Height(), type, GL_NEAREST);
 	}
 
 	void Blit(const FrameBuffer & from, FrameBuffer & to, unsigned int type)
 	{
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, from.ID());
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, to.ID());
+		OglStatus::BindFramebuffer(GL_READ_FRAMEBUFFER, from.ID());
+		OglStatus::BindFramebuffer(GL_DRAW_FRAMEBUFFER, to.ID());
 		glBlitFramebuffer(0, 0, from.Width(), from.Height(), 0, 0, to.Width(), to.Height(), type, GL_NEAREST);
 	}
 
 	void Blit(FrameBuffer * from, unsigned int width, unsigned height, unsigned int type)
 	{
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, from->ID());
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		OglStatus::BindFramebuffer(GL_READ_FRAMEBUFFER, from->ID());
+		OglStatus::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 		glBlitFramebuffer(0, 0, from->Width(), from->Height(), 0, 0, width, height, type, GL_NEAREST);
 	}
 
 	void Blit(const FrameBuffer & from, unsigned int width, unsigned height, unsigned int type)
 	{
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, from.ID());
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		OglStatus::BindFramebuffer(GL_READ_FRAMEBUFFER, from.ID());
+		OglStatus::BindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 		glBlitFramebuffer(0, 0, from.Width(), from.Height(), 0, 0, width, height, type, GL_NEAREST);
 	}
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <mesh/mesh.h>
 
 #include "material.h"
+#include "indirect_buffer.h"
 #include "render_command.h"
 #include "frame_buffer.h"
 
@@ -19,6 +20,22 @@ namespace xengine
 	// render a mesh, given a material (handling shader and all corresponding uniforms, and ogl settings)
 	void RenderMesh(Mesh * mesh, Material * material);
 
+	// render count instances of a mesh, reading instances [first, first + count) of InstanceBuffer
+	void RenderMeshInstanced(Mesh * mesh, unsigned int first, unsigned int count);
+
+	// render count instances of a mesh without instance attributes (shader indexes its data by gl_InstanceID)
+	void RenderMeshInstances(Mesh * mesh, unsigned int count);
+
+	// render instances of a mesh with material applied to given shader (instanced variant of material's shader)
+	void RenderMeshInstanced(Mesh * mesh, Material * material, Shader & shader, unsigned int first, unsigned int count);
+
+	// render an indirect run of commands (see IndirectBuffer) with material applied to given shader (instanced variant)
+	void RenderMeshIndirect(Material * material, Shader & shader, const IndirectBuffer::Run & run);
+
+	// length of run of commands starting at first that can be drawn as one instanced draw
+	// sameMaterial: commands must share material state (batch), otherwise mesh only (e.g. depth pass)
+	size_t InstanceRun(const RenderCommandList& commands, size_t first, bool sameMaterial = true);
+
 	// blit data from one buffer to another (type: GL_COLOR_BUFFER_BIT, GL_DEPTH_BUFFER_BIT, etc.)
 	void Blit(FrameBuffer * from, FrameBuffer * to, unsigned int type);
 	void Blit(const FrameBuffer & from, FrameBuffer & to, unsigned int type);
@@ -0,0 +1,116 @@
+#include "indirect_buffer.h"
+
+#include <glad/glad.h>
+
+#include "general_renderer.h"
+#include "instance_buffer.h"
+#include "ogl_status.h"
+
+namespace xengine
+{
+	unsigned int IndirectBuffer::g_buffer = 0;
+	size_t IndirectBuffer::g_capacity = 0;
+	std::vector<IndirectBuffer::DrawCommand> IndirectBuffer::g_staging;
+	std::vector<IndirectBuffer::Run> IndirectBuffer::g_runs;
+
+	const std::vector<IndirectBuffer::Run>& IndirectBuffer::Build(const RenderCommandList& commands, bool sameMaterial)
+	{
+		g_runs.clear();
+		g_staging.clear();
+
+		for (size_t i = 0; i < commands.size();)
+		{
+			const RenderCommand& head = commands[i];
+			Run run = { i, 1, 0, 0, 0, 0 };
+
+			if (!head.mesh->Pooled())
+			{
+				run.count = InstanceRun(commands, i, sameMaterial);
+				g_runs.push_back(run);
+				i += run.count;
+				continue;
+			}
+
+			// any meshes of the same format (vao) go into one multi-draw
+			size_t last = i + 1;
+			while (last < commands.size())
+			{
+				const RenderCommand& command = commands[last];
+
+				if (!command.mesh->Pooled() ||
+					command.mesh->VAO() != head.mesh->VAO() ||
+					command.mesh->Topology() != head.mesh->Topology() ||
+					(sameMaterial && command.batch != head.batch))
+					break;
+
+				++last;
+			}
+
+			run.count = last - i;
+			run.vao = head.mesh->VAO();
+			run.topology = head.mesh->Topology();
+			run.offset = static_cast<unsigned int>(g_staging.size());
+
+			// consecutive commands of one mesh share a record
+			for (size_t j = i; j < last; ++j)
+			{
+				const Mesh* mesh = commands[j].mesh;
+
+				if (j > i && mesh->SameData(*commands[j - 1].mesh))
+				{
+					++g_staging.back().instanceCount;
+					continue;
+				}
+
+				DrawCommand draw;
+				draw.count = mesh->NumIds();
+				draw.instanceCount = 1;
+				draw.firstIndex = mesh->FirstIndex();
+				draw.baseVertex = static_cast<int>(mesh->BaseVertex());
+				draw.baseInstance = static_cast<unsigned int>(j);
+				g_staging.push_back(draw);
+			}
+
+			run.numDraws = static_cast<unsigned int>(g_staging.size()) - run.offset;
+			g_runs.push_back(run);
+			i = last;
+		}
+
+		if (g_staging.empty()) return g_runs;
+
+		if (!g_buffer) glGenBuffers(1, &g_buffer);
+
+		OglStatus::BindBuffer(GL_DRAW_INDIRECT_BUFFER, g_buffer);
+
+		// orphan old storage like InstanceBuffer does
+		if (g_staging.size() > g_capacity) g_capacity = g_staging.size() * 2;
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, g_capacity * sizeof(DrawCommand), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, g_staging.size() * sizeof(DrawCommand), g_staging.data());
+
+		return g_runs;
+	}
+
+	void IndirectBuffer::Draw(const Run& run)
+	{
+		OglStatus::BindVertexArray(run.vao);
+
+		InstanceBuffer::Bind();
+
+		OglStatus::BindBuffer(GL_DRAW_INDIRECT_BUFFER, g_buffer);
+		glMultiDrawElementsIndirect(run.topology, GL_UNSIGNED_INT, (GLvoid*)(run.offset * sizeof(DrawCommand)), run.numDraws, 0);
+	}
+
+	void IndirectBuffer::Clear()
+	{
+		if (g_buffer)
+		{
+			OglStatus::ForgetBuffer(g_buffer);
+			glDeleteBuffers(1, &g_buffer);
+			g_buffer = 0;
+		}
+
+		g_capacity = 0;
+		g_staging.clear();
+		g_runs.clear();
+	}
+}
\ No newline at end of file
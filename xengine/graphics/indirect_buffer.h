@@ -0,0 +1,57 @@
+#pragma once
+#ifndef XE_INDIRECT_BUFFER_H
+#define XE_INDIRECT_BUFFER_H
+
+#include <vector>
+
+#include "render_command.h"
+
+namespace xengine
+{
+	// draw records of multi-draw indirect submission of commands whose meshes live in MeshBuffer
+	// Per-draw data (transforms) is fetched from InstanceBuffer through base instance of each record.
+	class IndirectBuffer
+	{
+	public:
+		// layout of DrawElementsIndirectCommand
+		struct DrawCommand
+		{
+			unsigned int count;
+			unsigned int instanceCount;
+			unsigned int firstIndex;
+			int baseVertex;
+			unsigned int baseInstance;
+		};
+
+		// a range of commands drawn together
+		struct Run
+		{
+			size_t first; // first command of run
+			size_t count; // number of commands
+
+			// indirect runs only (numDraws == 0 otherwise: run is an instanced run of one mesh, see InstanceRun)
+			unsigned int vao;
+			unsigned int topology;
+			unsigned int offset; // first draw record
+			unsigned int numDraws;
+		};
+
+	public:
+		// split commands into runs and upload draw records of runs that can be drawn indirectly
+		// sameMaterial: same as InstanceRun; instance i of InstanceBuffer must belong to commands[i]
+		static const std::vector<Run>& Build(const RenderCommandList& commands, bool sameMaterial = true);
+
+		// submit an indirect run with current shader (which must read instance attributes)
+		static void Draw(const Run& run);
+
+		static void Clear();
+
+	private:
+		static unsigned int g_buffer;
+		static size_t g_capacity; // in draw records
+		static std::vector<DrawCommand> g_staging;
+		static std::vector<Run> g_runs;
+	};
+}
+
+#endif // !XE_INDIRECT_BUFFER_H
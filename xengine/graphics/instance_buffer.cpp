@@ -0,0 +1,57 @@
+#include "instance_buffer.h"
+
+#include <glad/glad.h>
+
+#include "ogl_status.h"
+
+namespace xengine
+{
+	unsigned int InstanceBuffer::g_vbo = 0;
+	size_t InstanceBuffer::g_capacity = 0;
+
+	void InstanceBuffer::Upload(const RenderCommandList& commands)
+	{
+		if (commands.empty()) return;
+
+		if (!g_vbo) glGenBuffers(1, &g_vbo);
+
+		OglStatus::BindBuffer(GL_ARRAY_BUFFER, g_vbo);
+
+		// orphan old storage so that draws still reading it do not stall the upload
+		// list indices are storage indices, which is where ObjectBuffer keeps the objects
+		if (commands.size() > g_capacity) g_capacity = commands.size() * 2;
+		glBufferData(GL_ARRAY_BUFFER, g_capacity * sizeof(unsigned int), nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, commands.size() * sizeof(unsigned int), commands.Indices());
+	}
+
+	void InstanceBuffer::Attach(unsigned int first)
+	{
+		OglStatus::BindBuffer(GL_ARRAY_BUFFER, g_vbo);
+
+		glEnableVertexAttribArray(kObjectLocation);
+		glVertexAttribIPointer(kObjectLocation, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (GLvoid*)(first * sizeof(unsigned int)));
+		glVertexAttribDivisor(kObjectLocation, 1);
+	}
+
+	void InstanceBuffer::Bind()
+	{
+		glEnableVertexAttribArray(kObjectLocation);
+		glVertexAttribIFormat(kObjectLocation, 1, GL_UNSIGNED_INT, 0);
+		glVertexAttribBinding(kObjectLocation, kBinding);
+
+		glVertexBindingDivisor(kBinding, 1);
+		glBindVertexBuffer(kBinding, g_vbo, 0, sizeof(unsigned int));
+	}
+
+	void InstanceBuffer::Clear()
+	{
+		if (g_vbo)
+		{
+			OglStatus::ForgetBuffer(g_vbo);
+			glDeleteBuffers(1, &g_vbo);
+			g_vbo = 0;
+		}
+
+		g_capacity = 0;
+	}
+}
\ No newline at end of file
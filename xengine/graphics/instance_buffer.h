@@ -0,0 +1,39 @@
+#pragma once
+#ifndef XE_INSTANCE_BUFFER_H
+#define XE_INSTANCE_BUFFER_H
+
+#include <cstddef>
+
+#include "render_command.h"
+
+namespace xengine
+{
+	// per-instance vertex data of instanced draws: index of the command's object in ObjectBuffer
+	// Shader layout: location 8 uint object index (see shaders/common/objects.glsl)
+	class InstanceBuffer
+	{
+	public:
+		static const unsigned int kObjectLocation = 8;
+		static const unsigned int kBinding = 1; // vertex buffer binding of vaos using vertex attrib binding
+
+	public:
+		// write object indices of all commands in list order (instance i belongs to commands[i])
+		// Note: per-object data itself is uploaded once per frame by ObjectBuffer
+		static void Upload(const RenderCommandList& commands);
+
+		// point instance attributes of currently bound vao at instances starting from first
+		static void Attach(unsigned int first);
+
+		// point instance attributes of currently bound vao (set up with vertex attrib binding, e.g. MeshBuffer)
+		// at the whole buffer, draws pick their instances by base instance
+		static void Bind();
+
+		static void Clear();
+
+	private:
+		static unsigned int g_vbo;
+		static size_t g_capacity; // in instances
+	};
+}
+
+#endif // !XE_INSTANCE_BUFFER_H
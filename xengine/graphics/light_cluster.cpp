@@ -0,0 +1,381 @@
+#include "light_cluster.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include <utility/log.h>
+#include <utility/job_system.h>
+
+#include "ogl_status.h"
+#include "frame_sync.h"
+#include "render_config.h"
+#include "shader_loader.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define XE_CLUSTER_X86
+#include <immintrin.h>
+#endif
+
+namespace xengine
+{
+	namespace
+	{
+		// work group size of culling shader (one work group per slice)
+		const unsigned int kGroupX = 16;
+		const unsigned int kGroupY = 9;
+
+		// initial capacity in lights, regions double when full
+		const size_t kBlock = 256;
+
+		struct ClusterBox { glm::vec3 min, max; };
+
+		// view-space point on the ray through ndc, at view depth
+		glm::vec3 pointAtDepth(const glm::mat4& invProjection, const glm::vec2& ndc, float depth)
+		{
+			glm::vec4 p = invProjection * glm::vec4(ndc, -1.0f, 1.0f);
+			glm::vec3 v = glm::vec3(p) / p.w;
+			return v * (depth / -v.z);
+		}
+
+		// same as shaders/deferred/deferred.cluster.cull.cs
+		ClusterBox clusterBox(const glm::mat4& invProjection, const LightCluster::Header& header, unsigned int x, unsigned int y, unsigned int z)
+		{
+			glm::vec2 grid(header.grid.x, header.grid.y);
+			glm::vec2 ndcMin = glm::vec2(x, y) / grid * 2.0f - 1.0f;
+			glm::vec2 ndcMax = glm::vec2(x + 1, y + 1) / grid * 2.0f - 1.0f;
+			float depthNear = std::exp((float(z) - header.params.y) / header.params.x);
+			float depthFar = std::exp((float(z + 1) - header.params.y) / header.params.x);
+
+			glm::vec3 p0 = pointAtDepth(invProjection, ndcMin, depthNear);
+			glm::vec3 p1 = pointAtDepth(invProjection, ndcMax, depthNear);
+			glm::vec3 p2 = pointAtDepth(invProjection, ndcMin, depthFar);
+			glm::vec3 p3 = pointAtDepth(invProjection, ndcMax, depthFar);
+
+			return { glm::min(glm::min(p0, p1), glm::min(p2, p3)), glm::max(glm::max(p0, p1), glm::max(p2, p3)) };
+		}
+
+		// lights are grouped by 4: lights[k..k+3] hold x, y, z, radius of lights k..k+3
+		unsigned int binScalar(const ClusterBox& box, const glm::vec4* lights, size_t first, size_t numLights, unsigned int* slots, unsigned int count)
+		{
+			for (size_t i = first; i < numLights && count < LightCluster::kMaxLightsPerCluster; ++i)
+			{
+				const glm::vec4* group = &lights[i & ~size_t(3)];
+				glm::vec3 center(group[0][i & 3], group[1][i & 3], group[2][i & 3]);
+				float radius = group[3][i & 3];
+
+				glm::vec3 d = center - glm::clamp(center, box.min, box.max);
+
+				if (glm::dot(d, d) <= radius * radius)
+					slots[count++] = static_cast<unsigned int>(i);
+			}
+
+			return count;
+		}
+
+#ifdef XE_CLUSTER_X86
+		// returns number of lights tested, the tail is left to scalar
+		size_t binSSE(const ClusterBox& box, const glm::vec4* lights, size_t numLights, unsigned int* slots, unsigned int& count)
+		{
+			__m128 minX = _mm_set1_ps(box.min.x), minY = _mm_set1_ps(box.min.y), minZ = _mm_set1_ps(box.min.z);
+			__m128 maxX = _mm_set1_ps(box.max.x), maxY = _mm_set1_ps(box.max.y), maxZ = _mm_set1_ps(box.max.z);
+
+			size_t k = 0;
+
+			for (; k + 4 <= numLights && count < LightCluster::kMaxLightsPerCluster; k += 4)
+			{
+				__m128 cx = _mm_loadu_ps(&lights[k + 0].x);
+				__m128 cy = _mm_loadu_ps(&lights[k + 1].x);
+				__m128 cz = _mm_loadu_ps(&lights[k + 2].x);
+				__m128 r = _mm_loadu_ps(&lights[k + 3].x);
+
+				// distance from center to closest point in box
+				__m128 dx = _mm_sub_ps(cx, _mm_min_ps(_mm_max_ps(cx, minX), maxX));
+				__m128 dy = _mm_sub_ps(cy, _mm_min_ps(_mm_max_ps(cy, minY), maxY));
+				__m128 dz = _mm_sub_ps(cz, _mm_min_ps(_mm_max_ps(cz, minZ), maxZ));
+				__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+				int mask = _mm_movemask_ps(_mm_cmple_ps(dist, _mm_mul_ps(r, r)));
+
+				for (; mask && count < LightCluster::kMaxLightsPerCluster; mask &= mask - 1)
+				{
+					unsigned int lane = 0;
+					while (!(mask & (1 << lane))) ++lane;
+					slots[count++] = static_cast<unsigned int>(k + lane);
+				}
+			}
+
+			return k;
+		}
+#endif
+	}
+
+	Shader LightCluster::g_cullShader;
+
+	unsigned int LightCluster::g_lightBuffer = 0;
+	unsigned int LightCluster::g_gridBuffer = 0;
+	unsigned int LightCluster::g_indexBuffer = 0;
+	unsigned int LightCluster::g_listBuffer = 0;
+	size_t LightCluster::g_regionSize = 0;
+	size_t LightCluster::g_listRegionSize = 0;
+	unsigned long long LightCluster::g_frame = 0;
+	unsigned long long LightCluster::g_listFrame = 0;
+	unsigned int LightCluster::g_numLights = 0;
+
+	std::vector<glm::vec4> LightCluster::g_viewLights;
+	std::vector<unsigned int> LightCluster::g_slots;
+	std::vector<unsigned int> LightCluster::g_counts;
+	std::vector<glm::uvec2> LightCluster::g_grid;
+	std::vector<unsigned int> LightCluster::g_indices;
+
+	void LightCluster::Initialize()
+	{
+		g_cullShader.AttachComputeShader(ReadShaderSource("shaders/deferred/deferred.cluster.cull.cs"));
+		g_cullShader.GenerateAndLink();
+
+		if (g_cullShader)
+		{
+			g_cullShader.Bind();
+			g_cullShader.SetUniform("maxLightsPerCluster", kMaxLightsPerCluster);
+			g_cullShader.Unbind();
+		}
+		else
+		{
+			Log::Message("[LightCluster] Culling shader unavailable, lights are binned on CPU", Log::WARN);
+		}
+
+		// cluster lists of compute path, which writes fixed slots of every cluster
+		glGenBuffers(1, &g_gridBuffer);
+		OglStatus::BindBuffer(GL_SHADER_STORAGE_BUFFER, g_gridBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, kNumClusters * sizeof(glm::uvec2), nullptr, GL_DYNAMIC_COPY);
+
+		glGenBuffers(1, &g_indexBuffer);
+		OglStatus::BindBuffer(GL_SHADER_STORAGE_BUFFER, g_indexBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, kNumClusters * kMaxLightsPerCluster * sizeof(unsigned int), nullptr, GL_DYNAMIC_COPY);
+	}
+
+	void LightCluster::Build(const std::vector<PointLight*>& lights, const Camera* camera, unsigned int width, unsigned int height)
+	{
+		if (!g_gridBuffer || width == 0 || height == 0)
+		{
+			g_numLights = 0;
+			return;
+		}
+
+		// exponential slices: slice k starts at near * (far / near)^(k / kGridZ)
+		float zNear = camera->GetNear();
+		float zFar = camera->GetFar();
+		float scale = static_cast<float>(kGridZ) / std::log(zFar / zNear);
+
+		Header header;
+		header.grid = glm::uvec4(kGridX, kGridY, kGridZ, static_cast<unsigned int>(lights.size()));
+		header.params = glm::vec4(scale, -std::log(zNear) * scale, static_cast<float>(kGridX) / width, static_cast<float>(kGridY) / height);
+
+		uploadLights(lights, header);
+
+		if (RenderConfig::UseGpuLightCulling() && g_cullShader)
+			buildGPU(header);
+		else
+			buildCPU(lights, camera, header);
+	}
+
+	void LightCluster::Clear()
+	{
+		GLuint buffers[] = { g_lightBuffer, g_gridBuffer, g_indexBuffer, g_listBuffer };
+
+		for (GLuint buffer : buffers)
+		{
+			if (!buffer) continue;
+			OglStatus::ForgetBuffer(buffer);
+			glDeleteBuffers(1, &buffer);
+		}
+
+		g_lightBuffer = 0;
+		g_gridBuffer = 0;
+		g_indexBuffer = 0;
+		g_listBuffer = 0;
+		g_regionSize = 0;
+		g_listRegionSize = 0;
+		g_frame = 0;
+		g_listFrame = 0;
+		g_numLights = 0;
+
+		g_cullShader = Shader();
+
+		g_viewLights.clear(); g_viewLights.shrink_to_fit();
+		g_slots.clear(); g_slots.shrink_to_fit();
+		g_counts.clear(); g_counts.shrink_to_fit();
+		g_grid.clear(); g_grid.shrink_to_fit();
+		g_indices.clear(); g_indices.shrink_to_fit();
+	}
+
+	void LightCluster::uploadLights(const std::vector<PointLight*>& lights, const Header& header)
+	{
+		size_t size = sizeof(Header) + lights.size() * sizeof(Light);
+
+		g_numLights = 0;
+
+		if (size > g_regionSize)
+		{
+			GLint alignment = 0;
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			if (alignment <= 0) alignment = 256;
+
+			size_t capacity = g_regionSize ? g_regionSize * 2 : sizeof(Header) + kBlock * sizeof(Light);
+			while (capacity < size) capacity *= 2;
+			g_regionSize = (capacity + alignment - 1) / alignment * alignment;
+
+			// orphaned storage stays alive for frames still reading it
+			if (!g_lightBuffer) glGenBuffers(1, &g_lightBuffer);
+			OglStatus::BindBuffer(GL_SHADER_STORAGE_BUFFER, g_lightBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, g_regionSize * FrameSync::kFrames, nullptr, GL_STREAM_DRAW);
+		}
+
+		size_t offset = FrameSync::Region() * g_regionSize;
+
+		// region is guarded by frame fences, unless it was already written (and maybe read) this frame
+		GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+		if (g_frame != FrameSync::Frame()) access |= GL_MAP_UNSYNCHRONIZED_BIT;
+		g_frame = FrameSync::Frame();
+
+		OglStatus::BindBuffer(GL_SHADER_STORAGE_BUFFER, g_lightBuffer);
+		char* data = static_cast<char*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, offset, size, access));
+
+		if (!data)
+		{
+			Log::Message("[LightCluster] Mapping region " + std::to_string(FrameSync::Region()) + " failed", Log::ERROR);
+			return;
+		}
+
+		std::memcpy(data, &header, sizeof(Header));
+		Light* dst = reinterpret_cast<Light*>(data + sizeof(Header));
+
+		for (size_t i = 0; i < lights.size(); ++i)
+		{
+			const PointLight* light = lights[i];
+			dst[i].posRadius = glm::vec4(light->position, light->radius);
+			dst[i].color = glm::vec4(glm::normalize(light->color) * light->intensity, light->useVolume ? 1.0f : 0.0f);
+		}
+
+		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+
+		g_numLights = static_cast<unsigned int>(lights.size());
+
+		OglStatus::BindBufferRange(GL_SHADER_STORAGE_BUFFER, kLightBinding, g_lightBuffer, offset, size);
+	}
+
+	void LightCluster::buildCPU(const std::vector<PointLight*>& lights, const Camera* camera, const Header& header)
+	{
+		size_t numLights = lights.size();
+		const glm::mat4& view = camera->GetView();
+		glm::mat4 invProjection = glm::inverse(camera->GetProjection());
+
+		// view-space spheres, groups of 4 as SoA (padding of last group is never tested)
+		g_viewLights.assign((numLights + 3) & ~size_t(3), glm::vec4(0.0f));
+
+		for (size_t i = 0; i < numLights; ++i)
+		{
+			glm::vec4 center = view * glm::vec4(lights[i]->position, 1.0f);
+			glm::vec4* group = &g_viewLights[i & ~size_t(3)];
+			group[0][i & 3] = center.x;
+			group[1][i & 3] = center.y;
+			group[2][i & 3] = center.z;
+			group[3][i & 3] = lights[i]->radius;
+		}
+
+		g_slots.resize(kNumClusters * kMaxLightsPerCluster);
+		g_counts.resize(kNumClusters);
+
+		// clusters are independent
+		JobSystem::ParallelFor(kNumClusters, 64, [&](size_t first, size_t last) {
+			for (size_t c = first; c < last; ++c)
+			{
+				unsigned int x = static_cast<unsigned int>(c % kGridX);
+				unsigned int y = static_cast<unsigned int>(c / kGridX % kGridY);
+				unsigned int z = static_cast<unsigned int>(c / (kGridX * kGridY));
+
+				ClusterBox box = clusterBox(invProjection, header, x, y, z);
+				unsigned int* slots = &g_slots[c * kMaxLightsPerCluster];
+				unsigned int count = 0;
+				size_t k = 0;
+
+#ifdef XE_CLUSTER_X86
+				k = binSSE(box, g_viewLights.data(), numLights, slots, count);
+#endif
+				g_counts[c] = binScalar(box, g_viewLights.data(), k, numLights, slots, count);
+			}
+		});
+
+		// compact lists (GPU path keeps fixed slots, shaders only read first index and count)
+		g_grid.resize(kNumClusters);
+		g_indices.clear();
+
+		for (unsigned int c = 0; c < kNumClusters; ++c)
+		{
+			g_grid[c] = glm::uvec2(static_cast<unsigned int>(g_indices.size()), g_counts[c]);
+			g_indices.insert(g_indices.end(), &g_slots[c * kMaxLightsPerCluster], &g_slots[c * kMaxLightsPerCluster] + g_counts[c]);
+		}
+
+		// lists go to a ring region like lights do, rewriting buffers still read by frames in flight would stall
+		GLint alignment = 0;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		if (alignment <= 0) alignment = 256;
+
+		size_t gridSize = g_grid.size() * sizeof(glm::uvec2);
+		size_t indexOffset = (gridSize + alignment - 1) / alignment * alignment;
+		size_t indexSize = std::max<size_t>(g_indices.size(), 1) * sizeof(unsigned int);
+		size_t size = indexOffset + indexSize;
+
+		if (size > g_listRegionSize)
+		{
+			size_t capacity = g_listRegionSize ? g_listRegionSize * 2 : indexOffset + kBlock * 16 * sizeof(unsigned int);
+			while (capacity < size) capacity *= 2;
+			g_listRegionSize = (capacity + alignment - 1) / alignment * alignment;
+
+			// orphaned storage stays alive for frames still reading it
+			if (!g_listBuffer) glGenBuffers(1, &g_listBuffer);
+			OglStatus::BindBuffer(GL_SHADER_STORAGE_BUFFER, g_listBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, g_listRegionSize * FrameSync::kFrames, nullptr, GL_STREAM_DRAW);
+		}
+
+		size_t offset = FrameSync::Region() * g_listRegionSize;
+
+		GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+		if (g_listFrame != FrameSync::Frame()) access |= GL_MAP_UNSYNCHRONIZED_BIT;
+		g_listFrame = FrameSync::Frame();
+
+		OglStatus::BindBuffer(GL_SHADER_STORAGE_BUFFER, g_listBuffer);
+		char* data = static_cast<char*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, offset, size, access));
+
+		if (!data)
+		{
+			Log::Message("[LightCluster] Mapping list region " + std::to_string(FrameSync::Region()) + " failed", Log::ERROR);
+			return;
+		}
+
+		std::memcpy(data, g_grid.data(), gridSize);
+		if (!g_indices.empty()) std::memcpy(data + indexOffset, g_indices.data(), g_indices.size() * sizeof(unsigned int));
+
+		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+
+		OglStatus::BindBufferRange(GL_SHADER_STORAGE_BUFFER, kGridBinding, g_listBuffer, offset, gridSize);
+		OglStatus::BindBufferRange(GL_SHADER_STORAGE_BUFFER, kIndexBinding, g_listBuffer, offset + indexOffset, indexSize);
+	}
+
+	void LightCluster::buildGPU(const Header& header)
+	{
+		OglStatus::BindBufferBase(GL_SHADER_STORAGE_BUFFER, kGridBinding, g_gridBuffer);
+		OglStatus::BindBufferBase(GL_SHADER_STORAGE_BUFFER, kIndexBinding, g_indexBuffer);
+
+		g_cullShader.Bind();
+
+		glDispatchCompute((header.grid.x + kGroupX - 1) / kGroupX, (header.grid.y + kGroupY - 1) / kGroupY, header.grid.z);
+
+		// lists are read by fragment shaders of this frame
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		g_cullShader.Unbind();
+	}
+}
\ No newline at end of file
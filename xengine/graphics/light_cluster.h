@@ -0,0 +1,93 @@
+#pragma once
+#ifndef XE_LIGHT_CLUSTER_H
+#define XE_LIGHT_CLUSTER_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <geometry/camera.h>
+
+#include "light.h"
+#include "shader.h"
+
+namespace xengine
+{
+	// clustered (froxel) point light culling
+	// View frustum is split into kGridX * kGridY screen tiles times kGridZ exponential depth slices,
+	// every cluster lists the lights whose sphere overlaps its view-space box. Lists are built by
+	// a compute shader, or on CPU (SIMD) when compute is disabled or unavailable.
+	// Uploaded lights also feed instanced light volumes (instance i draws light i).
+	// Shader side: see shaders/common/lights.glsl
+	class LightCluster
+	{
+	public:
+		static const unsigned int kGridX = 16;
+		static const unsigned int kGridY = 9;
+		static const unsigned int kGridZ = 24;
+		static const unsigned int kNumClusters = kGridX * kGridY * kGridZ;
+		static const unsigned int kMaxLightsPerCluster = 128; // excess lights of a cluster are dropped
+
+		// shader storage bindings
+		static const unsigned int kLightBinding = 1;
+		static const unsigned int kGridBinding = 2;
+		static const unsigned int kIndexBinding = 3;
+
+		struct Header
+		{
+			glm::uvec4 grid; // clusters in x, y, z, number of lights
+			glm::vec4 params; // slice scale, slice bias, tiles per pixel in x, y
+		};
+
+		struct Light
+		{
+			glm::vec4 posRadius; // world position, radius
+			glm::vec4 color; // color scaled by intensity, w: 1 if light volume is rendered
+		};
+
+	public:
+		// load culling compute shader
+		static void Initialize();
+
+		// upload lights (culled against camera beforehand) and bin them into clusters of camera
+		// viewport of width * height pixels, results stay bound for all passes of this frame
+		static void Build(const std::vector<PointLight*>& lights, const Camera* camera, unsigned int width, unsigned int height);
+
+		// number of lights uploaded in current frame
+		static unsigned int NumLights() { return g_numLights; }
+
+		static void Clear();
+
+	private:
+		// write header and lights into region of current frame and bind it to kLightBinding
+		static void uploadLights(const std::vector<PointLight*>& lights, const Header& header);
+
+		// bin lights on CPU and upload compacted cluster lists into region of current frame
+		static void buildCPU(const std::vector<PointLight*>& lights, const Camera* camera, const Header& header);
+
+		// bin lights with compute shader into fixed slots of every cluster
+		static void buildGPU(const Header& header);
+
+	private:
+		static Shader g_cullShader;
+
+		static unsigned int g_lightBuffer; // header and lights (ring of FrameSync::kFrames regions)
+		static unsigned int g_gridBuffer; // first index and count of every cluster (compute path)
+		static unsigned int g_indexBuffer; // light indices of clusters (compute path)
+		static unsigned int g_listBuffer; // grid then indices (CPU path, ring of FrameSync::kFrames regions)
+		static size_t g_regionSize; // in bytes, aligned for binding
+		static size_t g_listRegionSize;
+		static unsigned long long g_frame; // frame of last upload
+		static unsigned long long g_listFrame;
+		static unsigned int g_numLights;
+
+		// CPU binning (buffers reused across frames)
+		static std::vector<glm::vec4> g_viewLights; // view-space position, radius (SoA in groups of 4)
+		static std::vector<unsigned int> g_slots; // kMaxLightsPerCluster slots per cluster
+		static std::vector<unsigned int> g_counts;
+		static std::vector<glm::uvec2> g_grid;
+		static std::vector<unsigned int> g_indices;
+	};
+}
+
+#endif // !XE_LIGHT_CLUSTER_H
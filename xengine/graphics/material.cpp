@@ -1,10 +1,14 @@
 #include "material.h"
 
+#include <cstring>
+#include <algorithm>
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 #include <utility/log.h>
 
+#include "material_buffer.h"
 #include "ogl_status.h"
 
 namespace xengine
@@ -29,6 +33,14 @@ namespace xengine
 		bShadowRecv = true;
 	}
 
+	bool Material::OglAttribute::operator== (const OglAttribute& other) const
+	{
+		return bDepthTest == other.bDepthTest && bDepthWrite == other.bDepthWrite && eDepthFunc == other.eDepthFunc &&
+			bCull == other.bCull && eCullFace == other.eCullFace && eCullWind == other.eCullWind &&
+			bBlend == other.bBlend && eBlendSrc == other.eBlendSrc && eBlendDst == other.eBlendDst && eBlendEq == other.eBlendEq &&
+			bShadowCast == other.bShadowCast && bShadowRecv == other.bShadowRecv;
+	}
+
 	////////////////////////////////////////////////////////////////
 	// Material
 	////////////////////////////////////////////////////////////////
@@ -63,123 +75,384 @@ namespace xengine
 			texIndicesSet.insert(unit);
 
 			textureTable[name].unit = unit;
+			++layoutRevision;
 		}
 
 		textureTable[name].texture = texture;
+		++valueRevision;
+
+		if (texture.Pooled()) RegisterUniform(name + "Layer", static_cast<int>(texture.Layer()));
+	}
+
+	Material::VarTableEntry& Material::uniformEntry(const std::string& name)
+	{
+		auto it = uniformTable.find(name);
+
+		// a new name has to be resolved against shaders
+		if (it == uniformTable.end())
+		{
+			it = uniformTable.emplace(name, VarTableEntry()).first;
+			++layoutRevision;
+		}
+
+		++valueRevision;
+		return it->second;
 	}
 
 	void Material::RegisterUniform(const std::string& name, bool value)
 	{
-		uniformTable[name].type = VAR_TYPE::BOOL;
-		uniformTable[name].bVal = value;
+		VarTableEntry& entry = uniformEntry(name);
+		entry.type = VAR_TYPE::BOOL;
+		entry.bVal = value;
 	}
 
 	void Material::RegisterUniform(const std::string& name, int value)
 	{
-		uniformTable[name].type = VAR_TYPE::INT;
-		uniformTable[name].iVal = value;
+		VarTableEntry& entry = uniformEntry(name);
+		entry.type = VAR_TYPE::INT;
+		entry.iVal = value;
 	}
 
 	void Material::RegisterUniform(const std::string& name, float value)
 	{
-		uniformTable[name].type = VAR_TYPE::FLOAT;
-		uniformTable[name].fVal = value;
+		VarTableEntry& entry = uniformEntry(name);
+		entry.type = VAR_TYPE::FLOAT;
+		entry.fVal = value;
 	}
 
 	void Material::RegisterUniform(const std::string& name, const glm::vec2& value)
 	{
-		uniformTable[name].type = VAR_TYPE::VEC2;
-		uniformTable[name].vec2 = value;
+		VarTableEntry& entry = uniformEntry(name);
+		entry.type = VAR_TYPE::VEC2;
+		entry.vec2 = value;
 	}
 
 	void Material::RegisterUniform(const std::string& name, const glm::vec3& value)
 	{
-		uniformTable[name].type = VAR_TYPE::VEC3;
-		uniformTable[name].vec3 = value;
+		VarTableEntry& entry = uniformEntry(name);
+		entry.type = VAR_TYPE::VEC3;
+		entry.vec3 = value;
 	}
 
 	void Material::RegisterUniform(const std::string& name, const glm::vec4& value)
 	{
-		uniformTable[name].type = VAR_TYPE::VEC4;
-		uniformTable[name].vec4 = value;
+		VarTableEntry& entry = uniformEntry(name);
+		entry.type = VAR_TYPE::VEC4;
+		entry.vec4 = value;
 	}
 
 	void Material::RegisterUniform(const std::string& name, const glm::mat2& value)
 	{
-		uniformTable[name].type = VAR_TYPE::MAT2;
-		uniformTable[name].mat2 = value;
+		VarTableEntry& entry = uniformEntry(name);
+		entry.type = VAR_TYPE::MAT2;
+		entry.mat2 = value;
 	}
 
 	void Material::RegisterUniform(const std::string& name, const glm::mat3& value)
 	{
-		uniformTable[name].type = VAR_TYPE::MAT3;
-		uniformTable[name].mat3 = value;
+		VarTableEntry& entry = uniformEntry(name);
+		entry.type = VAR_TYPE::MAT3;
+		entry.mat3 = value;
 	}
 
 	void Material::RegisterUniform(const std::string& name, const glm::mat4& value)
 	{
-		uniformTable[name].type = VAR_TYPE::MAT4;
-		uniformTable[name].mat4 = value;
+		VarTableEntry& entry = uniformEntry(name);
+		entry.type = VAR_TYPE::MAT4;
+		entry.mat4 = value;
 	}
 
 	void Material::UpdateOglStatus()
 	{
-		OglStatus::SetDepthFunc(attribute.eDepthFunc);
-		OglStatus::SetDepthTest(attribute.bDepthTest);
+		if (stateBlock == OglStatus::kNoBlock || !(stateSource == attribute))
+		{
+			OglStatus::StateBlock block;
+			block.depthTest = attribute.bDepthTest;
+			block.depthWrite = attribute.bDepthWrite;
+			block.depthFunc = attribute.eDepthFunc;
+			block.cull = attribute.bCull;
+			block.cullFace = attribute.eCullFace;
+			block.frontFace = attribute.eCullWind;
+			block.blend = attribute.bBlend;
+			block.blendSrc = attribute.eBlendSrc;
+			block.blendDst = attribute.eBlendDst;
+			block.blendEq = attribute.eBlendEq;
+			block.polygonMode = 0; // wireframe is switched by renderer
 
-		OglStatus::SetCull(attribute.bCull);
-		OglStatus::SetCullFace(attribute.eCullFace);
+			stateBlock = OglStatus::CreateStateBlock(block);
+			stateSource = attribute;
+		}
 
-		OglStatus::SetBlend(attribute.bBlend);
-		OglStatus::SetBlendFunc(attribute.eBlendSrc, attribute.eBlendDst);
+		// only states differing from last draw reach OpenGL
+		OglStatus::ApplyStateBlock(stateBlock);
 	}
 
 	void Material::UpdateShaderUniforms()
 	{
-		shader.Bind();
+		UpdateShaderUniforms(shader);
+	}
 
-		for (const auto& mp : textureTable)
+	void Material::UpdateShaderUniforms(Shader& target)
+	{
+		target.Bind();
+
+		const ParamBlock& block = compile(target);
+
+		// sampler units are program state, set only if another assignment was set on program since
+		if (target.SamplerUnits() != block.samplerUnits)
+		{
+			for (const ParamBlock::Sampler& sampler : block.samplers)
+			{
+				if (sampler.location >= 0) glUniform1i(sampler.location, static_cast<int>(sampler.entry->unit));
+			}
+
+			target.SetSamplerUnits(block.samplerUnits);
+		}
+
+		for (const ParamBlock::Sampler& sampler : block.samplers)
 		{
-			if (!mp.second.texture) continue;
+			if (!sampler.entry->texture) continue;
 
-			mp.second.texture.Bind(mp.second.unit);
-			shader.SetUniform(mp.first, mp.second.unit);
+			if (sampler.layered)
+				sampler.entry->texture.BindArray(sampler.entry->unit);
+			else
+				sampler.entry->texture.Bind(sampler.entry->unit);
 		}
 
-		for (const auto& mp : uniformTable)
+		for (const ParamBlock::Uniform& uniform : block.uniforms)
 		{
-			switch (mp.second.type)
+			const VarTableEntry& value = *uniform.value;
+
+			switch (value.type)
 			{
 			case Material::BOOL:
-				shader.SetUniform(mp.first, mp.second.bVal);
+				glUniform1i(uniform.location, static_cast<int>(value.bVal));
 				break;
 			case Material::INT:
-				shader.SetUniform(mp.first, mp.second.iVal);
+				glUniform1i(uniform.location, value.iVal);
 				break;
 			case Material::FLOAT:
-				shader.SetUniform(mp.first, mp.second.fVal);
+				glUniform1f(uniform.location, value.fVal);
 				break;
 			case Material::VEC2:
-				shader.SetUniform(mp.first, mp.second.vec2);
+				glUniform2fv(uniform.location, 1, &value.vec2[0]);
 				break;
 			case Material::VEC3:
-				shader.SetUniform(mp.first, mp.second.vec3);
+				glUniform3fv(uniform.location, 1, &value.vec3[0]);
 				break;
 			case Material::VEC4:
-				shader.SetUniform(mp.first, mp.second.vec4);
+				glUniform4fv(uniform.location, 1, &value.vec4[0]);
 				break;
 			case Material::MAT2:
-				shader.SetUniform(mp.first, mp.second.mat2);
+				glUniformMatrix2fv(uniform.location, 1, GL_FALSE, &value.mat2[0][0]);
 				break;
 			case Material::MAT3:
-				shader.SetUniform(mp.first, mp.second.mat3);
+				glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &value.mat3[0][0]);
 				break;
 			case Material::MAT4:
-				shader.SetUniform(mp.first, mp.second.mat4);
+				glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &value.mat4[0][0]);
 				break;
 			default:
 				break;
 			}
 		}
+
+		if (block.blockSize > 0)
+			MaterialBuffer::Bind(block.blockOffset, block.blockSize);
+	}
+
+	const Material::ParamBlock& Material::compile(const Shader& target)
+	{
+		ParamBlock* block = nullptr;
+
+		for (ParamBlock& candidate : paramCache.blocks)
+		{
+			if (candidate.program == target.ID())
+			{
+				block = &candidate;
+				break;
+			}
+		}
+
+		if (!block)
+		{
+			paramCache.blocks.emplace_back();
+			block = &paramCache.blocks.back();
+			block->program = target.ID();
+		}
+
+		// resolve names into locations and block offsets (table entries do not move, so values are referenced)
+		if (block->layoutRevision != layoutRevision)
+		{
+			block->uniforms.clear();
+			block->members.clear();
+			block->samplers.clear();
+
+			const ShaderMomory::BlockTableEntry* blockInfo = target.GetUniformBlockInfo("Material");
+			unsigned int blockSize = blockInfo ? blockInfo->size : 0;
+
+			if (blockSize != block->blockSize)
+			{
+				if (block->blockSize > 0) MaterialBuffer::Free(block->blockOffset, block->blockSize);
+				block->blockOffset = blockSize > 0 ? MaterialBuffer::Allocate(blockSize) : 0;
+				block->blockSize = blockSize;
+			}
+
+			block->samplerUnits.clear();
+
+			for (const auto& mp : textureTable)
+			{
+				const ShaderMomory::VarTableEntry* info = target.GetUniformInfo(mp.first);
+				bool layered = info && info->type == GL_SAMPLER_2D_ARRAY;
+
+				if (layered && mp.second.texture && !mp.second.texture.Pooled())
+					Log::Message("[Material] Texture \"" + mp.first + "\" is sampled from a texture array but not pooled", Log::WARN);
+
+				block->samplers.push_back({ info ? static_cast<int>(info->location) : -1, &mp.first, &mp.second, layered, 0 });
+
+				if (info) block->samplerUnits.emplace_back(static_cast<int>(info->location), mp.second.unit);
+			}
+
+			// table order is arbitrary, sorted lists of equal assignments compare equal
+			std::sort(block->samplerUnits.begin(), block->samplerUnits.end());
+
+			for (const auto& mp : uniformTable)
+			{
+				const ShaderMomory::VarTableEntry* info = target.GetUniformInfo(mp.first);
+				if (!info) continue; // not used by shader
+
+				if (info->block < 0)
+					block->uniforms.push_back({ static_cast<int>(info->location), 0, &mp.second });
+				else if (blockInfo && info->block == static_cast<int>(blockInfo->index))
+					block->members.push_back({ info->offset, info->matrixStride, &mp.second });
+			}
+
+			block->layoutRevision = layoutRevision;
+			block->valueRevision = 0;
+		}
+
+		// streamed textures may have been swapped into another layer since they were registered
+		// (samplers start at revision 0, the one layer uniforms are registered with before any swap)
+		for (ParamBlock::Sampler& sampler : block->samplers)
+		{
+			const Texture& texture = sampler.entry->texture;
+			if (sampler.revision == texture.Revision()) continue;
+
+			sampler.revision = texture.Revision();
+			if (texture.Pooled()) RegisterUniform(*sampler.name + "Layer", static_cast<int>(texture.Layer()));
+		}
+
+		if (block->valueRevision != valueRevision)
+		{
+			if (block->blockSize > 0) commitBlock(*block);
+			block->valueRevision = valueRevision;
+		}
+
+		return *block;
+	}
+
+	void Material::commitBlock(ParamBlock& block)
+	{
+		std::vector<unsigned char> data(block.blockSize, 0);
+
+		for (const ParamBlock::Uniform& member : block.members)
+		{
+			const VarTableEntry& value = *member.value;
+			unsigned char* dst = &data[member.location];
+			int b = static_cast<int>(value.bVal);
+
+			// std140 members: scalars and vectors are tightly packed, matrix columns are matrixStride apart
+			switch (value.type)
+			{
+			case Material::BOOL: memcpy(dst, &b, sizeof(int)); break;
+			case Material::INT: memcpy(dst, &value.iVal, sizeof(int)); break;
+			case Material::FLOAT: memcpy(dst, &value.fVal, sizeof(float)); break;
+			case Material::VEC2: memcpy(dst, &value.vec2[0], sizeof(glm::vec2)); break;
+			case Material::VEC3: memcpy(dst, &value.vec3[0], sizeof(glm::vec3)); break;
+			case Material::VEC4: memcpy(dst, &value.vec4[0], sizeof(glm::vec4)); break;
+			case Material::MAT2: for (int c = 0; c < 2; ++c) memcpy(dst + c * member.matrixStride, &value.mat2[c][0], sizeof(glm::vec2)); break;
+			case Material::MAT3: for (int c = 0; c < 3; ++c) memcpy(dst + c * member.matrixStride, &value.mat3[c][0], sizeof(glm::vec3)); break;
+			case Material::MAT4: for (int c = 0; c < 4; ++c) memcpy(dst + c * member.matrixStride, &value.mat4[c][0], sizeof(glm::vec4)); break;
+			default: break;
+			}
+		}
+
+		MaterialBuffer::Commit(block.blockOffset, data.data(), block.blockSize);
+	}
+
+	void Material::ParamCache::Clear()
+	{
+		for (const ParamBlock& block : blocks)
+		{
+			if (block.blockSize > 0) MaterialBuffer::Free(block.blockOffset, block.blockSize);
+		}
+
+		blocks.clear();
+	}
+
+	unsigned int Material::TextureSetHash() const
+	{
+		unsigned int hash = 0;
+
+		// xor of mixed (unit, texture) pairs so that table order does not matter
+		// pooled textures count as their array, materials sharing arrays share bindings in array-sampling shaders
+		for (const auto& mp : textureTable)
+		{
+			const Texture& texture = mp.second.texture;
+			unsigned int id = texture.Pooled() ? texture.ArrayID() : texture.ID();
+			unsigned int h = id * 0x9e3779b1u + mp.second.unit;
+			h ^= h >> 16;
+			h *= 0x85ebca6bu;
+			h ^= h >> 13;
+			hash ^= h;
+		}
+
+		return hash;
+	}
+
+	bool Material::SameState(const Material& other) const
+	{
+		if (this == &other) return true;
+
+		if (type != other.type || shader.ID() != other.shader.ID()) return false;
+
+		if (!(attribute == other.attribute)) return false;
+
+		if (textureTable.size() != other.textureTable.size() || uniformTable.size() != other.uniformTable.size()) return false;
+
+		for (const auto& mp : textureTable)
+		{
+			auto it = other.textureTable.find(mp.first);
+			if (it == other.textureTable.end()) return false;
+			if (it->second.unit != mp.second.unit || it->second.texture.ID() != mp.second.texture.ID()) return false;
+		}
+
+		for (const auto& mp : uniformTable)
+		{
+			auto it = other.uniformTable.find(mp.first);
+			if (it == other.uniformTable.end() || it->second.type != mp.second.type) return false;
+
+			const VarTableEntry& x = mp.second;
+			const VarTableEntry& y = it->second;
+			bool equal = true;
+
+			// compare active union member only
+			switch (x.type)
+			{
+			case Material::BOOL: equal = x.bVal == y.bVal; break;
+			case Material::INT: equal = x.iVal == y.iVal; break;
+			case Material::FLOAT: equal = x.fVal == y.fVal; break;
+			case Material::VEC2: equal = x.vec2 == y.vec2; break;
+			case Material::VEC3: equal = x.vec3 == y.vec3; break;
+			case Material::VEC4: equal = x.vec4 == y.vec4; break;
+			case Material::MAT2: equal = x.mat2 == y.mat2; break;
+			case Material::MAT3: equal = x.mat3 == y.mat3; break;
+			case Material::MAT4: equal = x.mat4 == y.mat4; break;
+			}
+
+			if (!equal) return false;
+		}
+
+		return true;
 	}
 }
\ No newline at end of file
@@ -6,9 +6,11 @@
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <glm/glm.hpp>
 
+#include "ogl_status.h"
 #include "shader.h"
 #include "texture.h"
 
@@ -65,6 +67,8 @@ namespace xengine
 			bool bShadowRecv;
 
 			OglAttribute();
+
+			bool operator== (const OglAttribute& other) const;
 		};
 
 		struct VarTableEntry
@@ -103,11 +107,61 @@ namespace xengine
 			Texture texture;
 		};
 
+		// uniforms and textures of material resolved against one shader program
+		// built once (and again when a name is registered), replayed on every draw without lookups
+		struct ParamBlock
+		{
+			struct Uniform
+			{
+				int location; // default block uniform: location; block member: byte offset
+				int matrixStride;
+				const VarTableEntry* value;
+			};
+
+			struct Sampler
+			{
+				int location;
+				const std::string* name;
+				const TexTableEntry* entry;
+				bool layered; // sampler2DArray: texture array of pooled texture is bound, layer goes by <name>Layer
+				unsigned int revision; // texture revision layer uniform was registered with
+			};
+
+			unsigned int program = 0;
+			std::vector<std::pair<int, unsigned int>> samplerUnits; // (location, unit) of active samplers sorted on location (see Shader::SamplerUnits)
+			unsigned int layoutRevision = 0;
+			unsigned int valueRevision = 0;
+
+			std::vector<Uniform> uniforms; // set with glUniform*
+			std::vector<Uniform> members; // packed into MaterialBuffer range
+			std::vector<Sampler> samplers;
+
+			unsigned int blockOffset = 0;
+			unsigned int blockSize = 0; // 0 if shader has no Material block
+		};
+
+		// compiled blocks belong to one material object, copies start empty and compile their own
+		class ParamCache
+		{
+		public:
+			ParamCache() {}
+			ParamCache(const ParamCache&) {}
+			ParamCache& operator= (const ParamCache&) { Clear(); return *this; }
+			~ParamCache() { Clear(); }
+
+			// release buffer ranges of all blocks
+			void Clear();
+
+		public:
+			std::vector<ParamBlock> blocks;
+		};
+
 	public:
 		Material();
 		Material(const Shader& shader);
 
 		// register a texture that sent to shader before rendering (unit allocated automatically)
+		// a pooled texture also registers its layer as int uniform <name>Layer, for shaders sampling it as sampler2DArray
 		void RegisterTexture(const std::string& name, const Texture& texture);
 
 		// register a parameter that sent to shader before rendering
@@ -124,6 +178,16 @@ namespace xengine
 		// on render methods
 		void UpdateOglStatus(); // update opengl status
 		void UpdateShaderUniforms(); // flush uniforms into shader before rendering
+		void UpdateShaderUniforms(Shader& target); // flush uniforms into another shader (e.g. a variant of material shader)
+
+		// order-independent hash of bound textures (equal for materials sharing a texture set)
+		unsigned int TextureSetHash() const;
+
+		// materials render identically (same shader, settings, uniforms and textures)
+		bool SameState(const Material& other) const;
+
+		// renewed whenever a uniform or texture is registered (i.e. SameState and TextureSetHash may change)
+		inline unsigned int ValueRevision() const { return valueRevision; }
 
 		explicit operator bool() const { return shader.operator bool(); }
 
@@ -145,6 +209,27 @@ namespace xengine
 
 		// texture indices manager
 		std::unordered_set<unsigned int> texIndicesSet;
+
+		// registered names changed (blocks are resolved again) / registered values changed (blocks are repacked)
+		unsigned int layoutRevision = 1;
+		unsigned int valueRevision = 1;
+
+		// compiled parameter blocks, one per shader the material has been drawn with
+		ParamCache paramCache;
+
+		// interned state block of attribute (created again after attribute is edited)
+		unsigned int stateBlock = OglStatus::kNoBlock;
+		OglAttribute stateSource;
+
+	private:
+		// entry of a registered uniform (new entry if name is never met)
+		VarTableEntry& uniformEntry(const std::string& name);
+
+		// get parameter block of target shader, compile or refresh it if out of date
+		const ParamBlock& compile(const Shader& target);
+
+		// write values of block members to block's range
+		void commitBlock(ParamBlock& block);
 	};
 }
 
@@ -0,0 +1,100 @@
+#include "material_buffer.h"
+
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "ogl_status.h"
+
+namespace xengine
+{
+	namespace
+	{
+		// initial capacity in units, doubled when full
+		const unsigned int kBlock = 256;
+	}
+
+	unsigned int MaterialBuffer::g_ubo = 0;
+	unsigned int MaterialBuffer::g_alignment = 0;
+	RangeAllocator MaterialBuffer::g_ranges;
+
+	unsigned int MaterialBuffer::Allocate(unsigned int size)
+	{
+		if (size == 0) return kInvalid;
+
+		if (!g_ubo)
+		{
+			int alignment = 0;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			g_alignment = std::max(alignment, 16);
+
+			glGenBuffers(1, &g_ubo);
+			OglStatus::BindBuffer(GL_UNIFORM_BUFFER, g_ubo);
+			glBufferData(GL_UNIFORM_BUFFER, size_t(kBlock) * g_alignment, nullptr, GL_DYNAMIC_DRAW);
+			OglStatus::BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+			g_ranges.Clear(kBlock);
+		}
+
+		unsigned int units = (size + g_alignment - 1) / g_alignment;
+		unsigned int unit = g_ranges.Allocate(units);
+
+		if (unit == RangeAllocator::kInvalid)
+		{
+			unsigned int capacity = g_ranges.Capacity();
+			unsigned int grown = capacity * 2;
+			while (grown < capacity + units) grown *= 2;
+
+			// reallocate and keep content of existing ranges
+			unsigned int ubo = 0;
+			glGenBuffers(1, &ubo);
+			OglStatus::BindBuffer(GL_COPY_WRITE_BUFFER, ubo);
+			glBufferData(GL_COPY_WRITE_BUFFER, size_t(grown) * g_alignment, nullptr, GL_DYNAMIC_DRAW);
+			OglStatus::BindBuffer(GL_COPY_READ_BUFFER, g_ubo);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size_t(capacity) * g_alignment);
+			OglStatus::BindBuffer(GL_COPY_READ_BUFFER, 0);
+			OglStatus::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			OglStatus::ForgetBuffer(g_ubo);
+			glDeleteBuffers(1, &g_ubo);
+
+			g_ubo = ubo;
+			g_ranges.Grow(grown);
+
+			unit = g_ranges.Allocate(units);
+		}
+
+		return unit * g_alignment;
+	}
+
+	void MaterialBuffer::Free(unsigned int offset, unsigned int size)
+	{
+		// buffer may have been cleared already
+		if (!g_ubo || offset == kInvalid) return;
+
+		g_ranges.Free(offset / g_alignment, (size + g_alignment - 1) / g_alignment);
+	}
+
+	void MaterialBuffer::Commit(unsigned int offset, const void* data, unsigned int size)
+	{
+		OglStatus::BindBuffer(GL_UNIFORM_BUFFER, g_ubo);
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	}
+
+	void MaterialBuffer::Bind(unsigned int offset, unsigned int size)
+	{
+		// redundant binds (e.g. same material in a row) are filtered by OglStatus
+		OglStatus::BindBufferRange(GL_UNIFORM_BUFFER, kBinding, g_ubo, offset, size);
+	}
+
+	void MaterialBuffer::Clear()
+	{
+		if (g_ubo)
+		{
+			OglStatus::ForgetBuffer(g_ubo);
+			glDeleteBuffers(1, &g_ubo);
+			g_ubo = 0;
+		}
+
+		g_ranges.Clear();
+	}
+}
\ No newline at end of file
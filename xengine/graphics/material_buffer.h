@@ -0,0 +1,41 @@
+#pragma once
+#ifndef XE_MATERIAL_BUFFER_H
+#define XE_MATERIAL_BUFFER_H
+
+#include <utility/range_allocator.h>
+
+namespace xengine
+{
+	// one uniform buffer holding parameter blocks of all materials, each material owns a range
+	// Shader side: declare material parameters as members of
+	//     layout (std140, binding = 2) uniform Material { ... };
+	// registered uniforms found in that block are packed into the material's range instead of set one by one
+	class MaterialBuffer
+	{
+	public:
+		static const unsigned int kBinding = 2;
+		static const unsigned int kInvalid = RangeAllocator::kInvalid;
+
+	public:
+		// reserve a range of size bytes, return its byte offset (aligned for binding)
+		static unsigned int Allocate(unsigned int size);
+
+		// release a range returned by Allocate
+		static void Free(unsigned int offset, unsigned int size);
+
+		// write data to a range
+		static void Commit(unsigned int offset, const void* data, unsigned int size);
+
+		// bind a range to kBinding (skipped if already bound)
+		static void Bind(unsigned int offset, unsigned int size);
+
+		static void Clear();
+
+	private:
+		static unsigned int g_ubo;
+		static unsigned int g_alignment; // in bytes, ranges are allocated in units of it
+		static RangeAllocator g_ranges;
+	};
+}
+
+#endif // !XE_MATERIAL_BUFFER_H
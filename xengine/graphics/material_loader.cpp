@@ -23,77 +23,76 @@ namespace xengine
 		return path;
 	}
 
-	Material LoadMaterial_Impl_Assimp(aiMaterial * aMaterial, const std::string & directory, aiMesh * aMesh)
+	std::vector<MaterialTexture> ListTextures_Impl_Assimp(const aiMaterial* aMaterial, const std::string& directory)
+	{
+		struct Slot
+		{
+			aiTextureType type;
+			const char* uniform;
+			unsigned int format;
+			bool srgb;
+		};
+
+		unsigned int albedoFormat = IsAlpha_Impl_Assimp(aMaterial) ? GL_RGBA : GL_RGB;
+
+		const Slot slots[] = {
+			{ aiTextureType_DIFFUSE, "TexAlbedo", albedoFormat, true },
+			{ aiTextureType_DISPLACEMENT, "TexNormal", GL_RG, false }, // z is rebuilt in shader
+			{ aiTextureType_SPECULAR, "TexMetallic", GL_RED, false },
+			{ aiTextureType_SHININESS, "TexRoughness", GL_RED, false },
+			{ aiTextureType_AMBIENT, "TexAO", GL_RED, false },
+		};
+
+		std::vector<MaterialTexture> textures;
+
+		for (const Slot& slot : slots)
+		{
+			if (aMaterial->GetTextureCount(slot.type) == 0) continue;
+
+			aiString aPath;
+			aMaterial->GetTexture(slot.type, 0, &aPath);
+			textures.push_back({ slot.uniform, processPath(&aPath, directory), slot.format, slot.srgb });
+		}
+
+		return textures;
+	}
+
+	bool IsAlpha_Impl_Assimp(const aiMaterial* aMaterial)
 	{
-		Material material;
 		aiString aString;
 		aMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &aString);
 		std::string texDiffPath{ aString.C_Str() };
-		bool alpha = false;
 
-		if (texDiffPath.find("_alpha") != std::string::npos)
+		return texDiffPath.find("_alpha") != std::string::npos;
+	}
+
+	Material LoadMaterial(bool alpha, bool tangents, const std::vector<MaterialTexture>& textures)
+	{
+		Material material;
+
+		if (alpha)
 		{
 			material = MaterialManager::Get("alpha discard");
-			alpha = true;
 		}
 		else
 		{
-			if (aMesh->HasTangentsAndBitangents())
+			if (tangents)
 				material = MaterialManager::Get("deferred");
 			else
 				material = MaterialManager::Get("deferred no TBN");
 		}
 
-		if (aMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0)
-		{
-			aiString aPath;
-			aMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &aPath);
-			std::string filename = processPath(&aPath, directory);
-
-			Texture texture = TextureManager::LoadLocalTexture2D(filename, filename, alpha ? GL_RGBA : GL_RGB, true);
-			if (texture) material.RegisterTexture("TexAlbedo", texture);
-		}
-
-		if (aMaterial->GetTextureCount(aiTextureType_DISPLACEMENT) > 0)
-		{
-			aiString aPath;
-			aMaterial->GetTexture(aiTextureType_DISPLACEMENT, 0, &aPath);
-			std::string filename = processPath(&aPath, directory);
-
-			Texture texture = TextureManager::LoadLocalTexture2D(filename, filename, GL_RGBA, false);
-			if (texture) material.RegisterTexture("TexNormal", texture);
-		}
-
-		if (aMaterial->GetTextureCount(aiTextureType_SPECULAR) > 0)
+		for (const MaterialTexture& tex : textures)
 		{
-			aiString aPath;
-			aMaterial->GetTexture(aiTextureType_SPECULAR, 0, &aPath);
-			std::string filename = processPath(&aPath, directory);
-
-			Texture texture = TextureManager::LoadLocalTexture2D(filename, filename, GL_RGBA, false);
-			if (texture) material.RegisterTexture("TexMetallic", texture);
-		}
-
-		if (aMaterial->GetTextureCount(aiTextureType_SHININESS) > 0)
-		{
-			aiString aPath;
-			aMaterial->GetTexture(aiTextureType_SHININESS, 0, &aPath);
-			std::string filename = processPath(&aPath, directory);
-
-			Texture texture = TextureManager::LoadLocalTexture2D(filename, filename, GL_RGBA, false);
-			if (texture) material.RegisterTexture("TexRoughness", texture);
-		}
-
-		if (aMaterial->GetTextureCount(aiTextureType_AMBIENT) > 0)
-		{
-			aiString aPath;
-			aMaterial->GetTexture(aiTextureType_AMBIENT, 0, &aPath);
-			std::string filename = processPath(&aPath, directory);
-
-			Texture texture = TextureManager::LoadLocalTexture2D(filename, filename, GL_RGBA, false);
-			if (texture) material.RegisterTexture("TexAO", texture);
+			Texture texture = TextureManager::LoadLocalTexture2D(tex.path, tex.path, tex.format, tex.srgb);
+			if (texture) material.RegisterTexture(tex.uniform, texture);
 		}
 
 		return material;
 	}
+
+	Material LoadMaterial_Impl_Assimp(aiMaterial * aMaterial, const std::string & directory, aiMesh * aMesh)
+	{
+		return LoadMaterial(IsAlpha_Impl_Assimp(aMaterial), aMesh->HasTangentsAndBitangents(), ListTextures_Impl_Assimp(aMaterial, directory));
+	}
 }
\ No newline at end of file
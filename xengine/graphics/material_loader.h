@@ -2,6 +2,9 @@
 #ifndef XE_MATERIAL_LOADER_H
 #define XE_MATERIAL_LOADER_H
 
+#include <string>
+#include <vector>
+
 #include "material.h"
 
 struct aiMaterial;
@@ -10,7 +13,26 @@ struct aiMesh;
 
 namespace xengine
 {
+	// texture file referenced by a material
+	struct MaterialTexture
+	{
+		std::string uniform; // sampler it is registered to
+		std::string path; // also the texture's name in TextureManager
+		unsigned int format;
+		bool srgb;
+	};
+
+	// list textures aMaterial loads (no GL calls, any thread)
+	std::vector<MaterialTexture> ListTextures_Impl_Assimp(const aiMaterial* aMaterial, const std::string& directory);
+
+	// material is alpha tested (albedo texture named *_alpha*)
+	bool IsAlpha_Impl_Assimp(const aiMaterial* aMaterial);
+
+	// copy of the base material (alpha tested, with or without tangent space) with textures registered
+	Material LoadMaterial(bool alpha, bool tangents, const std::vector<MaterialTexture>& textures);
+
 	// API for model manager to load mesh from model file (wave-front format)
+	// textures already in TextureManager (e.g. created from images decoded in advance) are not loaded again
 	Material LoadMaterial_Impl_Assimp(aiMaterial* aMaterial, const std::string& directory, aiMesh* aMesh);
 }
 
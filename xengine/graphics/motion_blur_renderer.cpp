@@ -16,20 +16,23 @@ namespace xengine
 		m_captureShader.AttachVertexShader(ReadShaderSource("shaders/effect/effect.quad.vs"));
 		m_captureShader.AttachFragmentShader(ReadShaderSource("shaders/effect/effect.motion_blur.capture.fs"));
 		m_captureShader.GenerateAndLink();
-		m_captureShader.Bind();
-		m_captureShader.SetUniform("gPosition", 0);
-		m_captureShader.Unbind();
 
 		m_blitShader.AttachVertexShader(ReadShaderSource("shaders/effect/effect.quad.vs"));
 		m_blitShader.AttachFragmentShader(ReadShaderSource("shaders/effect/effect.motion_blur.blit.fs"));
 		m_blitShader.GenerateAndLink();
-		m_blitShader.Bind();
-		m_blitShader.SetUniform("TexSrc", 0);
-		m_blitShader.Unbind();
 
 		m_postShader.AttachVertexShader(ReadShaderSource("shaders/effect/effect.quad.vs"));
 		m_postShader.AttachFragmentShader(ReadShaderSource("shaders/effect/effect.motion_blur.post.fs"));
 		m_postShader.GenerateAndLink();
+
+		m_captureShader.Bind();
+		m_captureShader.SetUniform("gPosition", 0);
+		m_captureShader.Unbind();
+
+		m_blitShader.Bind();
+		m_blitShader.SetUniform("TexSrc", 0);
+		m_blitShader.Unbind();
+
 		m_postShader.Bind();
 		m_postShader.SetUniform("TexSrc", 0);
 		m_postShader.SetUniform("TexMotion", 1);
@@ -0,0 +1,83 @@
+#include "object_buffer.h"
+
+#include <glad/glad.h>
+
+#include <utility/log.h>
+
+#include "frame_sync.h"
+#include "ogl_status.h"
+
+namespace xengine
+{
+	namespace
+	{
+		// initial capacity in objects, regions double when full
+		const size_t kBlock = 1024;
+	}
+
+	unsigned int ObjectBuffer::g_ssbo = 0;
+	size_t ObjectBuffer::g_regionSize = 0;
+	unsigned long long ObjectBuffer::g_frame = 0;
+
+	void ObjectBuffer::Upload(const RenderCommand* commands, size_t count)
+	{
+		if (count == 0) return;
+
+		size_t size = count * sizeof(Object);
+
+		if (size > g_regionSize)
+		{
+			GLint alignment = 0;
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			if (alignment <= 0) alignment = 256;
+
+			size_t capacity = g_regionSize ? g_regionSize * 2 : kBlock * sizeof(Object);
+			while (capacity < size) capacity *= 2;
+			g_regionSize = (capacity + alignment - 1) / alignment * alignment;
+
+			// orphaned storage stays alive for frames still reading it
+			if (!g_ssbo) glGenBuffers(1, &g_ssbo);
+			OglStatus::BindBuffer(GL_SHADER_STORAGE_BUFFER, g_ssbo);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, g_regionSize * FrameSync::kFrames, nullptr, GL_STREAM_DRAW);
+		}
+
+		size_t offset = FrameSync::Region() * g_regionSize;
+
+		// region is guarded by frame fences, unless it was already written (and maybe read) this frame
+		GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+		if (g_frame != FrameSync::Frame()) access |= GL_MAP_UNSYNCHRONIZED_BIT;
+		g_frame = FrameSync::Frame();
+
+		OglStatus::BindBuffer(GL_SHADER_STORAGE_BUFFER, g_ssbo);
+		Object* objects = static_cast<Object*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, offset, size, access));
+
+		if (!objects)
+		{
+			Log::Message("[ObjectBuffer] Mapping region " + std::to_string(FrameSync::Region()) + " failed", Log::ERROR);
+			return;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			objects[i].model = commands[i].transform;
+			objects[i].prevModel = commands[i].prevTrans;
+		}
+
+		glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+
+		OglStatus::BindBufferRange(GL_SHADER_STORAGE_BUFFER, kBinding, g_ssbo, offset, size);
+	}
+
+	void ObjectBuffer::Clear()
+	{
+		if (g_ssbo)
+		{
+			OglStatus::ForgetBuffer(g_ssbo);
+			glDeleteBuffers(1, &g_ssbo);
+			g_ssbo = 0;
+		}
+
+		g_regionSize = 0;
+		g_frame = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#ifndef XE_OBJECT_BUFFER_H
+#define XE_OBJECT_BUFFER_H
+
+#include <cstddef>
+
+#include <geometry/affine.h>
+
+#include "render_command.h"
+
+namespace xengine
+{
+	// per-object data of all stored commands, written once per frame and read by every pass
+	// Storage is a ring of FrameSync::kFrames regions of one shader storage buffer, a frame writes its own region.
+	// Shader side: see shaders/common/objects.glsl, object i belongs to command i of command storage
+	class ObjectBuffer
+	{
+	public:
+		static const unsigned int kBinding = 0; // shader storage binding
+
+		struct Object
+		{
+			Affine model;
+			Affine prevModel;
+		};
+
+	public:
+		// write objects of all commands into region of current frame and bind it to kBinding
+		static void Upload(const RenderCommand* commands, size_t count);
+
+		static void Clear();
+
+	private:
+		static unsigned int g_ssbo;
+		static size_t g_regionSize; // in bytes, aligned for binding
+		static unsigned long long g_frame; // frame of last upload
+	};
+}
+
+#endif // !XE_OBJECT_BUFFER_H
@@ -1,20 +1,145 @@
 #include "ogl_status.h"
 
+#include <unordered_map>
+#include <vector>
+
 #include <glad/glad.h>
 
 namespace xengine
 {
+	namespace
+	{
+		const unsigned int kUnknown = 0xffffffff;
+
+		// texture targets shadowed per unit, other targets always reach the driver
+		const unsigned int kTextureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D, GL_TEXTURE_1D };
+		const unsigned int kNumTextureTargets = sizeof(kTextureTargets) / sizeof(kTextureTargets[0]);
+
+		// generic buffer targets shadowed, element array binding belongs to the vao
+		const unsigned int kBufferTargets[] = { GL_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER, GL_DRAW_INDIRECT_BUFFER,
+			GL_DISPATCH_INDIRECT_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER };
+		const unsigned int kNumBufferTargets = sizeof(kBufferTargets) / sizeof(kBufferTargets[0]);
+
+		// gl calls a fully redundant state block would have made (polygon mode excluded)
+		const unsigned int kBlockCalls = 9;
+
+		struct TextureUnit
+		{
+			unsigned int bound[kNumTextureTargets];
+
+			TextureUnit() { for (unsigned int& id : bound) id = kUnknown; }
+		};
+
+		struct IndexedBinding
+		{
+			unsigned int buffer;
+			size_t offset;
+			size_t size; // 0 for a whole-buffer binding
+		};
+
+		std::vector<TextureUnit> g_units;
+		unsigned int g_buffers[kNumBufferTargets];
+		std::unordered_map<unsigned long long, IndexedBinding> g_indexed;
+
+		std::vector<OglStatus::StateBlock> g_blocks;
+		std::unordered_multimap<size_t, unsigned int> g_blockLookup;
+
+		int textureSlot(unsigned int target)
+		{
+			for (unsigned int i = 0; i < kNumTextureTargets; ++i)
+				if (kTextureTargets[i] == target) return i;
+			return -1;
+		}
+
+		int bufferSlot(unsigned int target)
+		{
+			for (unsigned int i = 0; i < kNumBufferTargets; ++i)
+				if (kBufferTargets[i] == target) return i;
+			return -1;
+		}
+
+		unsigned long long indexedKey(unsigned int target, unsigned int index)
+		{
+			return (static_cast<unsigned long long>(target) << 32) | index;
+		}
+
+		void hashCombine(size_t& seed, size_t value)
+		{
+			seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////
+	// State block
+	////////////////////////////////////////////////////////////////
+
+	OglStatus::StateBlock::StateBlock()
+	{
+		depthTest = true;
+		depthWrite = true;
+		depthFunc = GL_LESS;
+		cull = true;
+		cullFace = GL_BACK;
+		frontFace = GL_CCW;
+		blend = false;
+		blendSrc = GL_ONE;
+		blendDst = GL_ONE_MINUS_SRC_ALPHA;
+		blendEq = GL_FUNC_ADD;
+		polygonMode = 0;
+	}
+
+	bool OglStatus::StateBlock::operator== (const StateBlock& other) const
+	{
+		return depthTest == other.depthTest && depthWrite == other.depthWrite && depthFunc == other.depthFunc &&
+			cull == other.cull && cullFace == other.cullFace && frontFace == other.frontFace &&
+			blend == other.blend && blendSrc == other.blendSrc && blendDst == other.blendDst && blendEq == other.blendEq &&
+			polygonMode == other.polygonMode;
+	}
+
+	size_t OglStatus::StateBlock::Hash() const
+	{
+		size_t seed = (depthTest ? 1 : 0) | (depthWrite ? 2 : 0) | (cull ? 4 : 0) | (blend ? 8 : 0);
+
+		hashCombine(seed, depthFunc);
+		hashCombine(seed, cullFace);
+		hashCombine(seed, frontFace);
+		hashCombine(seed, blendSrc);
+		hashCombine(seed, blendDst);
+		hashCombine(seed, blendEq);
+		hashCombine(seed, polygonMode);
+
+		return seed;
+	}
+
+	////////////////////////////////////////////////////////////////
+	// OpenGL status
+	////////////////////////////////////////////////////////////////
+
 	bool OglStatus::m_lock = false; // switch lock
-	bool OglStatus::m_bDepthTest = GL_TRUE; // ogl toggles
-	bool OglStatus::m_bBlend = GL_FALSE;
-	bool OglStatus::m_bCull = GL_TRUE;
-	unsigned int OglStatus::m_eDepthFunc = GL_LESS; // ogl status
-	unsigned int OglStatus::m_eBlendSrc = GL_ONE;
-	unsigned int OglStatus::m_eBlendDst = GL_ONE_MINUS_SRC_ALPHA;
-	unsigned int OglStatus::m_eBlendEq = GL_FUNC_ADD;
-	unsigned int OglStatus::m_eCullFace = GL_BACK;
-	unsigned int OglStatus::m_eCullWind = GL_CCW;
-	unsigned int OglStatus::m_ePolygonMode = GL_FILL;
+	unsigned int OglStatus::m_bDepthTest = kUnknown; // ogl toggles
+	unsigned int OglStatus::m_bDepthWrite = kUnknown;
+	unsigned int OglStatus::m_bBlend = kUnknown;
+	unsigned int OglStatus::m_bCull = kUnknown;
+	unsigned int OglStatus::m_bStencilTest = kUnknown;
+	unsigned int OglStatus::m_eDepthFunc = kUnknown; // ogl status
+	unsigned int OglStatus::m_eBlendSrc = kUnknown;
+	unsigned int OglStatus::m_eBlendDst = kUnknown;
+	unsigned int OglStatus::m_eBlendEq = kUnknown;
+	unsigned int OglStatus::m_eCullFace = kUnknown;
+	unsigned int OglStatus::m_eCullWind = kUnknown;
+	unsigned int OglStatus::m_ePolygonMode = kUnknown;
+	unsigned int OglStatus::m_eStencilFunc = kUnknown;
+	unsigned int OglStatus::m_iStencilRef = kUnknown;
+	unsigned int OglStatus::m_iStencilMask = kUnknown;
+	unsigned int OglStatus::m_eStencilOp[3] = { kUnknown, kUnknown, kUnknown };
+	unsigned int OglStatus::m_block = kNoBlock; // last state block
+	unsigned int OglStatus::m_program = kUnknown; // bound objects
+	unsigned int OglStatus::m_vao = kUnknown;
+	unsigned int OglStatus::m_activeUnit = kUnknown;
+	unsigned int OglStatus::m_drawFbo = kUnknown;
+	unsigned int OglStatus::m_readFbo = kUnknown;
+	unsigned int OglStatus::m_issued = 0; // counters
+	unsigned int OglStatus::m_skipped = 0;
 	int OglStatus::m_texImgUnitMax = 0; // constants
 
 	void OglStatus::Lock()
@@ -27,11 +152,30 @@ namespace xengine
 		m_lock = false;
 	}
 
+	void OglStatus::Invalidate()
+	{
+		m_bDepthTest = m_bDepthWrite = m_bBlend = m_bCull = kUnknown;
+		m_eDepthFunc = m_eBlendSrc = m_eBlendDst = m_eBlendEq = kUnknown;
+		m_eCullFace = m_eCullWind = m_ePolygonMode = kUnknown;
+		m_bStencilTest = m_eStencilFunc = m_iStencilRef = m_iStencilMask = kUnknown;
+		m_eStencilOp[0] = m_eStencilOp[1] = m_eStencilOp[2] = kUnknown;
+		m_block = kNoBlock;
+
+		m_program = m_vao = m_activeUnit = m_drawFbo = m_readFbo = kUnknown;
+
+		g_units.assign(g_units.size(), TextureUnit());
+		for (unsigned int& id : g_buffers) id = kUnknown;
+		g_indexed.clear();
+	}
+
 	void OglStatus::SetDepthTest(bool enable)
 	{
 		if (m_lock) return;
+		if (m_bDepthTest == unsigned(enable)) { ++m_skipped; return; }
 
 		m_bDepthTest = enable;
+		m_block = kNoBlock;
+		++m_issued;
 
 		if (enable)
 			glEnable(GL_DEPTH_TEST);
@@ -39,19 +183,38 @@ namespace xengine
 			glDisable(GL_DEPTH_TEST);
 	}
 
+	void OglStatus::SetDepthWrite(bool enable)
+	{
+		if (m_lock) return;
+		if (m_bDepthWrite == unsigned(enable)) { ++m_skipped; return; }
+
+		m_bDepthWrite = enable;
+		m_block = kNoBlock;
+		++m_issued;
+
+		glDepthMask(enable ? GL_TRUE : GL_FALSE);
+	}
+
 	void OglStatus::SetDepthFunc(unsigned int func)
 	{
 		if (m_lock) return;
+		if (m_eDepthFunc == func) { ++m_skipped; return; }
 
 		m_eDepthFunc = func;
+		m_block = kNoBlock;
+		++m_issued;
+
 		glDepthFunc(func);
 	}
 
 	void OglStatus::SetBlend(bool enable)
 	{
 		if (m_lock) return;
+		if (m_bBlend == unsigned(enable)) { ++m_skipped; return; }
 
 		m_bBlend = enable;
+		m_block = kNoBlock;
+		++m_issued;
 
 		if (enable)
 			glEnable(GL_BLEND);
@@ -62,17 +225,36 @@ namespace xengine
 	void OglStatus::SetBlendFunc(unsigned int src, unsigned int dst)
 	{
 		if (m_lock) return;
+		if (m_eBlendSrc == src && m_eBlendDst == dst) { ++m_skipped; return; }
 
 		m_eBlendSrc = src;
 		m_eBlendDst = dst;
+		m_block = kNoBlock;
+		++m_issued;
+
 		glBlendFunc(src, dst);
 	}
 
+	void OglStatus::SetBlendEquation(unsigned int eq)
+	{
+		if (m_lock) return;
+		if (m_eBlendEq == eq) { ++m_skipped; return; }
+
+		m_eBlendEq = eq;
+		m_block = kNoBlock;
+		++m_issued;
+
+		glBlendEquation(eq);
+	}
+
 	void OglStatus::SetCull(bool enable)
 	{
 		if (m_lock) return;
+		if (m_bCull == unsigned(enable)) { ++m_skipped; return; }
 
 		m_bCull = enable;
+		m_block = kNoBlock;
+		++m_issued;
 
 		if (enable)
 			glEnable(GL_CULL_FACE);
@@ -83,19 +265,283 @@ namespace xengine
 	void OglStatus::SetCullFace(unsigned int face)
 	{
 		if (m_lock) return;
+		if (m_eCullFace == face) { ++m_skipped; return; }
 
 		m_eCullFace = face;
+		m_block = kNoBlock;
+		++m_issued;
+
 		glCullFace(face);
 	}
 
+	void OglStatus::SetFrontFace(unsigned int wind)
+	{
+		if (m_lock) return;
+		if (m_eCullWind == wind) { ++m_skipped; return; }
+
+		m_eCullWind = wind;
+		m_block = kNoBlock;
+		++m_issued;
+
+		glFrontFace(wind);
+	}
+
 	void OglStatus::SetPolygonMode(unsigned int mode)
 	{
 		if (m_lock) return;
+		if (m_ePolygonMode == mode) { ++m_skipped; return; }
+
+		m_ePolygonMode = mode; // blocks check polygon mode on their own
+		++m_issued;
 
-		m_ePolygonMode = mode;
 		glPolygonMode(GL_FRONT_AND_BACK, mode);
 	}
 
+	void OglStatus::SetStencilTest(bool enable)
+	{
+		if (m_lock) return;
+		if (m_bStencilTest == unsigned(enable)) { ++m_skipped; return; }
+
+		m_bStencilTest = enable;
+		++m_issued;
+
+		if (enable)
+			glEnable(GL_STENCIL_TEST);
+		else
+			glDisable(GL_STENCIL_TEST);
+	}
+
+	void OglStatus::SetStencilFunc(unsigned int func, int ref, unsigned int mask)
+	{
+		if (m_lock) return;
+		if (m_eStencilFunc == func && m_iStencilRef == unsigned(ref) && m_iStencilMask == mask) { ++m_skipped; return; }
+
+		m_eStencilFunc = func;
+		m_iStencilRef = ref;
+		m_iStencilMask = mask;
+		++m_issued;
+
+		glStencilFunc(func, ref, mask);
+	}
+
+	void OglStatus::SetStencilOp(unsigned int sfail, unsigned int dpfail, unsigned int dppass)
+	{
+		if (m_lock) return;
+		if (m_eStencilOp[0] == sfail && m_eStencilOp[1] == dpfail && m_eStencilOp[2] == dppass) { ++m_skipped; return; }
+
+		m_eStencilOp[0] = sfail;
+		m_eStencilOp[1] = dpfail;
+		m_eStencilOp[2] = dppass;
+		++m_issued;
+
+		glStencilOp(sfail, dpfail, dppass);
+	}
+
+	unsigned int OglStatus::CreateStateBlock(const StateBlock& block)
+	{
+		size_t hash = block.Hash();
+
+		auto range = g_blockLookup.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (g_blocks[it->second] == block) return it->second;
+		}
+
+		unsigned int handle = static_cast<unsigned int>(g_blocks.size());
+		g_blocks.push_back(block);
+		g_blockLookup.emplace(hash, handle);
+
+		return handle;
+	}
+
+	const OglStatus::StateBlock& OglStatus::GetStateBlock(unsigned int handle)
+	{
+		return g_blocks[handle];
+	}
+
+	void OglStatus::ApplyStateBlock(unsigned int handle)
+	{
+		if (m_lock || handle >= g_blocks.size()) return;
+		const StateBlock& block = g_blocks[handle];
+
+		if (m_block == handle && (!block.polygonMode || block.polygonMode == m_ePolygonMode)) { m_skipped += kBlockCalls + (block.polygonMode ? 1 : 0); return; }
+
+		SetDepthTest(block.depthTest);
+		SetDepthWrite(block.depthWrite);
+		SetDepthFunc(block.depthFunc);
+
+		SetCull(block.cull);
+		SetCullFace(block.cullFace);
+		SetFrontFace(block.frontFace);
+
+		SetBlend(block.blend);
+		SetBlendFunc(block.blendSrc, block.blendDst);
+		SetBlendEquation(block.blendEq);
+
+		if (block.polygonMode) SetPolygonMode(block.polygonMode);
+
+		m_block = handle;
+	}
+
+	void OglStatus::UseProgram(unsigned int program)
+	{
+		if (m_program == program) { ++m_skipped; return; }
+
+		m_program = program;
+		++m_issued;
+
+		glUseProgram(program);
+	}
+
+	void OglStatus::BindVertexArray(unsigned int vao)
+	{
+		if (m_vao == vao) { ++m_skipped; return; }
+
+		m_vao = vao;
+		++m_issued;
+
+		glBindVertexArray(vao);
+	}
+
+	void OglStatus::ActiveTexture(unsigned int unit)
+	{
+		if (m_activeUnit == unit) { ++m_skipped; return; }
+
+		m_activeUnit = unit;
+		++m_issued;
+
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+	void OglStatus::BindTexture(unsigned int target, unsigned int texture)
+	{
+		int slot = textureSlot(target);
+
+		if (slot < 0 || m_activeUnit == kUnknown)
+		{
+			if (slot >= 0) g_units.assign(g_units.size(), TextureUnit()); // can't tell which unit changed
+			++m_issued;
+			glBindTexture(target, texture);
+			return;
+		}
+
+		if (g_units.size() <= m_activeUnit) g_units.resize(m_activeUnit + 1);
+
+		unsigned int& bound = g_units[m_activeUnit].bound[slot];
+		if (bound == texture) { ++m_skipped; return; }
+
+		bound = texture;
+		++m_issued;
+
+		glBindTexture(target, texture);
+	}
+
+	void OglStatus::BindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+	{
+		// always select the unit, callers may go on editing the bound texture
+		ActiveTexture(unit);
+		BindTexture(target, texture);
+	}
+
+	void OglStatus::BindFramebuffer(unsigned int target, unsigned int fbo)
+	{
+		bool draw = target != GL_READ_FRAMEBUFFER;
+		bool read = target != GL_DRAW_FRAMEBUFFER;
+
+		if ((!draw || m_drawFbo == fbo) && (!read || m_readFbo == fbo)) { ++m_skipped; return; }
+
+		if (draw) m_drawFbo = fbo;
+		if (read) m_readFbo = fbo;
+		++m_issued;
+
+		glBindFramebuffer(target, fbo);
+	}
+
+	void OglStatus::BindBuffer(unsigned int target, unsigned int buffer)
+	{
+		int slot = bufferSlot(target);
+
+		if (slot >= 0)
+		{
+			if (g_buffers[slot] == buffer) { ++m_skipped; return; }
+			g_buffers[slot] = buffer;
+		}
+
+		++m_issued;
+
+		glBindBuffer(target, buffer);
+	}
+
+	void OglStatus::BindBufferBase(unsigned int target, unsigned int index, unsigned int buffer)
+	{
+		BindBufferRange(target, index, buffer, 0, 0);
+	}
+
+	void OglStatus::BindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, size_t offset, size_t size)
+	{
+		IndexedBinding& binding = g_indexed.emplace(indexedKey(target, index), IndexedBinding{ kUnknown, 0, 0 }).first->second;
+
+		if (binding.buffer == buffer && binding.offset == offset && binding.size == size) { ++m_skipped; return; }
+
+		binding.buffer = buffer;
+		binding.offset = offset;
+		binding.size = size;
+		++m_issued;
+
+		// indexed binds also replace the generic binding of the target
+		int slot = bufferSlot(target);
+		if (slot >= 0) g_buffers[slot] = buffer;
+
+		if (size)
+			glBindBufferRange(target, index, buffer, offset, size);
+		else
+			glBindBufferBase(target, index, buffer);
+	}
+
+	void OglStatus::ForgetProgram(unsigned int program)
+	{
+		// a deleted program stays in use until replaced, a recycled id must rebind
+		if (m_program == program) m_program = kUnknown;
+	}
+
+	void OglStatus::ForgetVertexArray(unsigned int vao)
+	{
+		if (m_vao == vao) m_vao = 0;
+	}
+
+	void OglStatus::ForgetTexture(unsigned int texture)
+	{
+		for (TextureUnit& unit : g_units)
+			for (unsigned int& id : unit.bound)
+				if (id == texture) id = 0;
+	}
+
+	void OglStatus::ForgetFramebuffer(unsigned int fbo)
+	{
+		if (m_drawFbo == fbo) m_drawFbo = 0;
+		if (m_readFbo == fbo) m_readFbo = 0;
+	}
+
+	void OglStatus::ForgetBuffer(unsigned int buffer)
+	{
+		for (unsigned int& id : g_buffers)
+			if (id == buffer) id = 0;
+
+		for (auto it = g_indexed.begin(); it != g_indexed.end();)
+		{
+			if (it->second.buffer == buffer)
+				it = g_indexed.erase(it);
+			else
+				++it;
+		}
+	}
+
+	void OglStatus::ResetCounters()
+	{
+		m_issued = 0;
+		m_skipped = 0;
+	}
+
 	int OglStatus::GetMaxTextureUnit()
 	{
 		if (m_texImgUnitMax == 0)
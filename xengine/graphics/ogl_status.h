@@ -2,32 +2,109 @@
 #ifndef XE_OGL_STATUS_H
 #define XE_OGL_STATUS_H
 
+#include <cstddef>
+
 namespace xengine
 {
+	// Shadow copy of OpenGL context state. Every setter compares against the
+	// cached value and only reaches the driver when something changes, so the
+	// cache must see every change: bind and toggle through here, not raw gl calls.
 	class OglStatus
 	{
+	public:
+		// immutable set of fixed-function states applied as a unit
+		struct StateBlock
+		{
+			// depth test
+			bool depthTest;
+			bool depthWrite;
+			unsigned int depthFunc;
+
+			// face culling
+			bool cull;
+			unsigned int cullFace;
+			unsigned int frontFace;
+
+			// blend
+			bool blend;
+			unsigned int blendSrc;
+			unsigned int blendDst;
+			unsigned int blendEq;
+
+			// rasterization (0 leaves the current mode, e.g. global wireframe)
+			unsigned int polygonMode;
+
+			StateBlock();
+
+			bool operator== (const StateBlock& other) const;
+			size_t Hash() const;
+		};
+
+		static const unsigned int kNoBlock = 0xffffffff;
+
 	public:
 		static void Lock();
 		static void Unlock();
 
+		// forget every cached value (after foreign code touched the context)
+		static void Invalidate();
+
 		static void SetDepthTest(bool enable);
+		static void SetDepthWrite(bool enable);
 		static void SetDepthFunc(unsigned int func);
 		static void SetBlend(bool enable);
 		static void SetBlendFunc(unsigned int src, unsigned int dst);
+		static void SetBlendEquation(unsigned int eq);
 		static void SetCull(bool enable);
 		static void SetCullFace(unsigned int face);
+		static void SetFrontFace(unsigned int wind);
 		static void SetPolygonMode(unsigned int mode);
 
+		// stencil (not part of state blocks, materials leave it alone)
+		static void SetStencilTest(bool enable);
+		static void SetStencilFunc(unsigned int func, int ref, unsigned int mask);
+		static void SetStencilOp(unsigned int sfail, unsigned int dpfail, unsigned int dppass);
+
+		// state blocks are interned by hash, equal blocks share one handle
+		static unsigned int CreateStateBlock(const StateBlock& block);
+		static const StateBlock& GetStateBlock(unsigned int handle);
+		static void ApplyStateBlock(unsigned int handle); // only differing states are issued
+
+		// object bindings
+		static void UseProgram(unsigned int program);
+		static void BindVertexArray(unsigned int vao);
+		static void ActiveTexture(unsigned int unit);
+		static void BindTexture(unsigned int target, unsigned int texture); // to active unit
+		static void BindTexture(unsigned int unit, unsigned int target, unsigned int texture);
+		static void BindFramebuffer(unsigned int target, unsigned int fbo);
+		static void BindBuffer(unsigned int target, unsigned int buffer);
+		static void BindBufferBase(unsigned int target, unsigned int index, unsigned int buffer);
+		static void BindBufferRange(unsigned int target, unsigned int index, unsigned int buffer, size_t offset, size_t size);
+
+		// objects about to be deleted (deletion unbinds them, ids get recycled)
+		static void ForgetProgram(unsigned int program);
+		static void ForgetVertexArray(unsigned int vao);
+		static void ForgetTexture(unsigned int texture);
+		static void ForgetFramebuffer(unsigned int fbo);
+		static void ForgetBuffer(unsigned int buffer);
+
+		// number of state/binding calls issued to or filtered from the driver
+		static unsigned int IssuedCalls() { return m_issued; }
+		static unsigned int SkippedCalls() { return m_skipped; }
+		static void ResetCounters();
+
 		static int GetMaxTextureUnit();
 
 	private:
 		// switch lock
 		static bool m_lock;
 
-		// ogl toggles
-		static bool m_bDepthTest;
-		static bool m_bBlend;
-		static bool m_bCull;
+		// ogl toggles (kUnknown until first set)
+		static unsigned int m_bDepthTest;
+		static unsigned int m_bDepthWrite;
+		static unsigned int m_bBlend;
+		static unsigned int m_bCull;
+		static unsigned int m_bStencilTest;
 
 		// ogl status
 		static unsigned int m_eDepthFunc;
@@ -37,6 +114,24 @@ namespace xengine
 		static unsigned int m_eCullFace;
 		static unsigned int m_eCullWind;
 		static unsigned int m_ePolygonMode;
+		static unsigned int m_eStencilFunc;
+		static unsigned int m_iStencilRef;
+		static unsigned int m_iStencilMask;
+		static unsigned int m_eStencilOp[3]; // sfail, dpfail, dppass
+
+		// last applied state block (cleared by any single setter)
+		static unsigned int m_block;
+
+		// bound objects
+		static unsigned int m_program;
+		static unsigned int m_vao;
+		static unsigned int m_activeUnit;
+		static unsigned int m_drawFbo;
+		static unsigned int m_readFbo;
+
+		// counters
+		static unsigned int m_issued;
+		static unsigned int m_skipped;
 
 		// constants
 		static int m_texImgUnitMax;
@@ -7,6 +7,7 @@
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
+#include "ogl_status.h"
 #include "shader_manager.h"
 #include "texture_manager.h"
 
@@ -72,8 +73,8 @@ namespace xengine
 
 		for (unsigned int i = 0; i < 2; i++)
 		{
-			glBindVertexArray(m_vaos[i]);
-			glBindBuffer(GL_ARRAY_BUFFER, m_vbos[i]);
+			OglStatus::BindVertexArray(m_vaos[i]);
+			OglStatus::BindBuffer(GL_ARRAY_BUFFER, m_vbos[i]);
 			glBufferData(GL_ARRAY_BUFFER, m_numParticle * sizeof(Particle), particles.data(), GL_DYNAMIC_DRAW);
 
 			glEnableVertexAttribArray(0);
@@ -184,12 +185,14 @@ namespace xengine
 	{
 		if (m_vaos[0])
 		{
+			for (unsigned int i = 0; i < 2; ++i) OglStatus::ForgetVertexArray(m_vaos[i]);
 			glDeleteVertexArrays(2, m_vaos);
 			m_vaos[0] = m_vaos[1] = 0;
 		}
 
 		if (m_vbos[0])
 		{
+			for (unsigned int i = 0; i < 2; ++i) OglStatus::ForgetBuffer(m_vbos[i]);
 			glDeleteBuffers(2, m_vbos);
 			m_vbos[0] = m_vbos[1] = 0;
 		}
@@ -210,7 +213,7 @@ namespace xengine
 
 		glEnable(GL_RASTERIZER_DISCARD);
 
-		glBindVertexArray(m_vaos[m_currId]);
+		OglStatus::BindVertexArray(m_vaos[m_currId]);
 		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, m_tfos[1 - m_currId]);
 
 		glBeginTransformFeedback(GL_POINTS);
@@ -228,7 +231,7 @@ namespace xengine
 		glEndTransformFeedback();
 
 		glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
-		glBindVertexArray(0);
+		OglStatus::BindVertexArray(0);
 
 		glDisable(GL_RASTERIZER_DISCARD);
 	}
@@ -239,10 +242,10 @@ namespace xengine
 
 		m_particleTexture.Bind(0); // gColorMap
 
-		glBindVertexArray(m_vaos[m_currId]);
+		OglStatus::BindVertexArray(m_vaos[m_currId]);
 
 		glDrawTransformFeedback(GL_POINTS, m_tfos[1 - m_currId]);
 
-		glBindVertexArray(0);
+		OglStatus::BindVertexArray(0);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "program_cache.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include <glad/glad.h>
+
+#include <utility/log.h>
+#include <utility/hash.h>
+#include <utility/file_system.h>
+
+namespace xengine
+{
+	bool ProgramCache::g_enabled = false;
+	std::string ProgramCache::g_directory{};
+	std::string ProgramCache::g_driver{};
+	unsigned int ProgramCache::g_hits = 0;
+	unsigned int ProgramCache::g_misses = 0;
+
+	namespace
+	{
+		// bump when file layout changes
+		const unsigned int kMagic = 0x31425058; // "XPB1"
+
+		struct FileHeader
+		{
+			unsigned int magic;
+			unsigned int format; // binary format reported by driver
+			unsigned int length; // in bytes
+			unsigned int reserved;
+			unsigned long long key; // guards against hash collisions in file names
+		};
+
+		std::string glString(unsigned int name)
+		{
+			const GLubyte* str = glGetString(name);
+			return str ? std::string(reinterpret_cast<const char*>(str)) : std::string();
+		}
+	}
+
+	void ProgramCache::Initialize(const std::string& directory)
+	{
+		int numFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+
+		if (numFormats <= 0)
+		{
+			Log::Message("[ProgramCache] Driver supports no program binary format, cache disabled", Log::WARN);
+			return;
+		}
+
+		if (!FileSystem::CreateDirectories(directory))
+		{
+			Log::Message("[ProgramCache] Cannot create cache directory \"" + directory + "\", cache disabled", Log::WARN);
+			return;
+		}
+
+		g_directory = directory;
+		g_driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+		g_enabled = true;
+
+		Log::Message("[ProgramCache] Program binaries cached in \"" + directory + "\"", Log::INFO);
+	}
+
+	unsigned long long ProgramCache::Key(const std::vector<Source>& sources)
+	{
+		unsigned long long key = hash::fnv1a64(g_driver.data(), g_driver.size());
+
+		for (const Source& source : sources)
+		{
+			key = hash::fnv1a64(&source.first, sizeof(source.first), key);
+			key = hash::fnv1a64(source.second.data(), source.second.size(), key);
+		}
+
+		return key;
+	}
+
+	bool ProgramCache::Load(unsigned int program, unsigned long long key)
+	{
+		if (!g_enabled) return false;
+
+		std::string file = path(key);
+		std::ifstream in(file, std::ios::in | std::ios::binary);
+
+		if (!in)
+		{
+			++g_misses;
+			return false;
+		}
+
+		FileHeader header{};
+		in.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		std::vector<char> binary;
+
+		// length must match the rest of the file, a damaged header never drives the allocation
+		if (in && header.magic == kMagic && header.key == key && header.length > 0)
+		{
+			std::streamoff start = in.tellg();
+			in.seekg(0, std::ios::end);
+			std::streamoff remaining = in.tellg() - start;
+			in.seekg(start);
+
+			if (remaining == static_cast<std::streamoff>(header.length))
+			{
+				binary.resize(header.length);
+				in.read(binary.data(), header.length);
+				if (in.gcount() != static_cast<std::streamsize>(header.length)) binary.clear(); // short read
+			}
+		}
+
+		in.close();
+
+		int status = 0;
+
+		if (!binary.empty())
+		{
+			glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+			glGetProgramiv(program, GL_LINK_STATUS, &status);
+		}
+
+		// stale (e.g. driver rejects binaries of a former build with the same version string) or corrupted
+		if (!status)
+		{
+			Log::Message("[ProgramCache] Cached binary \"" + file + "\" rejected, rebuilding from source", Log::WARN);
+			std::remove(file.c_str());
+			++g_misses;
+			return false;
+		}
+
+		++g_hits;
+		return true;
+	}
+
+	void ProgramCache::Store(unsigned int program, unsigned long long key)
+	{
+		if (!g_enabled) return;
+
+		int length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) return;
+
+		std::vector<char> binary(length);
+		GLenum format = 0;
+		glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+		FileHeader header{ kMagic, format, static_cast<unsigned int>(length), 0, key };
+
+		// write whole file under a temporary name, a crash never leaves a truncated binary behind
+		std::string file = path(key);
+		std::string temp = file + ".tmp";
+
+		{
+			std::ofstream out(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!out) return;
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(binary.data(), length);
+		}
+
+		std::remove(file.c_str());
+
+		if (std::rename(temp.c_str(), file.c_str()) != 0)
+		{
+			Log::Message("[ProgramCache] Cannot write \"" + file + "\"", Log::WARN);
+			std::remove(temp.c_str());
+		}
+	}
+
+	void ProgramCache::Clear()
+	{
+		if (g_enabled)
+			Log::Message("[ProgramCache] " + std::to_string(g_hits) + " programs loaded from cache, " + std::to_string(g_misses) + " compiled", Log::INFO);
+
+		g_enabled = false;
+		g_hits = 0;
+		g_misses = 0;
+	}
+
+	std::string ProgramCache::path(unsigned long long key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.bin", key);
+		return g_directory + "/" + name;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#ifndef XE_PROGRAM_CACHE_H
+#define XE_PROGRAM_CACHE_H
+
+#include <string>
+#include <vector>
+
+namespace xengine
+{
+	// on-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary)
+	// A program is keyed by a hash of its preprocessed stage sources (defines included) and the driver
+	// (vendor, renderer, version), so edited sources or a driver update miss the cache. Binaries the
+	// driver refuses are deleted and the program is compiled from source again.
+	class ProgramCache
+	{
+	public:
+		// stage type and preprocessed source of an attached shader
+		using Source = std::pair<unsigned int, std::string>;
+
+	public:
+		// open cache directory (created if missing), cache stays disabled if driver has no binary format
+		static void Initialize(const std::string& directory = "cache/programs");
+
+		// key of a program built from sources
+		static unsigned long long Key(const std::vector<Source>& sources);
+
+		// load binary of key into program, return true if program is linked
+		static bool Load(unsigned int program, unsigned long long key);
+
+		// store binary of linked program under key
+		static void Store(unsigned int program, unsigned long long key);
+
+		static bool Enabled() { return g_enabled; }
+
+		static void Clear();
+
+	private:
+		static std::string path(unsigned long long key);
+
+	private:
+		static bool g_enabled;
+		static std::string g_directory;
+		static std::string g_driver; // vendor, renderer and version strings
+
+		static unsigned int g_hits;
+		static unsigned int g_misses;
+	};
+}
+
+#endif // !XE_PROGRAM_CACHE_H
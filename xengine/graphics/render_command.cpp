@@ -2,9 +2,15 @@
 
 namespace xengine
 {
-	RenderCommand::RenderCommand() : mesh(nullptr), material(nullptr)
+	RenderCommand::RenderCommand() : mesh(nullptr), material(nullptr), key(0), batch(0), revision(0)
 	{}
 
-	RenderCommand::RenderCommand(Mesh* mesh, Material* material) : mesh(mesh), material(material)
+	RenderCommand::RenderCommand(Mesh* mesh, Material* material) : mesh(mesh), material(material), key(0), batch(0), revision(0)
+	{}
+
+	RenderProxy::RenderProxy() : node(nullptr), first(0), count(0), numChildren(0), moving(false)
+	{}
+
+	RenderProxy::RenderProxy(Model* node, unsigned int first) : node(node), first(first), count(0), numChildren(0), moving(false)
 	{}
 }
\ No newline at end of file
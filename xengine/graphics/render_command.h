@@ -3,29 +3,103 @@
 #define XE_RENDER_COMMAND_H
 
 #include <memory>
+#include <vector>
 
 #include <glm/glm.hpp>
 
 #include <geometry/aabb.h>
+#include <geometry/affine.h>
 #include <mesh/mesh.h>
 
 #include "material.h"
 
 namespace xengine
 {
+	class Model;
+
 	struct RenderCommand
 	{
 		AABB aabb;
 
-		glm::mat4 transform;
-		glm::mat4 prevTrans;
+		Affine transform;
+		Affine prevTrans;
 
 		Mesh* mesh;
 		Material* material;
 
+		// pass and render state part of sort key (see RenderCommandManager)
+		unsigned long long key;
+
+		// commands of equal batch share vao and material state (can be drawn instanced or multi-drawn indirectly)
+		unsigned int batch;
+
+		// material value revision batch and key were assigned with
+		unsigned int revision;
+
 		RenderCommand();
 		RenderCommand(Mesh* mesh, Material* material);
 	};
+
+	// read-only view of commands selected by an index list over persistent command storage
+	// Note: view is invalidated once the storage or the index list is modified
+	class RenderCommandList
+	{
+	public:
+		class Iterator
+		{
+		public:
+			Iterator(const RenderCommand* storage, const unsigned int* index) : m_storage(storage), m_index(index) {}
+
+			inline const RenderCommand& operator* () const { return m_storage[*m_index]; }
+			inline const RenderCommand* operator-> () const { return &m_storage[*m_index]; }
+			inline Iterator& operator++ () { ++m_index; return *this; }
+			inline bool operator== (const Iterator& other) const { return m_index == other.m_index; }
+			inline bool operator!= (const Iterator& other) const { return m_index != other.m_index; }
+
+		private:
+			const RenderCommand* m_storage;
+			const unsigned int* m_index;
+		};
+
+	public:
+		RenderCommandList() : m_storage(nullptr), m_indices(nullptr), m_size(0) {}
+		RenderCommandList(const std::vector<RenderCommand>& storage, const std::vector<unsigned int>& indices)
+			: m_storage(storage.data()), m_indices(indices.data()), m_size(indices.size()) {}
+
+		inline Iterator begin() const { return Iterator(m_storage, m_indices); }
+		inline Iterator end() const { return Iterator(m_storage, m_indices + m_size); }
+
+		inline const RenderCommand& operator[] (size_t i) const { return m_storage[m_indices[i]]; }
+		inline size_t size() const { return m_size; }
+		inline bool empty() const { return m_size == 0; }
+
+		// storage index of each listed command
+		inline const unsigned int* Indices() const { return m_indices; }
+
+	private:
+		const RenderCommand* m_storage;
+		const unsigned int* m_indices;
+		size_t m_size;
+	};
+
+	// persistent link between a model node and its render commands
+	struct RenderProxy
+	{
+		Model* node;
+
+		// range of node's commands in command storage
+		unsigned int first;
+		unsigned int count;
+
+		// node layout when commands were generated (detect structural change)
+		size_t numChildren;
+
+		// node transform changed last frame (prevTrans still needs a refresh)
+		bool moving;
+
+		RenderProxy();
+		RenderProxy(Model* node, unsigned int first);
+	};
 }
 
 #endif // !XE_RENDER_COMMAND_H
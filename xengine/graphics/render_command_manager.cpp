@@ -2,122 +2,348 @@
 
 #include <algorithm>
 
+#include <glm/glm.hpp>
+
 namespace xengine
 {
 	void RenderCommandManager::Clear()
 	{
+		m_commands.clear();
 		m_deferredCommands.clear();
 		m_alphaCommands.clear();
 		m_processCommands.clear();
 		m_forwardCommands.clear();
+		m_visibleForward.clear();
+		m_visibleDeferred.clear();
+		m_visibleAlpha.clear();
+		m_shadowCasters.clear();
+		m_bounds.Resize(0);
+		m_viewMasks.clear();
+		m_cullViews.clear();
+		m_culledRanges.clear();
+		m_batches.clear();
+		m_batchLookup.clear();
 	}
 
-	void RenderCommandManager::SortOnShaderIndex()
+	unsigned int RenderCommandManager::findBatch(const RenderCommand& command)
 	{
-		// deferred render
-		std::sort(
-			m_deferredCommands.begin(),
-			m_deferredCommands.end(),
-			[](const RenderCommand& a, const RenderCommand& b) {
-			return a.material->shader.ID() < b.material->shader.ID();
-		});
+		unsigned long long key = (static_cast<unsigned long long>(command.mesh->VAO()) << 32) | command.material->shader.ID();
+		std::vector<unsigned int>& candidates = m_batchLookup[key];
 
-		// custom shader
-		std::sort(
-			m_forwardCommands.begin(),
-			m_forwardCommands.end(),
-			[](const RenderCommand& a, const RenderCommand& b) {
-			return a.material->shader.ID() < b.material->shader.ID();
-		});
+		// same vao and shader, compare the rest of material state
+		for (unsigned int batch : candidates)
+		{
+			if (m_batches[batch]->SameState(*command.material))
+				return batch;
+		}
+
+		unsigned int batch = static_cast<unsigned int>(m_batches.size());
+		m_batches.push_back(command.material);
+		candidates.push_back(batch);
+
+		return batch;
 	}
 
-	void RenderCommandManager::Push(const RenderCommand& command)
+	////////////////////////////////////////////////////////////////
+	// Sort Key
+	//
+	// opaque: | pass 2 | shader 12 | texture set 10 | batch 20 | depth 20 |
+	// alpha : | pass 2 | far-to-near depth 20 | shader 12 | texture set 10 | batch 20 |
+	//
+	// The state part (pass, shader, texture set, batch) is packed into
+	// RenderCommand::key on push (and again once its material changed);
+	// quantized view depth is merged in every frame before sorting.
+	// Batch implies vao (a mesh, or a vertex format of MeshBuffer), so
+	// commands that can be instanced or multi-drawn together end up
+	// adjacent.
+	////////////////////////////////////////////////////////////////
+
+	namespace
 	{
-		if (command.material->attribute.bBlend)
+		const unsigned int kDepthBits = 20;
+		const unsigned long long kDepthMax = (1ull << kDepthBits) - 1;
+
+		enum SortPass
 		{
-			command.material->type = Material::FORWARD;
-			m_alphaCommands.push_back(command);
+			PASS_DEFERRED,
+			PASS_FORWARD,
+			PASS_ALPHA,
+			PASS_PROCESS,
+		};
+
+		unsigned long long packStateKey(const RenderCommand& command, unsigned long long pass)
+		{
+			unsigned long long shader = command.material->shader.ID() & 0xfff;
+			unsigned long long texSet = command.material->TextureSetHash() & 0x3ff;
+			unsigned long long batch = command.batch & 0xfffff;
+
+			return (pass << 42) | (shader << 30) | (texSet << 20) | batch;
 		}
-		else if (command.material->type == Material::DEFERRED)
+
+		unsigned long long quantizeDepth(const RenderCommand& command, const Camera* camera)
 		{
-			m_deferredCommands.push_back(command);
+			glm::vec3 center = (command.aabb.vmin + command.aabb.vmax) * 0.5f;
+			float depth = glm::dot(center - camera->GetPosition(), camera->GetForward());
+			float t = glm::clamp(depth / camera->GetFar(), 0.0f, 1.0f);
+
+			return static_cast<unsigned long long>(t * static_cast<float>(kDepthMax));
 		}
-		else if (command.material->type == Material::FORWARD)
+	}
+
+	void RenderCommandManager::refreshBatches()
+	{
+		bool changed = false;
+
+		for (const RenderCommand& cmd : m_commands)
 		{
-			m_forwardCommands.push_back(command);
+			if (cmd.revision != cmd.material->ValueRevision())
+			{
+				changed = true;
+				break;
+			}
 		}
-		else if (command.material->type == Material::POST_PROCESS)
+
+		if (!changed) return;
+
+		// a changed batch head affects every command of its batch, so all batches are found again
+		m_batches.clear();
+		m_batchLookup.clear();
+
+		for (RenderCommand& cmd : m_commands)
 		{
-			m_processCommands.push_back(command);
+			cmd.batch = findBatch(cmd);
+			cmd.key = packStateKey(cmd, cmd.key >> 42);
+			cmd.revision = cmd.material->ValueRevision();
 		}
 	}
 
-	std::vector<RenderCommand> RenderCommandManager::ProcessCommands()
+	void RenderCommandManager::Sort(Camera* camera)
 	{
-		return m_processCommands;
+		if (!camera) return;
+
+		refreshBatches();
+
+		JobHandle deferred = JobSystem::Submit([this, camera]() { sortOnKeys(m_deferredCommands, 0, camera, false); });
+		JobHandle forward = JobSystem::Submit([this, camera]() { sortOnKeys(m_forwardCommands, 1, camera, false); });
+
+		sortOnKeys(m_alphaCommands, 2, camera, true);
+
+		JobSystem::Wait(deferred);
+		JobSystem::Wait(forward);
 	}
 
-	std::vector<RenderCommand> RenderCommandManager::ForwardCommands(Camera* camera)
+	void RenderCommandManager::sortOnKeys(std::vector<unsigned int>& indices, unsigned int buffer, const Camera* camera, bool backToFront)
 	{
-		if (!camera) return m_forwardCommands;
-
-		std::vector<RenderCommand> commands;
+		std::vector<SortItem>& items = m_sortItems[buffer];
+		items.resize(indices.size());
 
-		for (const RenderCommand& cmd : m_forwardCommands)
+		for (size_t i = 0; i < indices.size(); ++i)
 		{
-			if (camera->IntersectFrustum(cmd.aabb))
-				commands.push_back(cmd);
+			const RenderCommand& cmd = m_commands[indices[i]];
+			unsigned long long depth = quantizeDepth(cmd, camera);
+
+			SortItem& item = items[i];
+			item.value = indices[i];
+
+			if (backToFront)
+			{
+				unsigned long long pass = cmd.key >> 42;
+				unsigned long long state = cmd.key & ((1ull << 42) - 1);
+				item.key = (pass << 62) | ((kDepthMax - depth) << 42) | state;
+			}
+			else
+			{
+				item.key = (cmd.key << kDepthBits) | depth;
+			}
 		}
 
-		return commands;
+		RadixSort(items, m_sortScratch[buffer]);
+
+		for (size_t i = 0; i < indices.size(); ++i)
+			indices[i] = items[i].value;
 	}
 
-	std::vector<RenderCommand> RenderCommandManager::DeferredCommands(Camera* camera)
+	unsigned int RenderCommandManager::Push(const RenderCommand& command)
 	{
-		if (!camera) return m_deferredCommands;
+		unsigned int index = static_cast<unsigned int>(m_commands.size());
+		m_commands.push_back(command);
+
+		RenderCommand& stored = m_commands.back();
+
+		m_bounds.Resize(m_commands.size());
+		m_bounds.Set(index, stored.aabb);
+		m_cullViews.clear(); // masks no longer cover all commands
+
+		// transparent object is always rendered forward
+		if (command.material->attribute.bBlend)
+			command.material->type = Material::FORWARD;
 
-		std::vector<RenderCommand> commands;
+		stored.batch = findBatch(stored);
+		stored.revision = command.material->ValueRevision();
 
-		for (const RenderCommand& cmd : m_deferredCommands)
+		if (command.material->attribute.bBlend)
+		{
+			m_alphaCommands.push_back(index);
+			stored.key = packStateKey(stored, PASS_ALPHA);
+		}
+		else if (command.material->type == Material::DEFERRED)
+		{
+			m_deferredCommands.push_back(index);
+			stored.key = packStateKey(stored, PASS_DEFERRED);
+		}
+		else if (command.material->type == Material::FORWARD)
+		{
+			m_forwardCommands.push_back(index);
+			stored.key = packStateKey(stored, PASS_FORWARD);
+		}
+		else if (command.material->type == Material::POST_PROCESS)
 		{
-			if (camera->IntersectFrustum(cmd.aabb))
-				commands.push_back(cmd);
+			m_processCommands.push_back(index);
+			stored.key = packStateKey(stored, PASS_PROCESS);
 		}
 
-		return commands;
+		return index;
 	}
 
-	std::vector<RenderCommand> RenderCommandManager::AlphaCommands(Camera* camera)
+	void RenderCommandManager::Cull(const std::vector<Camera*>& views)
 	{
-		if (!camera) return m_alphaCommands;
+		std::vector<std::pair<unsigned int, unsigned int>> ranges;
+		ranges.emplace_back(0, Size());
 
-		std::vector<RenderCommand> commands;
+		Cull(views, ranges);
+	}
+
+	void RenderCommandManager::Cull(const std::vector<Camera*>& views, const std::vector<std::pair<unsigned int, unsigned int>>& ranges)
+	{
+		// masks of last cull are still valid unless commands were pushed since
+		bool masksValid = !m_cullViews.empty() && m_viewMasks.size() == m_commands.size();
+
+		m_cullViews.clear();
+
+		const Frustum* frusta[FrustumCull::kMaxViews];
+
+		for (Camera* view : views)
+		{
+			if (!view || m_cullViews.size() >= FrustumCull::kMaxViews) continue;
+
+			frusta[m_cullViews.size()] = &view->GetFrustum();
+			m_cullViews.push_back(view);
+		}
+
+		// only ranges tested last time can hold set bits
+		if (masksValid)
+		{
+			for (const auto& range : m_culledRanges)
+				std::fill(m_viewMasks.begin() + range.first, m_viewMasks.begin() + range.second, 0u);
+		}
+		else
+		{
+			m_viewMasks.assign(m_commands.size(), 0u);
+		}
+
+		// large ranges are split into chunks, so they spread over parallel jobs
+		m_culledRanges.clear();
 
-		for (const RenderCommand& cmd : m_alphaCommands)
+		for (const auto& range : ranges)
 		{
-			if (camera->IntersectFrustum(cmd.aabb))
-				commands.push_back(cmd);
+			for (unsigned int first = range.first; first < range.second; first += 4096)
+				m_culledRanges.emplace_back(first, std::min(first + 4096, range.second));
 		}
 
-		return commands;
+		unsigned int numViews = static_cast<unsigned int>(m_cullViews.size());
+		unsigned int* masks = m_viewMasks.data();
+
+		JobSystem::ParallelFor(m_culledRanges.size(), 1, [&](size_t first, size_t last) {
+			for (size_t r = first; r < last; ++r)
+				FrustumCull::Cull(frusta, numViews, m_bounds, m_culledRanges[r].first, m_culledRanges[r].second, masks);
+		});
 	}
 
-	std::vector<RenderCommand> RenderCommandManager::ShadowCastCommands()
+	unsigned int RenderCommandManager::viewBit(Camera* view) const
 	{
-		std::vector<RenderCommand> commands;
-
-		for (const RenderCommand& cmd : m_deferredCommands)
+		for (size_t v = 0; v < m_cullViews.size(); ++v)
 		{
-			if (cmd.material->attribute.bShadowCast)
-				commands.push_back(cmd);
+			if (m_cullViews[v] == view)
+				return 1u << v;
 		}
 
-		for (const RenderCommand& cmd : m_forwardCommands)
+		return 0;
+	}
+
+	RenderCommandList RenderCommandManager::cullCommands(const std::vector<unsigned int>& indices, std::vector<unsigned int>& visible, Camera* camera)
+	{
+		if (!camera) return RenderCommandList(m_commands, indices);
+
+		visible.clear();
+
+		unsigned int bit = viewBit(camera);
+
+		if (bit)
 		{
-			if (cmd.material->attribute.bShadowCast)
-				commands.push_back(cmd);
+			for (unsigned int index : indices)
+			{
+				if (m_viewMasks[index] & bit)
+					visible.push_back(index);
+			}
 		}
+		else
+		{
+			for (unsigned int index : indices)
+			{
+				if (camera->IntersectFrustum(m_commands[index].aabb))
+					visible.push_back(index);
+			}
+		}
+
+		return RenderCommandList(m_commands, visible);
+	}
+
+	RenderCommandList RenderCommandManager::ProcessCommands()
+	{
+		return RenderCommandList(m_commands, m_processCommands);
+	}
+
+	RenderCommandList RenderCommandManager::ForwardCommands(Camera* camera)
+	{
+		return cullCommands(m_forwardCommands, m_visibleForward, camera);
+	}
+
+	RenderCommandList RenderCommandManager::DeferredCommands(Camera* camera)
+	{
+		return cullCommands(m_deferredCommands, m_visibleDeferred, camera);
+	}
+
+	RenderCommandList RenderCommandManager::AlphaCommands(Camera* camera)
+	{
+		return cullCommands(m_alphaCommands, m_visibleAlpha, camera);
+	}
+
+	RenderCommandList RenderCommandManager::ShadowCastCommands(Camera* view)
+	{
+		m_shadowCasters.clear();
+
+		auto gather = [this, view](const std::vector<unsigned int>& indices, unsigned int bit) {
+			for (unsigned int index : indices)
+			{
+				const RenderCommand& cmd = m_commands[index];
+
+				if (!cmd.material->attribute.bShadowCast) continue;
+
+				if (view)
+				{
+					bool visible = bit ? (m_viewMasks[index] & bit) != 0 : view->IntersectFrustum(cmd.aabb);
+					if (!visible) continue;
+				}
+
+				m_shadowCasters.push_back(index);
+			}
+		};
+
+		unsigned int bit = view ? viewBit(view) : 0;
+
+		gather(m_deferredCommands, bit);
+		gather(m_forwardCommands, bit);
 
-		return commands;
+		return RenderCommandList(m_commands, m_shadowCasters);
 	}
 }
\ No newline at end of file
@@ -9,11 +9,15 @@
 #include <glm/glm.hpp>
 
 #include <geometry/camera.h>
+#include <geometry/frustum_cull.h>
 #include <mesh/mesh.h>
 
 #include "material.h"
 #include "frame_buffer.h"
 
+#include <utility/radix_sort.h>
+#include <utility/job_system.h>
+
 #include "render_command.h"
 
 namespace xengine
@@ -23,22 +27,83 @@ namespace xengine
 	public:
 		void Clear();
 
-		void Push(const RenderCommand& command);
+		// store a command persistently, return its index in command storage
+		unsigned int Push(const RenderCommand& command);
+
+		// sort commands of each pipeline on 64-bit keys (state buckets, then view depth)
+		// batches and state keys are re-checked first if a material changed since its commands were pushed
+		// opaque commands are drawn front-to-back, transparent ones back-to-front
+		// pipelines are sorted as parallel jobs
+		void Sort(Camera* camera);
+
+		// batch cull all stored commands against all views in one pass (e.g. camera and shadow cameras)
+		// following queries with any of these views reuse the result (call once per frame)
+		// bounds are split into chunks culled by parallel jobs
+		void Cull(const std::vector<Camera*>& views);
+
+		// same as above, but only commands in ranges [first, last) are tested (e.g. commands of models found by scene queries)
+		// commands outside the ranges are invisible to all views
+		void Cull(const std::vector<Camera*>& views, const std::vector<std::pair<unsigned int, unsigned int>>& ranges);
+
+		// visible commands of each pipeline (all of them if camera is null)
+		// Note: lists are views over internal buffers reused by the next call of the same method
+		RenderCommandList ForwardCommands(Camera* camera = nullptr);
+		RenderCommandList DeferredCommands(Camera* camera = nullptr);
+		RenderCommandList AlphaCommands(Camera* camera = nullptr);
+		RenderCommandList ProcessCommands();
+		RenderCommandList ShadowCastCommands(Camera* view = nullptr);
+
+		// access stored command (e.g. refresh transform of a moving object)
+		inline RenderCommand& Get(unsigned int index) { return m_commands[index]; }
+
+		// sync culling bounds after aabb of a stored command was changed
+		inline void UpdateBounds(unsigned int index) { m_bounds.Set(index, m_commands[index].aabb); }
+		inline unsigned int Size() const { return static_cast<unsigned int>(m_commands.size()); }
+		inline const RenderCommand* Data() const { return m_commands.data(); }
+
+	private:
+		void sortOnKeys(std::vector<unsigned int>& indices, unsigned int buffer, const Camera* camera, bool backToFront);
+
+		RenderCommandList cullCommands(const std::vector<unsigned int>& indices, std::vector<unsigned int>& visible, Camera* camera);
 
-		// sort is optional (avoid shader switch)
-		void SortOnShaderIndex();
+		// bit of view in masks of latest Cull (0 if view was not culled)
+		unsigned int viewBit(Camera* view) const;
 
-		std::vector<RenderCommand> ForwardCommands(Camera* camera = nullptr);
-		std::vector<RenderCommand> DeferredCommands(Camera* camera = nullptr);
-		std::vector<RenderCommand> AlphaCommands(Camera* camera = nullptr);
-		std::vector<RenderCommand> ProcessCommands();
-		std::vector<RenderCommand> ShadowCastCommands();
+		// batch id of command (new batch if no stored command shares its vao and material state)
+		unsigned int findBatch(const RenderCommand& command);
+
+		// assign batches and state keys again if a material was changed after its commands were pushed
+		void refreshBatches();
 
 	private:
-		std::vector<RenderCommand> m_forwardCommands;
-		std::vector<RenderCommand> m_deferredCommands;
-		std::vector<RenderCommand> m_alphaCommands; // transparent object
-		std::vector<RenderCommand> m_processCommands; // post effect processing
+		// persistent command storage (indices stay valid until Clear)
+		std::vector<RenderCommand> m_commands;
+
+		// indices of commands in storage, grouped by pipeline
+		std::vector<unsigned int> m_forwardCommands;
+		std::vector<unsigned int> m_deferredCommands;
+		std::vector<unsigned int> m_alphaCommands; // transparent object
+		std::vector<unsigned int> m_processCommands; // post effect processing
+
+		// culling bounds (parallel to command storage) and per-view masks of latest Cull
+		BoundsSoA m_bounds;
+		std::vector<unsigned int> m_viewMasks;
+		std::vector<Camera*> m_cullViews;
+		std::vector<std::pair<unsigned int, unsigned int>> m_culledRanges; // masks outside are zero
+
+		// instancing batches: material of first command in each batch, and batches by (vao, shader)
+		std::vector<Material*> m_batches;
+		std::unordered_map<unsigned long long, std::vector<unsigned int>> m_batchLookup;
+
+		// visibility lists (capacity is reused across frames)
+		std::vector<unsigned int> m_visibleForward;
+		std::vector<unsigned int> m_visibleDeferred;
+		std::vector<unsigned int> m_visibleAlpha;
+		std::vector<unsigned int> m_shadowCasters;
+
+		// sort buffers reused across frames (one pair per pipeline, sorted concurrently)
+		std::vector<SortItem> m_sortItems[3];
+		std::vector<SortItem> m_sortScratch[3];
 	};
 }
 
@@ -9,6 +9,8 @@ namespace xengine
 		useFlashLight = true;
 		useRenderLights = true;
 		useLightVolumes = true;
+		useClusteredLights = true;
+		useGpuLightCulling = true;
 		useRenderProbes = false;
 		useWireframe = false;
 		useSepia = false;
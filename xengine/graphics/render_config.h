@@ -18,6 +18,8 @@ namespace xengine
 			bool useFlashLight;
 			bool useRenderLights;
 			bool useLightVolumes;
+			bool useClusteredLights;
+			bool useGpuLightCulling;
 			bool useRenderProbes;
 			bool useWireframe;
 			bool useSepia;
@@ -36,6 +38,8 @@ namespace xengine
 		static bool UseFlashLight() { return _config.useFlashLight; }
 		static bool UseLightVolume() { return _config.useLightVolumes; }
 		static bool UseRenderLights() { return _config.useRenderLights; }
+		static bool UseClusteredLights() { return _config.useClusteredLights; }
+		static bool UseGpuLightCulling() { return _config.useGpuLightCulling; }
 		static bool UseRenderProbes() { return _config.useRenderProbes; }
 		static bool UseParallelShadow() { return _config.useParallelShadow; }
 		static bool UseSSAO() { return _config.useSSAO; }
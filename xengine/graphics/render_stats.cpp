@@ -0,0 +1,14 @@
+#include "render_stats.h"
+
+namespace xengine
+{
+	RenderStats::Stats::Stats()
+	{
+		numProxies = 0;
+		numProxiesTouched = 0;
+		numOglCalls = 0;
+		numOglCallsSkipped = 0;
+	}
+
+	RenderStats::Stats RenderStats::_stats;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef XE_RENDER_STATS_H
+#define XE_RENDER_STATS_H
+
+namespace xengine
+{
+	class UI;
+	class Renderer;
+
+	class RenderStats
+	{
+		friend class UI;
+		friend class Renderer;
+
+	private:
+		struct Stats
+		{
+			unsigned int numProxies; // render proxies of current scene
+			unsigned int numProxiesTouched; // proxies whose commands were rewritten in last frame
+			unsigned int numOglCalls; // state and binding calls issued in last frame
+			unsigned int numOglCallsSkipped; // redundant state and binding calls filtered in last frame
+
+			Stats();
+		};
+
+	public:
+		static unsigned int NumProxies() { return _stats.numProxies; }
+		static unsigned int NumProxiesTouched() { return _stats.numProxiesTouched; }
+		static unsigned int NumOglCalls() { return _stats.numOglCalls; }
+		static unsigned int NumOglCallsSkipped() { return _stats.numOglCallsSkipped; }
+
+	private:
+		static Stats _stats;
+	};
+}
+
+#endif // !XE_RENDER_STATS_H
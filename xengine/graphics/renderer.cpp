@@ -1,16 +1,26 @@
 #include "renderer.h"
 
+#include <atomic>
+#include <algorithm>
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
 #include <geometry/constant.h>
+#include <utility/job_system.h>
 
 #include "ogl_status.h"
 #include "texture_manager.h"
 #include "render_config.h"
+#include "render_stats.h"
 #include "general_renderer.h"
+#include "frame_sync.h"
+#include "object_buffer.h"
+#include "light_cluster.h"
 #include "forward_renderer.h"
 #include "ibl_renderer.h"
+#include "shader_build_queue.h"
+#include "texture_streamer.h"
 
 namespace xengine
 {
@@ -18,13 +28,15 @@ namespace xengine
 	UniformBuffer Renderer::ubLights;
 	UniformBlock Renderer::blockCamera;
 	UniformBlock Renderer::blockParallelLights;
-	UniformBlock Renderer::blockPointLights;
 
 	void Renderer::Initialize()
 	{
 		// uniform block
 		generateUniformBuffer();
 
+		// point light clusters
+		LightCluster::Initialize();
+
 		// TO BE DECIDED...
 	}
 
@@ -39,8 +51,9 @@ namespace xengine
 		// 1 color attachment
 		m_mainCanvas.GenerateColorAttachments(1, 1, GL_HALF_FLOAT, 1);
 
-		// 1 render buffer for depth test (in the case depth value is not needed by other routines)
-		m_mainCanvas.GenerateDepthRenderBuffer(1, 1);
+		// 1 render buffer for depth and stencil test (in the case depth value is not needed by other routines)
+		// depth and stencil are copied from g-buffer before deferred lighting
+		m_mainCanvas.GenerateDepthStencilRenderBuffer(1, 1);
 
 		// depth attachment (in the case depth value is needed)
 		//m_canvas.GenerateDepthAttachment(1, 1, GL_HALF_FLOAT);
@@ -77,16 +90,12 @@ namespace xengine
 			unsigned int offset = 0;
 
 			// parallel lights
-			size = static_cast<unsigned int>(4 * (sizeof(glm::vec4) * 2));
+			size = static_cast<unsigned int>(kMaxBlockParallelLights * (sizeof(glm::vec4) * 2));
 			blockParallelLights.Register(&ubLights);
 			blockParallelLights.SetBlock(offset, size);
 			offset += size;
 
-			// point lights
-			size = static_cast<unsigned int>(8 * (sizeof(glm::vec4) * 2));
-			blockPointLights.Register(&ubLights);
-			blockPointLights.SetBlock(offset, size);
-			offset += size;
+			// point lights are not limited to a block, see LightCluster
 
 			ubLights.Generate(offset, 1);
 		}
@@ -108,66 +117,222 @@ namespace xengine
 		blockCamera.CommitData(camera->GetUp());
 		blockCamera.CommitData(camera->GetRight());
 
-		// parallel lights
+		// parallel lights (forward shading is limited to the first ones)
 		blockParallelLights.Refresh();
 
-		for (unsigned int i = 0; i < scene->parallelLights.size() && i < 4; ++i)
+		for (unsigned int i = 0; i < scene->parallelLights.size() && i < kMaxBlockParallelLights; ++i)
 		{
 			ParallelLight* light = scene->parallelLights[i];
 			blockParallelLights.CommitData(light->direction);
 			blockParallelLights.CommitData(light->color);
 		}
 
-		// point lights
-		blockPointLights.Refresh();
-
-		for (unsigned int i = 0; i < scene->pointLights.size() && i < 8; ++i)
-		{
-			PointLight* light = scene->pointLights[i];
-			blockPointLights.CommitData(light->position);
-			blockPointLights.CommitData(light->color);
-		}
+		// blocks above only filled CPU mirrors, upload each buffer in one write
+		ubCamera.Flush();
+		ubLights.Flush();
 	}
 
 	void Renderer::generateCommandsFromScene(Scene* scene)
 	{
-		std::vector<Model*> models;
+		commandManager.Clear();
+		m_proxies.clear();
+		m_proxyRoots.clear();
+		m_rootCommands.clear();
 
 		for (Model* root : scene->models)
 		{
-			// make sure model geometry is up-to-date
-			root->UpdateTransform();
-
-			root->GetAllNodes(models);
+			generateProxies(root);
 		}
 
-		// generate a render command and push to queue
-		for (Model* model : models)
+		m_proxyScene = scene->Identity();
+		m_proxyRevision = scene->Revision();
+		m_proxyValid = true;
+	}
+
+	void Renderer::generateProxies(Model* root)
+	{
+		unsigned int firstCommand = commandManager.Size();
+		std::vector<Model*> nodes;
+
+		// Note: parent node is always placed before its children
+		root->GetAllNodes(nodes);
+
+		// generate render commands and push to storage
+		for (Model* node : nodes)
 		{
-			for (size_t i = 0; i < model->meshes.size(); ++i)
+			RenderProxy proxy(node, commandManager.Size());
+
+			for (size_t i = 0; i < node->meshes.size(); ++i)
 			{
-				RenderCommand command(&model->meshes[i], &model->materials[i]);
-				command.transform = model->transform;
-				command.prevTrans = model->prevTrans;
+				RenderCommand command(&node->meshes[i], &node->materials[i]);
+				command.transform = node->transform;
+				command.prevTrans = node->prevTrans;
 				command.aabb.BuildFromTransform(command.mesh->Aabb(), command.transform);
 				commandManager.Push(command);
 			}
+
+			proxy.count = static_cast<unsigned int>(node->meshes.size());
+			proxy.numChildren = node->children.size();
+			proxy.moving = node->updated; // prevTrans differs until next frame
+			m_proxies.push_back(proxy);
 		}
+
+		m_proxyRoots.push_back(root);
+		m_rootCommands[root] = std::make_pair(firstCommand, commandManager.Size());
 	}
 
 	void Renderer::updateCommandBuffer(Scene* scene, Camera* camera)
 	{
-		// TODO:
-		// not necessary to update each frame
-		// send signal to update only when scene is changed
-		// Make command.transform pointer to model.transform
-		commandManager.Clear();
+		// make sure model geometry is up-to-date (hierarchies are independent)
+		JobSystem::ParallelFor(scene->models.size(), 1, [scene](size_t first, size_t last) {
+			for (size_t i = first; i < last; ++i)
+				scene->models[i]->UpdateTransform();
+		});
+
+		// proxies built in this frame are up-to-date already
+		size_t numChecked = m_proxies.size();
+
+		if (!m_proxyValid || m_proxyScene != scene->Identity())
+		{
+			generateCommandsFromScene(scene);
+			numChecked = 0;
+		}
+		else if (m_proxyRevision != scene->Revision())
+		{
+			// models only appended: generate proxies for new models, otherwise rebuild all
+			bool appended = m_proxyRoots.size() <= scene->models.size() &&
+				std::equal(m_proxyRoots.begin(), m_proxyRoots.end(), scene->models.begin());
+
+			if (appended)
+			{
+				for (size_t i = m_proxyRoots.size(); i < scene->models.size(); ++i)
+					generateProxies(scene->models[i]);
+
+				m_proxyRevision = scene->Revision();
+			}
+			else
+			{
+				generateCommandsFromScene(scene);
+				numChecked = 0;
+			}
+		}
+
+		// meshes or children changed (such node is always dirty), commands must be regenerated
+		// Note: parents precede children, so a removed child is never visited before rebuilding
+		for (size_t k = 0; k < numChecked; ++k)
+		{
+			const RenderProxy& proxy = m_proxies[k];
+			Model* node = proxy.node;
+
+			if (node->updated && (node->meshes.size() != proxy.count || node->children.size() != proxy.numChildren))
+			{
+				generateCommandsFromScene(scene);
+				numChecked = 0;
+				break;
+			}
+		}
+
+		std::atomic<unsigned int> touched(static_cast<unsigned int>(m_proxies.size() - numChecked));
+
+		// refresh commands of nodes moved in this frame or the last one (prevTrans)
+		JobSystem::ParallelFor(numChecked, 256, [this, &touched](size_t first, size_t last) {
+			unsigned int count = 0;
+
+			for (size_t k = first; k < last; ++k)
+			{
+				RenderProxy& proxy = m_proxies[k];
+				Model* node = proxy.node;
+
+				if (!node->updated && !proxy.moving) continue;
+
+				for (unsigned int i = 0; i < proxy.count; ++i)
+				{
+					RenderCommand& command = commandManager.Get(proxy.first + i);
+					command.transform = node->transform;
+					command.prevTrans = node->prevTrans;
+					command.aabb.BuildFromTransform(command.mesh->Aabb(), command.transform);
+					commandManager.UpdateBounds(proxy.first + i);
+				}
+
+				proxy.moving = node->updated;
+				++count;
+			}
+
+			touched += count;
+		});
+
+		RenderStats::_stats.numProxies = static_cast<unsigned int>(m_proxies.size());
+		RenderStats::_stats.numProxiesTouched = touched;
+	}
+
+	void Renderer::cullScene(Scene* scene, Camera* camera)
+	{
+		m_cullViews.clear();
+		m_cullViews.push_back(camera);
+
+		if (RenderConfig::UseParallelShadow())
+		{
+			for (ParallelLight* light : scene->parallelLights)
+			{
+				if (light->useShadowCast)
+					m_cullViews.push_back(light->shadow.GetCamera());
+			}
+		}
+
+		// models overlapping any view, found by scene trees
+		m_queryModels.clear();
+
+		for (Camera* view : m_cullViews)
+		{
+			if (view) scene->QueryFrustum(view->GetFrustum(), m_queryModels);
+		}
+
+		// commands of a root are contiguous, merge ranges of roots found by several views
+		m_cullRanges.clear();
+
+		for (Model* model : m_queryModels)
+		{
+			auto it = m_rootCommands.find(model);
+			if (it != m_rootCommands.end() && it->second.first < it->second.second)
+				m_cullRanges.push_back(it->second);
+		}
+
+		std::sort(m_cullRanges.begin(), m_cullRanges.end());
+
+		size_t numRanges = 0;
+
+		for (size_t i = 0; i < m_cullRanges.size(); ++i)
+		{
+			if (numRanges > 0 && m_cullRanges[i].first <= m_cullRanges[numRanges - 1].second)
+				m_cullRanges[numRanges - 1].second = std::max(m_cullRanges[numRanges - 1].second, m_cullRanges[i].second);
+			else
+				m_cullRanges[numRanges++] = m_cullRanges[i];
+		}
+
+		m_cullRanges.resize(numRanges);
+
+		// each command box of found models is loaded once and tested against all views
+		commandManager.Cull(m_cullViews, m_cullRanges);
 
-		// generate render commands from scene
-		generateCommandsFromScene(scene);
+		// point light volumes
+		m_lightBounds.Resize(scene->pointLights.size());
+
+		for (size_t i = 0; i < scene->pointLights.size(); ++i)
+		{
+			const PointLight* light = scene->pointLights[i];
+			m_lightBounds.Set(i, AABB(light->position - glm::vec3(light->radius), light->position + glm::vec3(light->radius)));
+		}
 
-		// sort commands against shader id to save OpenGL state switch
-		commandManager.SortOnShaderIndex(); // not necessary
+		m_lightMasks.resize(scene->pointLights.size());
+		FrustumCull::Cull(camera->GetFrustum(), m_lightBounds, m_lightMasks.data());
+
+		m_visiblePointLights.clear();
+
+		for (size_t i = 0; i < scene->pointLights.size(); ++i)
+		{
+			if (m_lightMasks[i])
+				m_visiblePointLights.push_back(scene->pointLights[i]);
+		}
 	}
 
 	void Renderer::Resize(unsigned width, unsigned int height)
@@ -190,10 +355,43 @@ namespace xengine
 
 	void Renderer::Render(Scene* scene, Camera* camera, FrameBuffer && target)
 	{
+		// state calls of last frame (UI included), then start over from unknown state
+		// since code outside the engine (e.g. UI) may have touched the context
+		RenderStats::_stats.numOglCalls = OglStatus::IssuedCalls();
+		RenderStats::_stats.numOglCallsSkipped = OglStatus::SkippedCalls();
+		OglStatus::ResetCounters();
+		OglStatus::Invalidate();
+
+		// programs created since last frame (e.g. by scene loading)
+		ShaderBuildQueue::Flush();
+
+		// ring buffer regions of this frame are free to write after this
+		FrameSync::BeginFrame();
+
+		// uploads of streamed textures go to pixel unpack region of this frame
+		TextureStreamer::Update();
+
+		// main thread jobs queued by workers (e.g. OpenGL uploads)
+		JobSystem::ProcessMainThreadJobs();
+
 		updateUniformBuffer(scene, camera);
 
 		updateCommandBuffer(scene, camera);
 
+		// per-object data of all commands, shared by every pass of this frame
+		ObjectBuffer::Upload(commandManager.Data(), commandManager.Size());
+
+		// group commands by render state and order them on view depth
+		// sorting and culling only read commands so they run concurrently
+		JobHandle sortJob = JobSystem::Submit([this, camera]() { commandManager.Sort(camera); });
+
+		cullScene(scene, camera);
+
+		JobSystem::Wait(sortJob);
+
+		// bin visible point lights into clusters, read by deferred and forward lighting
+		LightCluster::Build(m_visiblePointLights, camera, m_mainCanvas.Width(), m_mainCanvas.Height());
+
 		// default OpenGL settings
 		OglStatus::SetBlend(GL_FALSE);
 		OglStatus::SetCull(GL_TRUE);
@@ -203,7 +401,7 @@ namespace xengine
 
 		/// deferred pass
 		{
-			std::vector<RenderCommand> commands = commandManager.DeferredCommands(camera);
+			RenderCommandList commands = commandManager.DeferredCommands(camera);
 
 			OglStatus::SetPolygonMode(RenderConfig::UseWireframe() ? GL_LINE : GL_FILL);
 
@@ -215,9 +413,14 @@ namespace xengine
 		/// shadow maps
 		if (RenderConfig::UseParallelShadow())
 		{
-			std::vector<RenderCommand> commands = commandManager.ShadowCastCommands();
+			for (ParallelLight* light : scene->parallelLights)
+			{
+				if (!light->useShadowCast) continue;
 
-			forwardRenderer.GenerateParallelShadow(commands, scene->parallelLights, camera);
+				RenderCommandList commands = commandManager.ShadowCastCommands(light->shadow.GetCamera());
+
+				forwardRenderer.GenerateParallelShadow(commands, light);
+			}
 		}
 
 		/// per-lighting pass
@@ -236,23 +439,35 @@ namespace xengine
 
 		/// deferred lighting
 		{
+			// copy depth buffer, and stencil marking pixels covered by geometry
+			Blit(deferredRenderer.GetFrameBuffer(), m_mainCanvas, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
 			m_mainCanvas.Bind(); glViewport(0, 0, m_mainCanvas.Width(), m_mainCanvas.Height());
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+			glClear(GL_COLOR_BUFFER_BIT);
 
-			if (RenderConfig::UseSSR()) deferredRenderer.RenderReflectLight(m_swapCanvas.GetColorAttachment(0));
+			// empty pixels are left out of lighting
+			OglStatus::SetStencilTest(GL_TRUE);
+			OglStatus::SetStencilFunc(GL_EQUAL, 1, 0xff);
+			OglStatus::SetStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 
-			deferredRenderer.RenderAmbientLight(scene->irradianceMap, scene->reflectionMap, ssaoRenderer.GetAO(), IblRenderer::GetBrdfIntegrationMap());
+			deferredRenderer.RenderResolve(scene->parallelLights, scene->irradianceMap, scene->reflectionMap, ssaoRenderer.GetAO(), IblRenderer::GetBrdfIntegrationMap(), m_swapCanvas.GetColorAttachment(0));
 
-			deferredRenderer.RenderParallelLights(scene->parallelLights, camera, ssaoRenderer.GetAO());
+			// parallel lights beyond those of resolve pass
+			if (scene->parallelLights.size() > DeferredRenderer::kMaxResolveLights)
+			{
+				std::vector<ParallelLight*> lights(scene->parallelLights.begin() + DeferredRenderer::kMaxResolveLights, scene->parallelLights.end());
+				deferredRenderer.RenderParallelLights(lights, camera, ssaoRenderer.GetAO());
+			}
+
+			if (!RenderConfig::UseClusteredLights())
+				deferredRenderer.RenderPointLights();
 
-			deferredRenderer.RenderPointLights(scene->pointLights, camera);
+			OglStatus::SetStencilTest(GL_FALSE);
 		}
 
 		/// forward pass
 		{
-			Blit(deferredRenderer.GetFrameBuffer(), m_mainCanvas, GL_DEPTH_BUFFER_BIT); // copy depth buffer
-
-			std::vector<RenderCommand> commands = commandManager.ForwardCommands(camera);
+			RenderCommandList commands = commandManager.ForwardCommands(camera);
 
 			ForwardRenderer::SetParallelShadow(scene->parallelLights, commands);
 
@@ -267,14 +482,14 @@ namespace xengine
 			OglStatus::SetCullFace(GL_BACK);
 
 			if (RenderConfig::UseRenderLights())
-				forwardRenderer.RenderEmissionPointLights(scene->pointLights, camera, 0.25f);
+				forwardRenderer.RenderEmissionPointLights(0.25f);
 
 			forwardRenderer.RenderParticles(scene->particles, camera);
 		}
 
 		/// alpha pass
 		{
-			std::vector<RenderCommand> commands = commandManager.AlphaCommands(camera);
+			RenderCommandList commands = commandManager.AlphaCommands(camera);
 
 			ForwardRenderer::SetParallelShadow(scene->parallelLights, commands);
 
@@ -305,7 +520,7 @@ namespace xengine
 				OglStatus::SetCull(GL_TRUE);
 				OglStatus::SetCullFace(GL_FRONT);
 
-				forwardRenderer.RenderEmissionPointLights(scene->pointLights, camera);
+				forwardRenderer.RenderEmissionPointLights();
 
 				OglStatus::SetPolygonMode(GL_FILL);
 				OglStatus::SetCullFace(GL_BACK);
@@ -359,6 +574,9 @@ namespace xengine
 				Blit(m_mainCanvas, target, GL_COLOR_BUFFER_BIT); // blit to assigned frame buffer
 			else
 				Blit(m_mainCanvas, width, height, GL_COLOR_BUFFER_BIT); // blit to default frame buffer
+
+			// ring buffer regions of this frame can be overwritten once GPU gets here
+			FrameSync::EndFrame();
 		}
 	}
 }
\ No newline at end of file
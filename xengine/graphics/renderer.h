@@ -35,13 +35,25 @@ namespace xengine
 	public:
 		static void Initialize();
 
+	public:
+		// parallel lights in GlobalLights uniform block, the only ones forward shaders see (further lights are
+		// lit in deferred pass only, see DeferredRenderer::RenderParallelLights)
+		static const unsigned int kMaxBlockParallelLights = 4;
+
 	private:
-		// generate render commands from scene
+		// generate render commands from scene (rebuild all render proxies)
 		void generateCommandsFromScene(Scene* scene);
 
-		// update commands
+		// generate render proxies and their commands for a model hierarchy
+		void generateProxies(Model* root);
+
+		// update commands (only proxies of moving nodes are touched)
 		void updateCommandBuffer(Scene* scene, Camera* camera);
 
+		// cull commands of models found in scene trees against camera and shadow cameras in one pass
+		// cull point lights against camera
+		void cullScene(Scene* scene, Camera* camera);
+
 	private:
 		// register uniform buffers
 		static void generateUniformBuffer();
@@ -57,6 +69,22 @@ namespace xengine
 		// commands
 		RenderCommandManager commandManager;
 
+		// render proxies (persistent through frames, rebuilt on scene change)
+		std::vector<RenderProxy> m_proxies;
+		std::vector<Model*> m_proxyRoots;
+		std::unordered_map<Model*, std::pair<unsigned int, unsigned int>> m_rootCommands; // command range of each root
+		unsigned long long m_proxyScene = 0; // identity of scene proxies belong to
+		unsigned long long m_proxyRevision = 0; // revision of scene proxies were built from
+		bool m_proxyValid = false;
+
+		// visibility (buffers reused across frames)
+		std::vector<Camera*> m_cullViews; // camera first, then shadow cameras
+		std::vector<Model*> m_queryModels;
+		std::vector<std::pair<unsigned int, unsigned int>> m_cullRanges;
+		BoundsSoA m_lightBounds;
+		std::vector<unsigned int> m_lightMasks;
+		std::vector<PointLight*> m_visiblePointLights;
+
 		// deferred renderer
 		DeferredRenderer deferredRenderer;
 
@@ -83,7 +111,6 @@ namespace xengine
 		// uniform buffer agents
 		static UniformBlock blockCamera;
 		static UniformBlock blockParallelLights;
-		static UniformBlock blockPointLights;
 	};
 }
 
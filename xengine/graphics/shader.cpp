@@ -5,6 +5,10 @@
 
 #include <utility/log.h>
 
+#include "ogl_status.h"
+#include "program_cache.h"
+#include "shader_build_queue.h"
+
 namespace xengine
 {
 	////////////////////////////////////////////////////////////////
@@ -25,6 +29,15 @@ namespace xengine
 		if (m_id)
 		{
 			Log::Message("[ShaderMomory] Shader " + std::to_string(m_id) + " deleted", Log::DEBUG);
+
+			// stages of a link that never finished
+			if (m_vs) { glDeleteShader(m_vs); m_vs = 0; }
+			if (m_gs) { glDeleteShader(m_gs); m_gs = 0; }
+			if (m_fs) { glDeleteShader(m_fs); m_fs = 0; }
+			if (m_cs) { glDeleteShader(m_cs); m_cs = 0; }
+			m_pending = false;
+
+			OglStatus::ForgetProgram(m_id);
 			glDeleteProgram(m_id);
 			m_id = 0;
 		}
@@ -36,26 +49,45 @@ namespace xengine
 
 	void Shader::Bind()
 	{
-		glUseProgram(m_ptr->m_id);
+		ready();
+		OglStatus::UseProgram(m_ptr->m_id);
 	}
 
 	void Shader::Bind() const
 	{
-		glUseProgram(m_ptr->m_id);
+		ready();
+		OglStatus::UseProgram(m_ptr->m_id);
 	}
 
 	void Shader::Unbind() const
 	{
-		glUseProgram(0);
+		OglStatus::UseProgram(0);
 	}
 
 	int Shader::GetUniformLocation(const std::string& name)
 	{
+		ready();
 		auto it = m_ptr->m_uniformTable.find(name);
 		if (it != m_ptr->m_uniformTable.end()) return it->second.location;
 		return -1;
 	}
 
+	const ShaderMomory::VarTableEntry* Shader::GetUniformInfo(const std::string& name) const
+	{
+		ready();
+		auto it = m_ptr->m_uniformTable.find(name);
+		if (it != m_ptr->m_uniformTable.end()) return &it->second;
+		return nullptr;
+	}
+
+	const ShaderMomory::BlockTableEntry* Shader::GetUniformBlockInfo(const std::string& name) const
+	{
+		ready();
+		auto it = m_ptr->m_blockTable.find(name);
+		if (it != m_ptr->m_blockTable.end()) return &it->second;
+		return nullptr;
+	}
+
 	void Shader::SetUniform(const std::string& name, int value)
 	{
 		int loc = GetUniformLocation(name);
@@ -116,42 +148,150 @@ namespace xengine
 		if (loc >= 0) glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]);
 	}
 
-	// Note: For array uniform say, array[N], only 'array[0]' will be stored.
+	// Note: For array uniform say, array[N], 'array[0]' is stored along with 'array'.
 
 	void Shader::SetUniform(const std::string& name, int size, const std::vector<glm::vec2>& values)
 	{
-		int loc = glGetUniformLocation(m_ptr->m_id, name.c_str());
+		int loc = GetUniformLocation(name);
 		if (loc >= 0) glUniform2fv(loc, size, (float*)(&values[0].x));
 	}
 
 	void Shader::SetUniform(const std::string& name, int size, const std::vector<glm::vec3>& values)
 	{
-		int loc = glGetUniformLocation(m_ptr->m_id, name.c_str());
+		int loc = GetUniformLocation(name);
 		if (loc >= 0) glUniform3fv(loc, size, (float*)(&values[0].x));
 	}
 
 	void Shader::SetUniform(const std::string& name, int size, const std::vector<glm::vec4>& values)
 	{
-		int loc = glGetUniformLocation(m_ptr->m_id, name.c_str());
+		int loc = GetUniformLocation(name);
+		if (loc >= 0) glUniform4fv(loc, size, (float*)(&values[0].x));
+	}
+
+	void Shader::SetUniform(const std::string& name, int size, const std::vector<glm::mat4>& values)
+	{
+		int loc = GetUniformLocation(name);
+		if (loc >= 0) glUniformMatrix4fv(loc, size, GL_FALSE, &values[0][0][0]);
+	}
+
+	void Shader::SetUniform(const std::string& name, int size, const std::vector<int>& values)
+	{
+		int loc = GetUniformLocation(name);
+		if (loc >= 0) glUniform1iv(loc, size, values.data());
+	}
+
+	void Shader::SetUniform(UniformID id, int value)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniform1i(loc, value);
+	}
+
+	void Shader::SetUniform(UniformID id, bool value)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniform1i(loc, static_cast<int>(value));
+	}
+
+	void Shader::SetUniform(UniformID id, float value)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniform1f(loc, value);
+	}
+
+	void Shader::SetUniform(UniformID id, unsigned int value)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniform1i(loc, static_cast<int>(value));
+	}
+
+	void Shader::SetUniform(UniformID id, const glm::vec2& value)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniform2fv(loc, 1, &value[0]);
+	}
+
+	void Shader::SetUniform(UniformID id, const glm::vec3& value)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniform3fv(loc, 1, &value[0]);
+	}
+
+	void Shader::SetUniform(UniformID id, const glm::vec4& value)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniform4fv(loc, 1, &value[0]);
+	}
+
+	void Shader::SetUniform(UniformID id, const glm::mat2& value)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniformMatrix2fv(loc, 1, GL_FALSE, &value[0][0]);
+	}
+
+	void Shader::SetUniform(UniformID id, const glm::mat3& value)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniformMatrix3fv(loc, 1, GL_FALSE, &value[0][0]);
+	}
+
+	void Shader::SetUniform(UniformID id, const glm::mat4& value)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]);
+	}
+
+	void Shader::SetUniform(UniformID id, int size, const std::vector<glm::vec2>& values)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniform2fv(loc, size, (float*)(&values[0].x));
+	}
+
+	void Shader::SetUniform(UniformID id, int size, const std::vector<glm::vec3>& values)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniform3fv(loc, size, (float*)(&values[0].x));
+	}
+
+	void Shader::SetUniform(UniformID id, int size, const std::vector<glm::vec4>& values)
+	{
+		int loc = GetUniformLocation(id);
 		if (loc >= 0) glUniform4fv(loc, size, (float*)(&values[0].x));
 	}
 
+	void Shader::SetUniform(UniformID id, int size, const std::vector<glm::mat4>& values)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniformMatrix4fv(loc, size, GL_FALSE, &values[0][0][0]);
+	}
+
+	void Shader::SetUniform(UniformID id, int size, const std::vector<int>& values)
+	{
+		int loc = GetUniformLocation(id);
+		if (loc >= 0) glUniform1iv(loc, size, values.data());
+	}
+
 	void Shader::AttachVertexShader(const std::string & source)
 	{
 		allocateMemory();
-		m_ptr->m_vs = CreateShader(source, GL_VERTEX_SHADER);
+		m_ptr->m_sources.emplace_back(GL_VERTEX_SHADER, source);
 	}
 
 	void Shader::AttachGeometryShader(const std::string & source)
 	{
 		allocateMemory();
-		m_ptr->m_gs = CreateShader(source, GL_GEOMETRY_SHADER);
+		m_ptr->m_sources.emplace_back(GL_GEOMETRY_SHADER, source);
 	}
 
 	void Shader::AttachFragmentShader(const std::string & source)
 	{
 		allocateMemory();
-		m_ptr->m_fs = CreateShader(source, GL_FRAGMENT_SHADER);
+		m_ptr->m_sources.emplace_back(GL_FRAGMENT_SHADER, source);
+	}
+
+	void Shader::AttachComputeShader(const std::string & source)
+	{
+		allocateMemory();
+		m_ptr->m_sources.emplace_back(GL_COMPUTE_SHADER, source);
 	}
 
 	void Shader::Generate()
@@ -169,30 +309,94 @@ namespace xengine
 			return;
 		}
 
+		submit();
+
+		// statuses are checked at flush (or first use), so compiles of later programs overlap this one
+		ShaderBuildQueue::Push(*this);
+	}
+
+	void Shader::submit()
+	{
+		m_ptr->m_submitted = std::chrono::steady_clock::now();
+		m_ptr->m_pending = true;
+
+		// skip compilation if a binary of the same sources is cached
+		m_ptr->m_key = ProgramCache::Key(m_ptr->m_sources);
+		m_ptr->m_cached = !m_ptr->m_sources.empty() && ProgramCache::Load(m_ptr->m_id, m_ptr->m_key);
+
+		if (!m_ptr->m_cached)
+		{
+			for (const auto& source : m_ptr->m_sources)
+			{
+				unsigned int shader = SubmitShader(source.second, source.first);
+
+				switch (source.first)
+				{
+				case GL_VERTEX_SHADER: m_ptr->m_vs = shader; break;
+				case GL_GEOMETRY_SHADER: m_ptr->m_gs = shader; break;
+				case GL_FRAGMENT_SHADER: m_ptr->m_fs = shader; break;
+				case GL_COMPUTE_SHADER: m_ptr->m_cs = shader; break;
+				default: glDeleteShader(shader); break;
+				}
+			}
+
+			if (m_ptr->m_vs) glAttachShader(m_ptr->m_id, m_ptr->m_vs);
+			if (m_ptr->m_gs) glAttachShader(m_ptr->m_id, m_ptr->m_gs);
+			if (m_ptr->m_fs) glAttachShader(m_ptr->m_id, m_ptr->m_fs);
+			if (m_ptr->m_cs) glAttachShader(m_ptr->m_id, m_ptr->m_cs);
+
+			if (ProgramCache::Enabled()) glProgramParameteri(m_ptr->m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+			glLinkProgram(m_ptr->m_id);
+		}
+
+		m_ptr->m_sources.clear();
+	}
+
+	void Shader::finish()
+	{
+		m_ptr->m_pending = false;
+
 		int status;
 		char log[1024];
+		unsigned int id = m_ptr->m_id;
 
-		if (m_ptr->m_vs) glAttachShader(m_ptr->m_id, m_ptr->m_vs);
-		if (m_ptr->m_gs) glAttachShader(m_ptr->m_id, m_ptr->m_gs);
-		if (m_ptr->m_fs) glAttachShader(m_ptr->m_id, m_ptr->m_fs);
+		glGetProgramiv(id, GL_LINK_STATUS, &status);
+		if (!status)
+		{
+			// compile errors of stages explain most link errors
+			if (m_ptr->m_vs) CheckShader(m_ptr->m_vs, GL_VERTEX_SHADER);
+			if (m_ptr->m_gs) CheckShader(m_ptr->m_gs, GL_GEOMETRY_SHADER);
+			if (m_ptr->m_fs) CheckShader(m_ptr->m_fs, GL_FRAGMENT_SHADER);
+			if (m_ptr->m_cs) CheckShader(m_ptr->m_cs, GL_COMPUTE_SHADER);
 
-		glLinkProgram(m_ptr->m_id);
+			glGetProgramInfoLog(id, 1024, NULL, log);
+			Log::Message("[Shader] Program linking error: \n" + std::string(log), Log::ERROR);
+		}
 
-		if (m_ptr->m_vs) { glDetachShader(m_ptr->m_id, m_ptr->m_vs); glDeleteShader(m_ptr->m_vs); m_ptr->m_vs = 0; }
-		if (m_ptr->m_gs) { glDetachShader(m_ptr->m_id, m_ptr->m_gs); glDeleteShader(m_ptr->m_gs); m_ptr->m_gs = 0; }
-		if (m_ptr->m_fs) { glDetachShader(m_ptr->m_id, m_ptr->m_fs); glDeleteShader(m_ptr->m_fs); m_ptr->m_fs = 0; }
+		if (m_ptr->m_vs) { glDetachShader(id, m_ptr->m_vs); glDeleteShader(m_ptr->m_vs); m_ptr->m_vs = 0; }
+		if (m_ptr->m_gs) { glDetachShader(id, m_ptr->m_gs); glDeleteShader(m_ptr->m_gs); m_ptr->m_gs = 0; }
+		if (m_ptr->m_fs) { glDetachShader(id, m_ptr->m_fs); glDeleteShader(m_ptr->m_fs); m_ptr->m_fs = 0; }
+		if (m_ptr->m_cs) { glDetachShader(id, m_ptr->m_cs); glDeleteShader(m_ptr->m_cs); m_ptr->m_cs = 0; }
 
-		glGetProgramiv(m_ptr->m_id, GL_LINK_STATUS, &status);
 		if (!status)
 		{
-			glGetProgramInfoLog(m_ptr->m_id, 1024, NULL, log);
-			Log::Message("[Shader] Program linking error: \n" + std::string(log), Log::ERROR);
-			glDeleteProgram(m_ptr->m_id);
+			OglStatus::ForgetProgram(id);
+			glDeleteProgram(id);
 			m_ptr->m_id = 0;
 		}
+		else if (!m_ptr->m_cached)
+		{
+			ProgramCache::Store(id, m_ptr->m_key);
+		}
 
 		QueryActiveAttributes();
 		QueryActiveUniforms();
+		QueryActiveUniformBlocks();
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_ptr->m_submitted;
+		Log::Message("[Shader] Program " + std::to_string(id) + " ready in " + std::to_string(elapsed.count()) + " ms" +
+			(m_ptr->m_cached ? " (cached)" : ""), Log::INFO);
 	}
 
 	void Shader::GenerateAndLink()
@@ -240,6 +444,9 @@ namespace xengine
 		char buffer[128];
 		int niv;
 
+		// uniforms of a freshly linked program are reset
+		m_ptr->m_samplerUnits.clear();
+
 		glGetProgramiv(m_ptr->m_id, GL_ACTIVE_UNIFORMS, &niv);
 
 		for (int i = 0; i < niv; ++i)
@@ -250,6 +457,63 @@ namespace xengine
 			m_ptr->m_uniformTable[std::string(buffer)].type = glType;
 			m_ptr->m_uniformTable[std::string(buffer)].size = glSize;
 			m_ptr->m_uniformTable[std::string(buffer)].location = glGetUniformLocation(m_ptr->m_id, buffer);
+
+			// where the uniform lives if it is a member of a uniform block
+			GLuint index = static_cast<GLuint>(i);
+			glGetActiveUniformsiv(m_ptr->m_id, 1, &index, GL_UNIFORM_BLOCK_INDEX, &m_ptr->m_uniformTable[std::string(buffer)].block);
+			glGetActiveUniformsiv(m_ptr->m_id, 1, &index, GL_UNIFORM_OFFSET, &m_ptr->m_uniformTable[std::string(buffer)].offset);
+			glGetActiveUniformsiv(m_ptr->m_id, 1, &index, GL_UNIFORM_MATRIX_STRIDE, &m_ptr->m_uniformTable[std::string(buffer)].matrixStride);
+		}
+
+		// arrays are reported as 'array[0]', make them reachable by plain name too
+		std::vector<std::string> arrays;
+
+		for (const auto& mp : m_ptr->m_uniformTable)
+		{
+			const std::string& name = mp.first;
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) arrays.push_back(name);
+		}
+
+		for (const std::string& name : arrays)
+		{
+			m_ptr->m_uniformTable.emplace(name.substr(0, name.size() - 3), m_ptr->m_uniformTable[name]);
+		}
+
+		// intern names of default block uniforms to build id -> location array
+		m_ptr->m_locations.clear();
+
+		for (const auto& mp : m_ptr->m_uniformTable)
+		{
+			if (mp.second.block >= 0) continue;
+
+			unsigned int id = UniformID(mp.first).Value();
+			if (id >= m_ptr->m_locations.size()) m_ptr->m_locations.resize(id + 1, -1);
+			m_ptr->m_locations[id] = static_cast<int>(mp.second.location);
+		}
+	}
+
+	void Shader::QueryActiveUniformBlocks()
+	{
+		allocateMemory();
+
+		if (m_ptr->m_id == 0)
+		{
+			Log::Message("[Shader] Shader program has not been created. \n", Log::ERROR);
+			return;
+		}
+
+		char buffer[128];
+		int niv;
+
+		glGetProgramiv(m_ptr->m_id, GL_ACTIVE_UNIFORM_BLOCKS, &niv);
+
+		for (int i = 0; i < niv; ++i)
+		{
+			int size;
+			glGetActiveUniformBlockName(m_ptr->m_id, i, sizeof(buffer), 0, buffer);
+			glGetActiveUniformBlockiv(m_ptr->m_id, i, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+			m_ptr->m_blockTable[std::string(buffer)].index = i;
+			m_ptr->m_blockTable[std::string(buffer)].size = size;
 		}
 	}
 }
\ No newline at end of file
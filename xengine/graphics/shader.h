@@ -4,21 +4,28 @@
 
 #include <string>
 #include <vector>
+#include <chrono>
 #include <unordered_map>
 
 #include <glm/common.hpp>
 
 #include <utility/smart_handle.h>
 
+#include "uniform_id.h"
+
 namespace xengine
 {
 	unsigned int CreateShader(const std::string& source, unsigned int type); // create a shader of TYPE
 	unsigned int CreateVertexShader(const std::string& source, unsigned int type);   // compile a vertex shader
 	unsigned int CreateGeometryShader(const std::string& source, unsigned int type); // compile a geometry shader
 	unsigned int CreateFragmentShader(const std::string& source, unsigned int type); // compile a fragment shader
+	unsigned int CreateComputeShader(const std::string& source, unsigned int type);  // compile a compute shader
+	unsigned int SubmitShader(const std::string& source, unsigned int type); // start compiling a shader of TYPE
+	bool CheckShader(unsigned int shader, unsigned int type); // wait for compilation of a submitted shader
 
-	// read shader source from file (if include exists, read included files recursively)
+	// read shader source from file (if include exists, read included files recursively, files are memoized)
 	std::string ReadShaderSource(const std::string& path);
+	void ClearShaderSources();
 
 	// insert precompile flag to shader source
 	std::string InsertShaderDefine(const std::string& source, const std::vector<std::string>& defines);
@@ -31,6 +38,17 @@ namespace xengine
 			unsigned int type;
 			unsigned int size;
 			unsigned int location;
+
+			// uniform block member only (block = -1 for default block uniforms)
+			int block = -1;
+			int offset = -1;
+			int matrixStride = 0;
+		};
+
+		struct BlockTableEntry
+		{
+			unsigned int index;
+			unsigned int size; // in bytes
 		};
 
 	public:
@@ -46,12 +64,30 @@ namespace xengine
 		unsigned int m_ts = 0; // tessellation shader id
 		unsigned int m_cs = 0; // compute shader id
 
+		// stage type and source of attached shaders, compiled at link unless program binary is cached
+		std::vector<std::pair<unsigned int, std::string>> m_sources;
+
+		// build state between submitting the link and checking its result (see ShaderBuildQueue)
+		bool m_pending = false;
+		bool m_cached = false; // program binary was loaded from ProgramCache
+		unsigned long long m_key = 0; // ProgramCache key of sources
+		std::chrono::steady_clock::time_point m_submitted;
+
 		std::unordered_map<std::string, VarTableEntry> m_attributeTable;
 		std::unordered_map<std::string, VarTableEntry> m_uniformTable;
+		std::unordered_map<std::string, BlockTableEntry> m_blockTable;
+
+		// location of active uniforms indexed by UniformID (-1 if not active)
+		std::vector<int> m_locations;
+
+		// (location, texture unit) pairs last assigned to sampler uniforms (see Material), sorted on location
+		std::vector<std::pair<int, unsigned int>> m_samplerUnits;
 	};
 
 	class Shader : public SharedHandle<ShaderMomory>
 	{
+		friend class ShaderBuildQueue;
+
 	public:
 		struct VarTableEntry
 		{
@@ -71,6 +107,19 @@ namespace xengine
 		// return location of uniform variable, -1 if not exist
 		int GetUniformLocation(const std::string& name);
 
+		// return location of uniform variable by interned name, -1 if not exist (no string work)
+		inline int GetUniformLocation(UniformID id) const
+		{
+			ready();
+			return id.Value() < m_ptr->m_locations.size() ? m_ptr->m_locations[id.Value()] : -1;
+		}
+
+		// return introspection of active uniform (including uniform block members), nullptr if not exist
+		const ShaderMomory::VarTableEntry* GetUniformInfo(const std::string& name) const;
+
+		// return introspection of active uniform block, nullptr if not exist
+		const ShaderMomory::BlockTableEntry* GetUniformBlockInfo(const std::string& name) const;
+
 		// set value to uniform variable
 		void SetUniform(const std::string& location, int   value);
 		void SetUniform(const std::string& location, bool  value);
@@ -85,18 +134,42 @@ namespace xengine
 		void SetUniform(const std::string& location, int size, const std::vector<glm::vec2>& values);
 		void SetUniform(const std::string& location, int size, const std::vector<glm::vec3>& values);
 		void SetUniform(const std::string& location, int size, const std::vector<glm::vec4>& values);
+		void SetUniform(const std::string& location, int size, const std::vector<glm::mat4>& values);
+		void SetUniform(const std::string& location, int size, const std::vector<int>& values);
+
+		// set value to uniform variable by interned name (preferred on per-draw paths)
+		void SetUniform(UniformID id, int   value);
+		void SetUniform(UniformID id, bool  value);
+		void SetUniform(UniformID id, float value);
+		void SetUniform(UniformID id, unsigned int value);
+		void SetUniform(UniformID id, const glm::vec2& value);
+		void SetUniform(UniformID id, const glm::vec3& value);
+		void SetUniform(UniformID id, const glm::vec4& value);
+		void SetUniform(UniformID id, const glm::mat2& value);
+		void SetUniform(UniformID id, const glm::mat3& value);
+		void SetUniform(UniformID id, const glm::mat4& value);
+		void SetUniform(UniformID id, int size, const std::vector<glm::vec2>& values);
+		void SetUniform(UniformID id, int size, const std::vector<glm::vec3>& values);
+		void SetUniform(UniformID id, int size, const std::vector<glm::vec4>& values);
+		void SetUniform(UniformID id, int size, const std::vector<glm::mat4>& values);
+		void SetUniform(UniformID id, int size, const std::vector<int>& values);
 
 		// generate program alone w/o linking attached shaders
 		void Generate();
 
-		// compile shader source and attach shader to the program
-		void AttachVertexShader(const std::string& source);   // compile a vertex shader and attach to the program
-		void AttachGeometryShader(const std::string& source); // compile a geometry shader and attach to the program
-		void AttachFragmentShader(const std::string& source); // compile a fragment shader and attach to the program
+		// attach shader source to the program (compiled at link)
+		void AttachVertexShader(const std::string& source);   // attach a vertex shader to the program
+		void AttachGeometryShader(const std::string& source); // attach a geometry shader to the program
+		void AttachFragmentShader(const std::string& source); // attach a fragment shader to the program
+		void AttachComputeShader(const std::string& source);  // attach a compute shader to the program (alone)
 
-		// link all attached shaders
+		// compile and link all attached shaders, or load the program binary if cached (see ProgramCache)
+		// compilation runs in background (see ShaderBuildQueue), the first use of the program waits for it
 		void Link();
 
+		// true if link is submitted but its result not checked yet
+		bool Pending() const { return m_ptr && m_ptr->m_pending; }
+
 		// generate shader program and link all attached shaders
 		void GenerateAndLink();
 
@@ -106,9 +179,30 @@ namespace xengine
 		// query active uniforms and store result to lookup hash table
 		void QueryActiveUniforms();
 
-		explicit operator bool() const { return m_ptr && m_ptr->m_id; }
+		// query active uniform blocks and store result to lookup hash table
+		void QueryActiveUniformBlocks();
+
+		// true if program is linked (waits for a pending link, a failed link deletes the program)
+		explicit operator bool() const { ready(); return m_ptr && m_ptr->m_id; }
+
+		// true if program is generated, without waiting for a pending link (e.g. right after loading)
+		bool Generated() const { return m_ptr && m_ptr->m_id; }
 
 		inline unsigned int ID() const { return m_ptr->m_id; }
+
+		// texture units assigned to sampler uniforms, so users sharing the program skip setting them again
+		inline const std::vector<std::pair<int, unsigned int>>& SamplerUnits() const { return m_ptr->m_samplerUnits; }
+		inline void SetSamplerUnits(const std::vector<std::pair<int, unsigned int>>& units) { m_ptr->m_samplerUnits = units; }
+
+	private:
+		// start compiling and linking without querying any status
+		void submit();
+
+		// wait for submitted link, report errors, cache binary and query program interface
+		void finish();
+
+		// finish pending link before the program is used
+		inline void ready() const { if (m_ptr && m_ptr->m_pending) const_cast<Shader*>(this)->finish(); }
 	};
 }
 
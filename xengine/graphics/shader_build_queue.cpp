@@ -0,0 +1,109 @@
+#include "shader_build_queue.h"
+
+#include <string>
+#include <chrono>
+#include <thread>
+
+#include <glad/glad.h>
+
+#include <utility/log.h>
+
+// GL_KHR_parallel_shader_compile is not part of core 4.3 (glad has no entry for it)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace xengine
+{
+	bool ShaderBuildQueue::g_parallel = false;
+	std::vector<Shader> ShaderBuildQueue::g_pending{};
+
+	void ShaderBuildQueue::Initialize()
+	{
+		int numExtensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+
+		for (int i = 0; i < numExtensions && !g_parallel; ++i)
+		{
+			const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			if (!name) continue;
+
+			std::string extension(name);
+			g_parallel = extension == "GL_KHR_parallel_shader_compile" || extension == "GL_ARB_parallel_shader_compile";
+		}
+
+		// drivers with the extension already default to as many compiler threads as they like,
+		// glMaxShaderCompilerThreadsKHR is only needed to lower it
+		Log::Message(std::string("[ShaderBuildQueue] Parallel shader compile ") + (g_parallel ? "supported" : "not supported"), Log::INFO);
+	}
+
+	void ShaderBuildQueue::Push(const Shader& shader)
+	{
+		if (shader.Pending()) g_pending.push_back(shader);
+	}
+
+	void ShaderBuildQueue::Flush()
+	{
+		if (g_pending.empty()) return;
+
+		auto start = std::chrono::steady_clock::now();
+		size_t numPrograms = g_pending.size();
+		size_t numCached = 0;
+
+		for (const Shader& shader : g_pending)
+		{
+			if (shader.m_ptr->m_cached) ++numCached;
+		}
+
+		std::vector<Shader> pending;
+		pending.swap(g_pending);
+
+		if (g_parallel)
+		{
+			// finish whatever the driver has completed, yield to its compiler threads otherwise
+			while (!pending.empty())
+			{
+				size_t remaining = 0;
+
+				for (size_t i = 0; i < pending.size(); ++i)
+				{
+					Shader& shader = pending[i];
+					int completed = GL_TRUE;
+
+					if (shader.Pending()) glGetProgramiv(shader.ID(), GL_COMPLETION_STATUS_KHR, &completed);
+
+					if (completed)
+					{
+						if (shader.Pending()) shader.finish();
+					}
+					else
+					{
+						if (remaining != i) pending[remaining] = shader; // handle assignment is not self-safe
+						++remaining;
+					}
+				}
+
+				pending.resize(remaining);
+
+				if (!pending.empty()) std::this_thread::yield();
+			}
+		}
+		else
+		{
+			// in submission order, the first status query waits while the later programs still compile
+			for (Shader& shader : pending)
+			{
+				if (shader.Pending()) shader.finish();
+			}
+		}
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		Log::Message("[ShaderBuildQueue] " + std::to_string(numPrograms) + " programs (" + std::to_string(numCached) +
+			" cached) finished in " + std::to_string(elapsed.count()) + " ms", Log::INFO);
+	}
+
+	void ShaderBuildQueue::Clear()
+	{
+		g_pending.clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef XE_SHADER_BUILD_QUEUE_H
+#define XE_SHADER_BUILD_QUEUE_H
+
+#include <vector>
+
+#include "shader.h"
+
+namespace xengine
+{
+	// programs whose compile and link were submitted but not checked yet
+	// Shader::Link only submits work, statuses are queried here in one go, so the driver compiles
+	// programs in background (GL_KHR_parallel_shader_compile) or at least between submissions.
+	// A program used before flush finishes on its own (see Shader::ready).
+	class ShaderBuildQueue
+	{
+	public:
+		// detect parallel compile extension
+		static void Initialize();
+
+		// queue a submitted program
+		static void Push(const Shader& shader);
+
+		// finish all queued programs (in completion order if driver reports it), report timing
+		static void Flush();
+
+		static bool Parallel() { return g_parallel; }
+
+		static void Clear();
+
+	private:
+		static bool g_parallel; // driver has KHR (or ARB) parallel shader compile
+		static std::vector<Shader> g_pending;
+	};
+}
+
+#endif // !XE_SHADER_BUILD_QUEUE_H
@@ -2,6 +2,8 @@
 
 #include <string>
 #include <fstream>
+#include <filesystem>
+#include <unordered_map>
 
 #include <glad/glad.h>
 
@@ -11,14 +13,33 @@ namespace xengine
 {
 	unsigned int CreateShader(const std::string & source, unsigned int type)
 	{
-		int status;
-		char log[1024];
+		unsigned int shader_id = SubmitShader(source, type);
+
+		if (!CheckShader(shader_id, type))
+		{
+			glDeleteShader(shader_id);
+			shader_id = 0;
+		}
+
+		return shader_id;
+	}
+
+	unsigned int SubmitShader(const std::string & source, unsigned int type)
+	{
 		const char *src_c = source.c_str();
 
 		unsigned int shader_id = glCreateShader(type);
 		glShaderSource(shader_id, 1, &src_c, NULL);
 		glCompileShader(shader_id);
 
+		return shader_id;
+	}
+
+	bool CheckShader(unsigned int shader_id, unsigned int type)
+	{
+		int status;
+		char log[1024];
+
 		glGetShaderiv(shader_id, GL_COMPILE_STATUS, &status);
 		if (!status)
 		{
@@ -35,15 +56,15 @@ namespace xengine
 			case GL_FRAGMENT_SHADER:
 				Log::Message("[ShaderLoader] Fragment shader compilation error!\n" + std::string(log), Log::ERROR);
 				break;
+			case GL_COMPUTE_SHADER:
+				Log::Message("[ShaderLoader] Compute shader compilation error!\n" + std::string(log), Log::ERROR);
+				break;
 			default:
 				break;
 			}
-
-			glDeleteShader(shader_id);
-			shader_id = 0;
 		}
 
-		return shader_id;
+		return status != 0;
 	}
 
 	unsigned int CreateVertexShader(const std::string & source, unsigned int type)
@@ -61,8 +82,25 @@ namespace xengine
 		return CreateShader(source, GL_FRAGMENT_SHADER);
 	}
 
+	unsigned int CreateComputeShader(const std::string & source, unsigned int type)
+	{
+		return CreateShader(source, GL_COMPUTE_SHADER);
+	}
+
+	namespace
+	{
+		// expanded source of every file read so far (keyed by normalized path), shared by all includers
+		std::unordered_map<std::string, std::string> g_sources;
+	}
+
 	std::string ReadShaderSource(const std::string& path)
 	{
+		// "a/b/../c.glsl" and "a/c.glsl" are the same file
+		std::string key = std::filesystem::path(path).lexically_normal().generic_string();
+
+		auto it = g_sources.find(key);
+		if (it != g_sources.end()) return it->second;
+
 		std::string directory = path.substr(0, path.find_last_of("/\\"));
 		std::string source{}, line;
 		std::ifstream in(path, std::ios::in);
@@ -87,9 +125,16 @@ namespace xengine
 			}
 		}
 
+		g_sources[key] = source;
+
 		return source;
 	}
 
+	void ClearShaderSources()
+	{
+		g_sources.clear();
+	}
+
 	std::string InsertShaderDefine(const std::string & source, const std::vector<std::string>& defines)
 	{
 		if (defines.size() == 0) return source;
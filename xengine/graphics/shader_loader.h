@@ -12,6 +12,12 @@ namespace xengine
 	// create a shader of TYPE
 	unsigned int CreateShader(const std::string& source, unsigned int type);
 
+	// start compiling a shader of TYPE without waiting for the result
+	unsigned int SubmitShader(const std::string& source, unsigned int type);
+
+	// wait for compilation of a submitted shader, log errors, return true if it compiled
+	bool CheckShader(unsigned int shader, unsigned int type);
+
 	// compile a vertex shader
 	unsigned int CreateVertexShader(const std::string& source, unsigned int type);
 
@@ -21,9 +27,16 @@ namespace xengine
 	// compile a fragment shader
 	unsigned int CreateFragmentShader(const std::string& source, unsigned int type);
 
+	// compile a compute shader
+	unsigned int CreateComputeShader(const std::string& source, unsigned int type);
+
 	// read shader source from file (if include exists, read included files recursively)
+	// every file is read once, later reads (e.g. of common includes) return the memoized source
 	std::string ReadShaderSource(const std::string& path);
 
+	// forget memoized sources (e.g. to pick up edited files)
+	void ClearShaderSources();
+
 	// insert precompile flag to shader source
 	std::string InsertShaderDefine(const std::string& source, const std::vector<std::string>& defines);
 
@@ -8,6 +8,8 @@ namespace xengine
 {
 	std::unordered_map<std::string, Shader> ShaderManager::g_localTable{};
 	std::unordered_map<std::string, Shader> ShaderManager::g_globalTable{};
+	std::unordered_map<unsigned int, ShaderManager::Recipe> ShaderManager::g_recipes{};
+	std::unordered_map<unsigned int, Shader> ShaderManager::g_instancedTable{};
 
 	void ShaderManager::Initialize()
 	{
@@ -17,17 +19,63 @@ namespace xengine
 	{
 		ClearLocal();
 		ClearGlobal();
+		ClearShaderSources();
 	}
 
 	void ShaderManager::ClearLocal()
 	{
+		dropVariants(g_localTable);
 		g_localTable.clear();
 	}
 
 	void ShaderManager::ClearGlobal()
 	{
+		dropVariants(g_globalTable);
 		g_globalTable.clear();
 	}
+
+	void ShaderManager::dropVariants(const std::unordered_map<std::string, Shader>& table)
+	{
+		// program ids can be reused by new programs once these shaders are released
+		for (const auto& mp : table)
+		{
+			g_recipes.erase(mp.second.ID());
+			g_instancedTable.erase(mp.second.ID());
+		}
+	}
+
+	Shader ShaderManager::GetInstanced(const Shader& shader)
+	{
+		if (!shader) return Shader();
+
+		auto it = g_instancedTable.find(shader.ID());
+		if (it != g_instancedTable.end()) return it->second;
+
+		Shader variant;
+		auto itr = g_recipes.find(shader.ID());
+
+		// only sources written for instancing get a variant
+		if (itr != g_recipes.end() && ReadShaderSource(itr->second.vsPath).find("INSTANCED") != std::string::npos)
+		{
+			const Recipe& recipe = itr->second;
+
+			std::vector<std::string> defines = recipe.defines;
+			defines.push_back("INSTANCED");
+
+			if (recipe.gsPath.empty())
+				variant = LoadShaderVF(recipe.vsPath, recipe.fsPath, defines);
+			else
+				variant = LoadShaderVGF(recipe.vsPath, recipe.gsPath, recipe.fsPath, defines);
+
+			if (!variant)
+				Log::Message("[ShaderManager] Instanced variant of \"" + recipe.vsPath + "\" loading failed", Log::WARN);
+		}
+
+		// cache failures too, so sources are not read again
+		g_instancedTable[shader.ID()] = variant;
+
+		return variant;
+	}
 	
 	Shader ShaderManager::Get(const std::string& name)
 	{
@@ -84,13 +132,15 @@ namespace xengine
 
 		Shader shader = LoadShaderVF(vsPath, fsPath, defines);
 
-		if (!shader)
+		// link result is checked by ShaderBuildQueue, loading does not wait for it
+		if (!shader.Generated())
 		{
 			Log::Message("[ShaderManager] Shader \"" + name + "\" loading failed", Log::ERROR);
 			return Shader();
 		}
 
 		table[name] = shader;
+		g_recipes[shader.ID()] = { vsPath, "", fsPath, defines };
 
 		Log::Message("[ShaderManager] Shader \"" + name + "\" loaded successfully", Log::INFO);
 
@@ -112,13 +162,15 @@ namespace xengine
 
 		Shader shader = LoadShaderVGF(vsPath, gsPath, fsPath, defines);
 
-		if (!shader)
+		// link result is checked by ShaderBuildQueue, loading does not wait for it
+		if (!shader.Generated())
 		{
 			Log::Message("[ShaderManager] Shader \"" + name + "\" loading failed", Log::ERROR);
 			return Shader();
 		}
 
 		table[name] = shader;
+		g_recipes[shader.ID()] = { vsPath, gsPath, fsPath, defines };
 
 		Log::Message("[ShaderManager] Shader \"" + name + "\" loaded successfully", Log::INFO);
 
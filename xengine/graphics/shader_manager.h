@@ -29,6 +29,10 @@ namespace xengine
 		// get a named shader
 		static Shader Get(const std::string& name);
 
+		// variant of a managed shader compiled with INSTANCED defined (per-instance model matrices)
+		// return an invalid shader if sources do not support instancing
+		static Shader GetInstanced(const Shader& shader);
+
 		// register a named shader into global resource
 		static void RegisterGlobalShader(const std::string & name, const Shader& shader);
 
@@ -78,7 +82,24 @@ namespace xengine
 			const std::string& fsPath,
 			const std::vector<std::string>& defines = {});
 
+		// forget recipes and variants of shaders in a table being cleared
+		static void dropVariants(const std::unordered_map<std::string, Shader>& table);
+
 	private:
+		struct Recipe
+		{
+			std::string vsPath;
+			std::string gsPath; // empty if no geometry shader
+			std::string fsPath;
+			std::vector<std::string> defines;
+		};
+
+		// how each loaded program was built (keyed by program id)
+		static std::unordered_map<unsigned int, Recipe> g_recipes;
+
+		// instanced variants (keyed by program id of original shader)
+		static std::unordered_map<unsigned int, Shader> g_instancedTable;
+
 		// local lookup tables
 		static std::unordered_map<std::string, Shader> g_localTable;
 
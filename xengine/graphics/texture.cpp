@@ -1,11 +1,27 @@
 #include "texture.h"
 
+#include <algorithm>
+
 #include <glad/glad.h>
 
 #include <utility/log.h>
 
+#include "ogl_status.h"
+#include "texture_compressor.h"
+
 namespace xengine
 {
+	namespace
+	{
+		// number of mipmap levels down to 1x1
+		unsigned int numLevels(unsigned int width, unsigned int height, bool mipmap)
+		{
+			unsigned int levels = 1;
+			if (mipmap) for (unsigned int size = std::max(width, height); size > 1; size >>= 1) ++levels;
+			return levels;
+		}
+	}
+
 	////////////////////////////////////////////////////////////////
 	// Texture Unique Instance
 	////////////////////////////////////////////////////////////////
@@ -43,9 +59,27 @@ namespace xengine
 		if (m_id)
 		{
 			Log::Message("[TextureMemory] Texture " + std::to_string(m_id) + " deleted", Log::DEBUG);
+			OglStatus::ForgetTexture(m_id);
 			glDeleteTextures(1, &m_id);
 			m_id = 0;
 		}
+
+		// release array of a pooled texture (other layers may still hold it)
+		if (array)
+		{
+			if (ownsLayer) array->freeLayers.push_back(layer);
+			ownsLayer = false;
+
+			array->DecreaseReference();
+
+			if (array->ReferenceCount() == 0)
+			{
+				array->Destory();
+				delete array;
+			}
+
+			array = nullptr;
+		}
 	}
 	
 	////////////////////////////////////////////////////////////////
@@ -54,19 +88,19 @@ namespace xengine
 
 	void Texture::Bind(int unit)
 	{
-		if (unit >= 0) glActiveTexture(GL_TEXTURE0 + unit);
-		glBindTexture(m_ptr->target, m_ptr->m_id);
+		if (unit >= 0) OglStatus::ActiveTexture(unit);
+		OglStatus::BindTexture(m_ptr->target, m_ptr->m_id);
 	}
 
 	void Texture::Bind(int unit) const
 	{
-		if (unit >= 0) glActiveTexture(GL_TEXTURE0 + unit);
-		glBindTexture(m_ptr->target, m_ptr->m_id);
+		if (unit >= 0) OglStatus::ActiveTexture(unit);
+		OglStatus::BindTexture(m_ptr->target, m_ptr->m_id);
 	}
 
 	void Texture::Unbind() const
 	{
-		glBindTexture(m_ptr->target, 0);
+		OglStatus::BindTexture(m_ptr->target, 0);
 	}
 
 	void Texture::Resize(unsigned int width, unsigned int height, unsigned int depth)
@@ -75,6 +109,13 @@ namespace xengine
 
 		if (m_ptr->m_id == 0) return;
 
+		// pooled textures are views of immutable storage
+		if (m_ptr->array)
+		{
+			Log::Message("[Texture] Texture " + std::to_string(m_ptr->m_id) + " is pooled in a texture array and can't be resized", Log::WARN);
+			return;
+		}
+
 		m_ptr->width = width;
 		m_ptr->height = height;
 		m_ptr->depth = depth;
@@ -142,6 +183,42 @@ namespace xengine
 		Unbind();
 	}
 
+	void Texture::GenerateCompressed2D(unsigned int width, unsigned int height, unsigned int compressedFormat, unsigned int levels, const void* data)
+	{
+		generate();
+
+		m_ptr->target = GL_TEXTURE_2D;
+		m_ptr->width = width;
+		m_ptr->height = height;
+		m_ptr->colorFormat = compressedFormat;
+		m_ptr->pixelFormat = compressedFormat;
+		m_ptr->dataType = GL_UNSIGNED_BYTE;
+
+		// compressed formats can't generate mipmaps, they come along or there are none
+		m_ptr->mipmapping = levels == numLevels(width, height, true);
+
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+		Bind();
+
+		for (unsigned int level = 0; level < levels; ++level)
+		{
+			int w = static_cast<int>(std::max(width >> level, 1u));
+			int h = static_cast<int>(std::max(height >> level, 1u));
+			size_t size = TextureCompressor::LevelSize(compressedFormat, w, h);
+
+			glCompressedTexImage2D(m_ptr->target, level, compressedFormat, w, h, 0, static_cast<GLsizei>(size), bytes);
+			if (bytes) bytes += size;
+		}
+
+		glTexParameteri(m_ptr->target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_MIN_FILTER, m_ptr->filterMin);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_MAG_FILTER, m_ptr->filterMax);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_WRAP_S, m_ptr->wrapS);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_WRAP_T, m_ptr->wrapT);
+		Unbind();
+	}
+
 	void Texture::Generate3D(unsigned int width, unsigned int height, unsigned int depth, unsigned int colorFormat, unsigned int pixelFormat, unsigned int data_type, void * data)
 	{
 		generate();
@@ -165,6 +242,156 @@ namespace xengine
 		Unbind();
 	}
 
+	void Texture::Generate2DArray(unsigned int width, unsigned int height, unsigned int layers, unsigned int colorFormat, bool mipmap)
+	{
+		generate();
+
+		m_ptr->target = GL_TEXTURE_2D_ARRAY;
+		m_ptr->width = width;
+		m_ptr->height = height;
+		m_ptr->depth = layers;
+		m_ptr->colorFormat = colorFormat;
+		m_ptr->mipmapping = mipmap;
+
+		Bind();
+		glTexStorage3D(m_ptr->target, numLevels(width, height, mipmap), colorFormat, width, height, layers);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_MIN_FILTER, m_ptr->filterMin);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_MAG_FILTER, m_ptr->filterMax);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_WRAP_S, m_ptr->wrapS);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_WRAP_T, m_ptr->wrapT);
+		Unbind();
+	}
+
+	bool Texture::MoveToArray(const Texture& array, unsigned int layer)
+	{
+		if (!m_ptr || !m_ptr->m_id || m_ptr->target != GL_TEXTURE_2D || m_ptr->array) return false;
+		if (!array || array.Target() != GL_TEXTURE_2D_ARRAY || layer >= array.Depth()) return false;
+
+		unsigned int levels = numLevels(m_ptr->width, m_ptr->height, array.Mipmap());
+
+		// all levels are copied on GPU, mipmaps of texture were generated along with it
+		for (unsigned int level = 0; level < levels; ++level)
+		{
+			int width = static_cast<int>(std::max(m_ptr->width >> level, 1u));
+			int height = static_cast<int>(std::max(m_ptr->height >> level, 1u));
+			glCopyImageSubData(m_ptr->m_id, GL_TEXTURE_2D, level, 0, 0, 0, array.ID(), GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1);
+		}
+
+		unsigned int view = 0;
+		glGenTextures(1, &view);
+		glTextureView(view, GL_TEXTURE_2D, array.ID(), array.ColorFormat(), 0, levels, layer, 1);
+
+		OglStatus::ForgetTexture(m_ptr->m_id);
+		glDeleteTextures(1, &m_ptr->m_id);
+
+		m_ptr->m_id = view;
+		m_ptr->colorFormat = array.ColorFormat();
+		m_ptr->array = array.m_ptr;
+		m_ptr->array->IncreaseReference();
+		m_ptr->layer = layer;
+		m_ptr->ownsLayer = true;
+
+		// layer may have been given back by a former texture
+		std::vector<unsigned int>& freeLayers = array.m_ptr->freeLayers;
+		freeLayers.erase(std::remove(freeLayers.begin(), freeLayers.end(), layer), freeLayers.end());
+
+		// a view carries its own sampling state
+		Bind();
+		glTexParameteri(m_ptr->target, GL_TEXTURE_MIN_FILTER, m_ptr->filterMin);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_MAG_FILTER, m_ptr->filterMax);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_WRAP_S, m_ptr->wrapS);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_WRAP_T, m_ptr->wrapT);
+		Unbind();
+
+		return true;
+	}
+
+	bool Texture::FreeLayer(unsigned int& layer) const
+	{
+		if (!m_ptr || m_ptr->freeLayers.empty()) return false;
+
+		layer = m_ptr->freeLayers.back();
+		return true;
+	}
+
+	void Texture::BindArray(int unit) const
+	{
+		if (unit >= 0) OglStatus::ActiveTexture(unit);
+		OglStatus::BindTexture(GL_TEXTURE_2D_ARRAY, Pooled() ? m_ptr->array->m_id : 0);
+	}
+
+	bool Texture::ViewLayerOf(const Texture& pooled)
+	{
+		allocateMemory();
+
+		if (m_ptr->m_id || !pooled.Pooled()) return false;
+
+		const TextureMemory& src = *pooled.m_ptr;
+
+		glGenTextures(1, &m_ptr->m_id);
+		glTextureView(m_ptr->m_id, GL_TEXTURE_2D, src.array->m_id, src.colorFormat, 0, numLevels(src.width, src.height, src.array->mipmapping), src.layer, 1);
+
+		m_ptr->target = GL_TEXTURE_2D;
+		m_ptr->width = src.width;
+		m_ptr->height = src.height;
+		m_ptr->colorFormat = src.colorFormat;
+		m_ptr->pixelFormat = src.pixelFormat;
+		m_ptr->dataType = src.dataType;
+		m_ptr->filterMin = src.filterMin;
+		m_ptr->filterMax = src.filterMax;
+		m_ptr->wrapS = src.wrapS;
+		m_ptr->wrapT = src.wrapT;
+		m_ptr->wrapR = src.wrapR;
+		m_ptr->mipmapping = src.mipmapping;
+		m_ptr->array = src.array;
+		m_ptr->array->IncreaseReference();
+		m_ptr->layer = src.layer;
+		m_ptr->ownsLayer = false; // layer stays with pooled
+
+		Bind();
+		glTexParameteri(m_ptr->target, GL_TEXTURE_MIN_FILTER, m_ptr->filterMin);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_MAG_FILTER, m_ptr->filterMax);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_WRAP_S, m_ptr->wrapS);
+		glTexParameteri(m_ptr->target, GL_TEXTURE_WRAP_T, m_ptr->wrapT);
+		Unbind();
+
+		return true;
+	}
+
+	void Texture::Replace(Texture& other)
+	{
+		allocateMemory();
+
+		if (!other.m_ptr || other.m_ptr == m_ptr) return;
+
+		m_ptr->Destory();
+
+		TextureMemory& src = *other.m_ptr;
+
+		m_ptr->m_id = src.m_id;
+		m_ptr->target = src.target;
+		m_ptr->width = src.width;
+		m_ptr->height = src.height;
+		m_ptr->depth = src.depth;
+		m_ptr->colorFormat = src.colorFormat;
+		m_ptr->pixelFormat = src.pixelFormat;
+		m_ptr->dataType = src.dataType;
+		m_ptr->filterMin = src.filterMin;
+		m_ptr->filterMax = src.filterMax;
+		m_ptr->wrapS = src.wrapS;
+		m_ptr->wrapT = src.wrapT;
+		m_ptr->wrapR = src.wrapR;
+		m_ptr->mipmapping = src.mipmapping;
+		m_ptr->array = src.array; // reference moves along
+		m_ptr->layer = src.layer;
+		m_ptr->ownsLayer = src.ownsLayer;
+		++m_ptr->revision;
+
+		src.m_id = 0;
+		src.array = nullptr;
+		src.ownsLayer = false;
+	}
+
 	void Texture::GenerateCube(unsigned int width, unsigned int height, unsigned int format, unsigned int data_type, bool mipmap)
 	{
 		generate();
@@ -307,6 +534,7 @@ namespace xengine
 			SetWrapS(wrapMode);
 			break;
 		case GL_TEXTURE_2D:
+		case GL_TEXTURE_2D_ARRAY:
 			SetWrapS(wrapMode);
 			SetWrapT(wrapMode);
 			break;
@@ -2,6 +2,8 @@
 #ifndef XE_TEXTURE_H
 #define XE_TEXTURE_H
 
+#include <vector>
+
 #include <utility/smart_handle.h>
 
 namespace xengine
@@ -29,6 +31,17 @@ namespace xengine
 		unsigned int wrapT;       // wrapping method of the T coordinate
 		unsigned int wrapR;       // wrapping method of the R coordinate
 		bool mipmapping;
+
+		// 2D texture pooled into a layer of a 2D array texture (texture object is a view of that layer)
+		TextureMemory* array = nullptr; // holds a reference to the array
+		unsigned int layer = 0;
+		bool ownsLayer = false; // layer is given back to array on destruction (false for extra views of it)
+
+		// layers of a 2D array texture given back by destroyed textures, reused by later ones
+		std::vector<unsigned int> freeLayers;
+
+		// bumped whenever storage is replaced (e.g. streamed texture swapped in), so users can refresh layer
+		unsigned int revision = 0;
 	};
 
 	class Texture : public SharedHandle<TextureMemory>
@@ -50,9 +63,33 @@ namespace xengine
 		// generate a 2D texture, allocate memory
 		void Generate2D(unsigned int width, unsigned int height, unsigned int colorFormat, unsigned int pixelFormat, unsigned int data_type, void* data);
 
+		// generate a 2D texture of a block-compressed format from levels stored back to back in data
+		// (largest first, all of them down to 1x1 for mipmapping, content left undefined if data is null)
+		void GenerateCompressed2D(unsigned int width, unsigned int height, unsigned int compressedFormat, unsigned int levels, const void* data);
+
 		// generate a 3D texture, allocate memory
 		void Generate3D(unsigned int width, unsigned int height, unsigned int depth, unsigned int colorFormat, unsigned int pixelFormat, unsigned int data_type, void* data);
 
+		// generate a 2D array texture of immutable storage (colorFormat must be sized), content is left undefined
+		void Generate2DArray(unsigned int width, unsigned int height, unsigned int layers, unsigned int colorFormat, bool mipmap);
+
+		// copy content of 2D texture into a layer of a 2D array texture of the same size, format and mipmapping,
+		// then turn texture into a view of that layer (its own storage is released, it can't be regenerated)
+		// the layer is given back to array once texture is destroyed (see FreeLayer)
+		bool MoveToArray(const Texture& array, unsigned int layer);
+
+		// a layer of a 2D array texture given back by a destroyed pooled texture, false if there is none
+		bool FreeLayer(unsigned int& layer) const;
+
+		// bind 2D array texture holding this texture (nothing if texture is not pooled)
+		void BindArray(int unit = -1) const;
+
+		// turn an empty texture into another view of the array layer holding a pooled texture (content is shared)
+		bool ViewLayerOf(const Texture& pooled);
+
+		// take over storage of other (left empty), all handles of this texture see the new content
+		void Replace(Texture& other);
+
 		// generate a cubic texture, allocate memory
 		void GenerateCube(unsigned int width, unsigned int height, unsigned int format, unsigned int data_type, bool mipmap);
 
@@ -75,12 +112,17 @@ namespace xengine
 		inline unsigned int Width() const { return m_ptr->width; }
 		inline unsigned int Height() const { return m_ptr->height; }
 		inline unsigned int Depth() const { return m_ptr->depth; }
+		inline unsigned int ColorFormat() const { return m_ptr->colorFormat; }
 		inline unsigned int FilterMin() const { return m_ptr->filterMin; }
 		inline unsigned int FilterMax() const { return m_ptr->filterMax; }
 		inline unsigned int WrapS() const { return m_ptr->wrapS; }
 		inline unsigned int WrapT() const { return m_ptr->wrapT; }
 		inline unsigned int WrapR() const { return m_ptr->wrapR; }
 		inline bool Mipmap() const { return m_ptr->mipmapping; }
+		inline bool Pooled() const { return m_ptr && m_ptr->array; }
+		inline unsigned int Layer() const { return m_ptr->layer; }
+		inline unsigned int ArrayID() const { return m_ptr->array ? m_ptr->array->m_id : 0; }
+		inline unsigned int Revision() const { return m_ptr ? m_ptr->revision : 0; }
 	};
 
 	using CubeMap = Texture;
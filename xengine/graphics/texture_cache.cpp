@@ -0,0 +1,185 @@
+#include "texture_cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+
+#include <utility/log.h>
+#include <utility/hash.h>
+#include <utility/file_system.h>
+#include <utility/mapped_file.h>
+
+#include "texture_loader.h"
+#include "texture_compressor.h"
+
+namespace xengine
+{
+	bool TextureCache::g_enabled = false;
+	std::string TextureCache::g_directory{};
+	std::atomic<unsigned int> TextureCache::g_hits{ 0 };
+	std::atomic<unsigned int> TextureCache::g_misses{ 0 };
+
+	namespace
+	{
+		// bump when file layout or encoders change
+		const unsigned int kMagic = 0x31435458; // "XTC1"
+
+		struct FileHeader
+		{
+			unsigned int magic;
+			unsigned int format; // compressed GL format
+			int width;
+			int height;
+			int components; // of source image
+			int levels;
+			unsigned long long key; // guards against hash collisions in file names
+			unsigned long long size; // in bytes, all levels
+		};
+
+		std::atomic<unsigned int> g_tempId{ 0 };
+
+		size_t chainSize(unsigned int format, int width, int height, int levels)
+		{
+			size_t size = 0;
+
+			for (int level = 0; level < levels; ++level)
+				size += TextureCompressor::LevelSize(format, std::max(width >> level, 1), std::max(height >> level, 1));
+
+			return size;
+		}
+	}
+
+	void TextureCache::Initialize(const std::string& directory)
+	{
+		if (!FileSystem::CreateDirectories(directory))
+		{
+			Log::Message("[TextureCache] Cannot create cache directory \"" + directory + "\", cache disabled", Log::WARN);
+			return;
+		}
+
+		g_directory = directory;
+		g_enabled = true;
+
+		Log::Message("[TextureCache] Compressed textures cached in \"" + directory + "\"", Log::INFO);
+	}
+
+	bool TextureCache::Key(const std::string& path, unsigned int format, unsigned long long& key)
+	{
+		MappedFile source;
+		if (!source.Open(path)) return false;
+
+		key = hash::fnv1a64(&kMagic, sizeof(kMagic));
+		key = hash::fnv1a64(&format, sizeof(format), key);
+		key = hash::fnv1a64(source.Data(), source.Size(), key);
+
+		return true;
+	}
+
+	bool TextureCache::Load(unsigned long long key, TextureImage& image)
+	{
+		if (!g_enabled) return false;
+
+		std::string file = path(key);
+		std::ifstream in(file, std::ios::in | std::ios::binary);
+
+		if (!in)
+		{
+			++g_misses;
+			return false;
+		}
+
+		FileHeader header{};
+		in.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		bool valid = in && header.magic == kMagic && header.key == key && TextureCompressor::IsCompressed(header.format) &&
+			header.width > 0 && header.height > 0 && header.levels > 0 && header.levels <= 32 &&
+			header.size == chainSize(header.format, header.width, header.height, header.levels);
+
+		// size must match the rest of the file, a damaged header never drives the allocation
+		if (valid)
+		{
+			std::streamoff start = in.tellg();
+			in.seekg(0, std::ios::end);
+			valid = in.tellg() - start == static_cast<std::streamoff>(header.size);
+			in.seekg(start);
+		}
+
+		if (valid)
+		{
+			image.data.resize(header.size);
+			in.read(reinterpret_cast<char*>(image.data.data()), header.size);
+			valid = in.gcount() == static_cast<std::streamsize>(header.size);
+		}
+
+		in.close();
+
+		if (!valid)
+		{
+			Log::Message("[TextureCache] Cached texture \"" + file + "\" corrupted, compressing again", Log::WARN);
+			image.data.clear();
+			std::remove(file.c_str());
+			++g_misses;
+			return false;
+		}
+
+		image.width = header.width;
+		image.height = header.height;
+		image.components = header.components;
+		image.compressedFormat = header.format;
+		image.levels = header.levels;
+
+		++g_hits;
+		return true;
+	}
+
+	void TextureCache::Store(unsigned long long key, const TextureImage& image)
+	{
+		if (!g_enabled || !image.compressedFormat) return;
+
+		FileHeader header{ kMagic, image.compressedFormat, image.width, image.height, image.components, image.levels, key, image.data.size() };
+
+		// write whole file under a temporary name, a crash never leaves a truncated texture behind
+		std::string file = path(key);
+		std::string temp = file + "." + std::to_string(g_tempId++) + ".tmp";
+
+		{
+			std::ofstream out(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!out) return;
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(image.data.data()), image.data.size());
+
+			if (!out)
+			{
+				out.close();
+				std::remove(temp.c_str());
+				return;
+			}
+		}
+
+		std::remove(file.c_str());
+
+		if (std::rename(temp.c_str(), file.c_str()) != 0)
+		{
+			Log::Message("[TextureCache] Cannot write \"" + file + "\"", Log::WARN);
+			std::remove(temp.c_str());
+		}
+	}
+
+	void TextureCache::Clear()
+	{
+		if (g_enabled)
+			Log::Message("[TextureCache] " + std::to_string(g_hits) + " textures loaded from cache, " + std::to_string(g_misses) + " compressed", Log::INFO);
+
+		g_enabled = false;
+		g_hits = 0;
+		g_misses = 0;
+	}
+
+	std::string TextureCache::path(unsigned long long key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.xtc", key);
+		return g_directory + "/" + name;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#ifndef XE_TEXTURE_CACHE_H
+#define XE_TEXTURE_CACHE_H
+
+#include <atomic>
+#include <string>
+
+namespace xengine
+{
+	struct TextureImage;
+
+	// on-disk cache of block-compressed textures (see TextureCompressor)
+	// A texture is keyed by a hash of its source file and the compressed format, the file holds the whole
+	// mip chain ready for upload, so later runs skip decoding and encoding.
+	class TextureCache
+	{
+	public:
+		// open cache directory (created if missing)
+		static void Initialize(const std::string& directory = "cache/textures");
+
+		// key of an image file compressed to format, return false if file cannot be read
+		static bool Key(const std::string& path, unsigned int format, unsigned long long& key);
+
+		// read compressed image of key (any thread)
+		static bool Load(unsigned long long key, TextureImage& image);
+
+		// write compressed image under key (any thread)
+		static void Store(unsigned long long key, const TextureImage& image);
+
+		static bool Enabled() { return g_enabled; }
+
+		static void Clear();
+
+	private:
+		static std::string path(unsigned long long key);
+
+	private:
+		static bool g_enabled;
+		static std::string g_directory;
+
+		static std::atomic<unsigned int> g_hits;
+		static std::atomic<unsigned int> g_misses;
+	};
+}
+
+#endif // !XE_TEXTURE_CACHE_H
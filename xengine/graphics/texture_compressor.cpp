@@ -0,0 +1,518 @@
+#include "texture_compressor.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include <utility/log.h>
+#include <utility/job_system.h>
+
+// S3TC formats are extensions, not part of core 4.3 (glad has no entry for them)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace xengine
+{
+	bool TextureCompressor::g_enabled = true;
+	bool TextureCompressor::g_s3tc = false;
+	bool TextureCompressor::g_s3tcSrgb = false;
+
+	namespace
+	{
+		// rows of blocks encoded by a job at least
+		const size_t kRowsPerJob = 4;
+
+		// 4x4 texels, row by row
+		struct Block
+		{
+			float texels[16][4];
+		};
+
+		// principal axis of the first channels of a block (power iteration on covariance), returns mean
+		void principalAxis(const Block& block, int channels, float mean[3], float axis[3])
+		{
+			float lo[3] = { 1e30f, 1e30f, 1e30f }, hi[3] = { -1e30f, -1e30f, -1e30f };
+
+			for (int c = 0; c < channels; ++c) mean[c] = 0.0f;
+
+			for (const float* t : block.texels)
+			{
+				for (int c = 0; c < channels; ++c)
+				{
+					mean[c] += t[c] / 16.0f;
+					lo[c] = std::min(lo[c], t[c]);
+					hi[c] = std::max(hi[c], t[c]);
+				}
+			}
+
+			float cov[3][3] = {};
+
+			for (const float* t : block.texels)
+			{
+				for (int i = 0; i < channels; ++i)
+					for (int j = 0; j < channels; ++j)
+						cov[i][j] += (t[i] - mean[i]) * (t[j] - mean[j]);
+			}
+
+			// start from diagonal of bounding box, converges in a few steps
+			for (int c = 0; c < channels; ++c) axis[c] = hi[c] - lo[c];
+
+			for (int step = 0; step < 8; ++step)
+			{
+				float v[3] = {};
+				float length = 0.0f;
+
+				for (int i = 0; i < channels; ++i)
+				{
+					for (int j = 0; j < channels; ++j) v[i] += cov[i][j] * axis[j];
+					length += v[i] * v[i];
+				}
+
+				if (length <= 1e-12f) break;
+
+				length = std::sqrt(length);
+				for (int c = 0; c < channels; ++c) axis[c] = v[c] / length;
+			}
+
+			float length = 0.0f;
+			for (int c = 0; c < channels; ++c) length += axis[c] * axis[c];
+
+			length = std::sqrt(length);
+			for (int c = 0; c < channels; ++c) axis[c] = length > 0.0f ? axis[c] / length : 0.0f;
+		}
+
+		// block endpoints at the extremes of texels projected onto principal axis
+		void endpoints(const Block& block, int channels, float end0[3], float end1[3])
+		{
+			float mean[3], axis[3];
+			principalAxis(block, channels, mean, axis);
+
+			float lo = 0.0f, hi = 0.0f;
+
+			for (const float* t : block.texels)
+			{
+				float d = 0.0f;
+				for (int c = 0; c < channels; ++c) d += (t[c] - mean[c]) * axis[c];
+				lo = std::min(lo, d);
+				hi = std::max(hi, d);
+			}
+
+			for (int c = 0; c < channels; ++c)
+			{
+				end0[c] = mean[c] + axis[c] * hi;
+				end1[c] = mean[c] + axis[c] * lo;
+			}
+		}
+
+		void fetchBlock(const unsigned char* pixels, int components, int width, int height, int bx, int by, Block& block)
+		{
+			for (int y = 0; y < 4; ++y)
+			{
+				for (int x = 0; x < 4; ++x)
+				{
+					// edges of levels smaller than a block repeat
+					int sx = std::min(bx * 4 + x, width - 1);
+					int sy = std::min(by * 4 + y, height - 1);
+					const unsigned char* p = pixels + (static_cast<size_t>(sy) * width + sx) * components;
+					float* t = block.texels[y * 4 + x];
+
+					t[0] = p[0];
+					t[1] = components > 1 ? p[1] : 0.0f;
+					t[2] = components > 2 ? p[2] : 0.0f;
+					t[3] = components > 3 ? p[3] : 255.0f;
+				}
+			}
+		}
+
+		unsigned int to565(const float color[3])
+		{
+			auto quantize = [](float value, int bits)
+			{
+				int max = (1 << bits) - 1;
+				return static_cast<unsigned int>(std::min(std::max(static_cast<int>(value / 255.0f * max + 0.5f), 0), max));
+			};
+
+			return (quantize(color[0], 5) << 11) | (quantize(color[1], 6) << 5) | quantize(color[2], 5);
+		}
+
+		void from565(unsigned int color, float rgb[3])
+		{
+			unsigned int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+			rgb[0] = static_cast<float>((r << 3) | (r >> 2));
+			rgb[1] = static_cast<float>((g << 2) | (g >> 4));
+			rgb[2] = static_cast<float>((b << 3) | (b >> 2));
+		}
+
+		void write(unsigned char* out, uint64_t value, int bytes)
+		{
+			for (int i = 0; i < bytes; ++i) out[i] = static_cast<unsigned char>(value >> (8 * i));
+		}
+
+		// BC1 block (also color part of BC3), always in four color mode
+		void encodeColor(const Block& block, unsigned char* out)
+		{
+			float end0[3], end1[3];
+			endpoints(block, 3, end0, end1);
+
+			unsigned int color0 = to565(end0), color1 = to565(end1);
+			if (color0 < color1) std::swap(color0, color1);
+
+			uint32_t indices = 0;
+
+			if (color0 != color1)
+			{
+				float palette[4][3];
+				from565(color0, palette[0]);
+				from565(color1, palette[1]);
+
+				for (int c = 0; c < 3; ++c)
+				{
+					palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+					palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+				}
+
+				for (int i = 0; i < 16; ++i)
+				{
+					const float* t = block.texels[i];
+					uint32_t best = 0;
+					float bestError = 1e30f;
+
+					for (uint32_t k = 0; k < 4; ++k)
+					{
+						float error = 0.0f;
+						for (int c = 0; c < 3; ++c) error += (t[c] - palette[k][c]) * (t[c] - palette[k][c]);
+
+						if (error < bestError)
+						{
+							bestError = error;
+							best = k;
+						}
+					}
+
+					indices |= best << (2 * i);
+				}
+			}
+
+			write(out, color0, 2);
+			write(out + 2, color1, 2);
+			write(out + 4, indices, 4);
+		}
+
+		// BC4 block of a channel (also alpha part of BC3 and halves of BC5), in eight value mode
+		void encodeChannel(const Block& block, int channel, unsigned char* out)
+		{
+			float lo = 255.0f, hi = 0.0f;
+
+			for (const float* t : block.texels)
+			{
+				lo = std::min(lo, t[channel]);
+				hi = std::max(hi, t[channel]);
+			}
+
+			unsigned int value0 = static_cast<unsigned int>(hi + 0.5f);
+			unsigned int value1 = static_cast<unsigned int>(lo + 0.5f);
+			uint64_t indices = 0;
+
+			if (value0 > value1)
+			{
+				// code 0 is value0, 1 is value1, 2 to 7 step from value0 to value1
+				float range = static_cast<float>(value0 - value1);
+
+				for (int i = 0; i < 16; ++i)
+				{
+					float f = (value0 - block.texels[i][channel]) / range * 7.0f;
+					int step = std::min(std::max(static_cast<int>(f + 0.5f), 0), 7);
+					uint64_t code = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+					indices |= code << (3 * i);
+				}
+			}
+
+			out[0] = static_cast<unsigned char>(value0);
+			out[1] = static_cast<unsigned char>(value1);
+			write(out + 2, indices, 6);
+		}
+
+		// IEEE half bits of a non-negative value (negatives and NaN become 0, large values the largest half)
+		unsigned int halfBits(float value)
+		{
+			if (!(value > 0.0f)) return 0;
+			if (value >= 65504.0f) return 0x7bff;
+
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+
+			int exponent = static_cast<int>((bits >> 23) & 0xff) - 127 + 15;
+			uint32_t mantissa = bits & 0x7fffff;
+
+			if (exponent <= 0)
+			{
+				if (exponent < -10) return 0;
+
+				// subnormal half
+				mantissa |= 0x800000;
+				int shift = 14 - exponent;
+				return (mantissa >> shift) + ((mantissa >> (shift - 1)) & 1);
+			}
+
+			// rounding may carry into exponent, which is still the nearest half
+			unsigned int half = (static_cast<unsigned int>(exponent) << 10) | (mantissa >> 13);
+			half += (mantissa >> 12) & 1;
+			return std::min(half, 0x7bffu);
+		}
+
+		// 128 bits written from least significant bit up
+		struct BitWriter
+		{
+			uint64_t words[2] = {};
+			int position = 0;
+
+			void put(uint64_t value, int bits)
+			{
+				for (int i = 0; i < bits; ++i, ++position)
+					words[position / 64] |= ((value >> i) & 1) << (position % 64);
+			}
+		};
+
+		// BC6H block in mode 11 (single region, 10-bit endpoints, 4-bit indices)
+		// Endpoints are interpolated in the space of half bits scaled by 64 / 31, the decoder's last step.
+		void encodeHDRBlock(const float* pixels, int components, int width, int height, int bx, int by, unsigned char* out)
+		{
+			static const int kWeights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			Block block;
+			unsigned int halfs[16][3];
+
+			for (int y = 0; y < 4; ++y)
+			{
+				for (int x = 0; x < 4; ++x)
+				{
+					int sx = std::min(bx * 4 + x, width - 1);
+					int sy = std::min(by * 4 + y, height - 1);
+					const float* p = pixels + (static_cast<size_t>(sy) * width + sx) * components;
+					int i = y * 4 + x;
+
+					for (int c = 0; c < 3; ++c)
+					{
+						halfs[i][c] = halfBits(p[c]);
+						block.texels[i][c] = halfs[i][c] * 64.0f / 31.0f;
+					}
+				}
+			}
+
+			float end0[3], end1[3];
+			endpoints(block, 3, end0, end1);
+
+			// 10-bit endpoints, unquantized as q * 64 + 32 between the extremes 0 and 0xffff
+			unsigned int q0[3], q1[3];
+			int u0[3], u1[3];
+
+			for (int c = 0; c < 3; ++c)
+			{
+				q0[c] = static_cast<unsigned int>(std::min(std::max(static_cast<int>(std::floor((end0[c] - 32.0f) / 64.0f + 0.5f)), 0), 1023));
+				q1[c] = static_cast<unsigned int>(std::min(std::max(static_cast<int>(std::floor((end1[c] - 32.0f) / 64.0f + 0.5f)), 0), 1023));
+
+				auto unquantize = [](unsigned int q) { return q == 0 ? 0 : q == 1023 ? 0xffff : static_cast<int>(((q << 16) + 0x8000) >> 10); };
+				u0[c] = unquantize(q0[c]);
+				u1[c] = unquantize(q1[c]);
+			}
+
+			// palette as decoded: interpolate, then scale to half bits
+			int palette[16][3];
+
+			for (int k = 0; k < 16; ++k)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					int value = ((64 - kWeights[k]) * u0[c] + kWeights[k] * u1[c] + 32) >> 6;
+					palette[k][c] = (value * 31) >> 6;
+				}
+			}
+
+			unsigned int indices[16];
+
+			for (int i = 0; i < 16; ++i)
+			{
+				long long bestError = -1;
+
+				for (unsigned int k = 0; k < 16; ++k)
+				{
+					long long error = 0;
+
+					for (int c = 0; c < 3; ++c)
+					{
+						long long d = static_cast<long long>(halfs[i][c]) - palette[k][c];
+						error += d * d;
+					}
+
+					if (bestError < 0 || error < bestError)
+					{
+						bestError = error;
+						indices[i] = k;
+					}
+				}
+			}
+
+			// most significant bit of first index is implied 0, flip endpoints if needed (weights are symmetric)
+			if (indices[0] >= 8)
+			{
+				for (int c = 0; c < 3; ++c) std::swap(q0[c], q1[c]);
+				for (unsigned int& index : indices) index = 15 - index;
+			}
+
+			BitWriter bits;
+			bits.put(0x03, 5); // mode 11
+
+			for (int c = 0; c < 3; ++c) bits.put(q0[c], 10);
+			for (int c = 0; c < 3; ++c) bits.put(q1[c], 10);
+
+			bits.put(indices[0], 3);
+			for (int i = 1; i < 16; ++i) bits.put(indices[i], 4);
+
+			write(out, bits.words[0], 8);
+			write(out + 8, bits.words[1], 8);
+		}
+	}
+
+	void TextureCompressor::Initialize()
+	{
+		int numExtensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+
+		for (int i = 0; i < numExtensions; ++i)
+		{
+			const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			if (!name) continue;
+
+			std::string extension(name);
+
+			if (extension == "GL_EXT_texture_compression_s3tc")
+				g_s3tc = true;
+			else if (extension == "GL_EXT_texture_sRGB" || extension == "GL_EXT_texture_compression_s3tc_srgb")
+				g_s3tcSrgb = true;
+		}
+
+		g_s3tcSrgb = g_s3tcSrgb && g_s3tc;
+
+		Log::Message(std::string("[TextureCompressor] S3TC ") + (g_s3tc ? "supported" : "not supported, color textures stay uncompressed") +
+			(g_s3tc && !g_s3tcSrgb ? " (no sRGB)" : ""), Log::INFO);
+	}
+
+	unsigned int TextureCompressor::Select(unsigned int colorFormat, bool srgb)
+	{
+		if (!g_enabled) return 0;
+
+		switch (colorFormat)
+		{
+		case GL_RED:
+		case GL_R8:
+			return GL_COMPRESSED_RED_RGTC1;
+		case GL_RG:
+		case GL_RG8:
+			return GL_COMPRESSED_RG_RGTC2;
+		case GL_RGB:
+		case GL_RGB8:
+		case GL_SRGB:
+		case GL_SRGB8:
+			if (srgb) return g_s3tcSrgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : 0;
+			return g_s3tc ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : 0;
+		case GL_RGBA:
+		case GL_RGBA8:
+		case GL_SRGB_ALPHA:
+		case GL_SRGB8_ALPHA8:
+			if (srgb) return g_s3tcSrgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : 0;
+			return g_s3tc ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : 0;
+		default:
+			return 0;
+		}
+	}
+
+	unsigned int TextureCompressor::SelectHDR()
+	{
+		return g_enabled ? GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT : 0;
+	}
+
+	bool TextureCompressor::IsCompressed(unsigned int format)
+	{
+		return format == GL_COMPRESSED_RED_RGTC1 || format == GL_COMPRESSED_RG_RGTC2 ||
+			format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT ||
+			format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT ||
+			format == GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+	}
+
+	size_t TextureCompressor::LevelSize(unsigned int format, int width, int height)
+	{
+		size_t blockSize = format == GL_COMPRESSED_RED_RGTC1 || format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ||
+			format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT ? 8 : 16;
+
+		return static_cast<size_t>((width + 3) / 4) * static_cast<size_t>((height + 3) / 4) * blockSize;
+	}
+
+	void TextureCompressor::Compress(unsigned int format, const unsigned char* pixels, int components, int width, int height, unsigned char* out)
+	{
+		int blocksX = (width + 3) / 4;
+		int blocksY = (height + 3) / 4;
+		size_t blockSize = LevelSize(format, 4, 4);
+
+		JobSystem::ParallelFor(blocksY, kRowsPerJob, [&](size_t begin, size_t end)
+		{
+			Block block;
+
+			for (int by = static_cast<int>(begin); by < static_cast<int>(end); ++by)
+			{
+				for (int bx = 0; bx < blocksX; ++bx)
+				{
+					unsigned char* dst = out + (static_cast<size_t>(by) * blocksX + bx) * blockSize;
+					fetchBlock(pixels, components, width, height, bx, by, block);
+
+					switch (format)
+					{
+					case GL_COMPRESSED_RED_RGTC1:
+						encodeChannel(block, 0, dst);
+						break;
+					case GL_COMPRESSED_RG_RGTC2:
+						encodeChannel(block, 0, dst);
+						encodeChannel(block, 1, dst + 8);
+						break;
+					case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+					case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+						encodeChannel(block, 3, dst);
+						encodeColor(block, dst + 8);
+						break;
+					default:
+						encodeColor(block, dst);
+						break;
+					}
+				}
+			}
+		});
+	}
+
+	void TextureCompressor::CompressHDR(const float* pixels, int components, int width, int height, unsigned char* out)
+	{
+		int blocksX = (width + 3) / 4;
+		int blocksY = (height + 3) / 4;
+
+		JobSystem::ParallelFor(blocksY, kRowsPerJob, [&](size_t begin, size_t end)
+		{
+			for (int by = static_cast<int>(begin); by < static_cast<int>(end); ++by)
+			{
+				for (int bx = 0; bx < blocksX; ++bx)
+					encodeHDRBlock(pixels, components, width, height, bx, by, out + (static_cast<size_t>(by) * blocksX + bx) * 16);
+			}
+		});
+	}
+}
\ No newline at end of file
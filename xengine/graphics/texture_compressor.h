@@ -0,0 +1,52 @@
+#pragma once
+#ifndef XE_TEXTURE_COMPRESSOR_H
+#define XE_TEXTURE_COMPRESSOR_H
+
+#include <cstddef>
+
+namespace xengine
+{
+	// CPU block compression (BCn) of 2D textures
+	// 8-bit textures are compressed by the channels they are requested with: red to BC4 (e.g. masks),
+	// red-green to BC5 (e.g. normal maps, z is rebuilt in shaders), RGB to BC1 and RGBA to BC3. HDR
+	// textures are compressed to BC6H (unsigned). BC4, BC5 and BC6H are core, BC1 and BC3 need
+	// EXT_texture_compression_s3tc (and EXT_texture_sRGB for sRGB), or the texture stays uncompressed.
+	// Encoders are single pass (endpoints along the principal axis of a block, nearest palette entry),
+	// rows of blocks are encoded in parallel on the job system.
+	class TextureCompressor
+	{
+	public:
+		// query S3TC support
+		static void Initialize();
+
+		// compressed format an 8-bit texture requested as colorFormat is stored in, 0 if it stays uncompressed
+		static unsigned int Select(unsigned int colorFormat, bool srgb);
+
+		// compressed format of HDR textures, 0 if they stay uncompressed
+		static unsigned int SelectHDR();
+
+		// format is one of the compressed formats above
+		static bool IsCompressed(unsigned int format);
+
+		// bytes of a level of width * height texels in format
+		static size_t LevelSize(unsigned int format, int width, int height);
+
+		// compress rows (bottom-up) of an 8-bit image of 1 to 4 components into out (LevelSize bytes),
+		// missing channels read as in uploads of uncompressed textures (green and blue 0, alpha 255)
+		static void Compress(unsigned int format, const unsigned char* pixels, int components, int width, int height, unsigned char* out);
+
+		// compress rows of an HDR image of 3 or 4 components into out in SelectHDR() format (alpha is dropped)
+		static void CompressHDR(const float* pixels, int components, int width, int height, unsigned char* out);
+
+		// compression of textures loaded afterwards (on by default)
+		static void SetEnabled(bool enabled) { g_enabled = enabled; }
+		static bool Enabled() { return g_enabled; }
+
+	private:
+		static bool g_enabled;
+		static bool g_s3tc;
+		static bool g_s3tcSrgb;
+	};
+}
+
+#endif // !XE_TEXTURE_COMPRESSOR_H
@@ -1,5 +1,8 @@
 #include "texture_loader.h"
 
+#include <cstring>
+#include <algorithm>
+
 #include <glad/glad.h>
 
 #ifndef STB_IMAGE_IMPLEMENTATION
@@ -10,39 +13,183 @@
 #include <utility/log.h>
 #include <utility/file_system.h>
 
+#include "texture_cache.h"
+#include "texture_compressor.h"
+
 namespace xengine
 {
-	Texture LoadTexture2D_Impl_Stbi(const std::string& filename, unsigned int colorFormat, bool srgb)
+	namespace
 	{
-		Texture texture;
-		int width, height, nrComponents;
+		// stbi_set_flip_vertically_on_load is a global flag shared by all threads, it is never set here,
+		// images are flipped after decoding instead
+		void flipRows(unsigned char* data, size_t rowSize, int height)
+		{
+			std::vector<unsigned char> row(rowSize);
 
-		if (colorFormat == GL_RGB || colorFormat == GL_SRGB)
-			colorFormat = srgb ? GL_SRGB : GL_RGB;
-		if (colorFormat == GL_RGBA || colorFormat == GL_SRGB_ALPHA)
-			colorFormat = srgb ? GL_SRGB_ALPHA : GL_RGBA;
+			for (int y = 0; y < height / 2; ++y)
+			{
+				unsigned char* top = data + rowSize * y;
+				unsigned char* bottom = data + rowSize * (height - 1 - y);
+				std::memcpy(row.data(), top, rowSize);
+				std::memcpy(top, bottom, rowSize);
+				std::memcpy(bottom, row.data(), rowSize);
+			}
+		}
 
-		stbi_set_flip_vertically_on_load(true);
+		// replace decoded image by its compressed mip chain
+		void compress(TextureImage& image, unsigned int format)
+		{
+			std::vector<TextureImage> levels(1);
+			levels[0] = std::move(image);
+			BuildMipmaps(levels);
+
+			size_t size = 0;
+			for (const TextureImage& level : levels) size += TextureCompressor::LevelSize(format, level.width, level.height);
+
+			image.width = levels[0].width;
+			image.height = levels[0].height;
+			image.components = levels[0].components;
+			image.data.resize(size);
+			image.compressedFormat = format;
+			image.levels = static_cast<int>(levels.size());
+
+			unsigned char* out = image.data.data();
+
+			for (const TextureImage& level : levels)
+			{
+				TextureCompressor::Compress(format, level.data.data(), level.components, level.width, level.height, out);
+				out += TextureCompressor::LevelSize(format, level.width, level.height);
+			}
+		}
+
+		// HDR maps are sampled without mipmaps
+		Texture createHDR(const TextureImage& image)
+		{
+			Texture texture;
+			texture.SetFilterMin(GL_LINEAR);
+			texture.GenerateCompressed2D(image.width, image.height, image.compressedFormat, 1, image.data.data());
+			return texture;
+		}
+	}
+
+	bool DecodeTexture2D_Impl_Stbi(const std::string& filename, TextureImage& image)
+	{
+		int width, height, nrComponents;
 		unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
 
-		if (data)
+		if (!data) return false;
+
+		image.width = width;
+		image.height = height;
+		image.components = nrComponents;
+		image.data.assign(data, data + static_cast<size_t>(width) * height * nrComponents);
+		stbi_image_free(data);
+
+		flipRows(image.data.data(), static_cast<size_t>(width) * nrComponents, height);
+
+		return true;
+	}
+
+	bool PrepareTexture2D_Impl_Stbi(const std::string& filename, unsigned int colorFormat, bool srgb, TextureImage& image)
+	{
+		unsigned int format = TextureCompressor::Select(colorFormat, srgb);
+		unsigned long long key = 0;
+		bool keyed = format && TextureCache::Enabled() && TextureCache::Key(filename, format, key);
+
+		if (keyed && TextureCache::Load(key, image)) return true;
+
+		if (!DecodeTexture2D_Impl_Stbi(filename, image)) return false;
+
+		// sizes of other images may be refused by compressed uploads, they stay uncompressed
+		if (!format || image.width % 4 || image.height % 4) return true;
+
+		compress(image, format);
+
+		if (keyed) TextureCache::Store(key, image);
+
+		return true;
+	}
+
+	void BuildMipmaps(std::vector<TextureImage>& levels)
+	{
+		while (levels.back().width > 1 || levels.back().height > 1)
 		{
-			GLenum pixelFormat;
-			if (nrComponents == 1) pixelFormat = GL_RED;
-			else if (nrComponents == 3) pixelFormat = GL_RGB;
-			else if (nrComponents == 4) pixelFormat = GL_RGBA;
+			const TextureImage& src = levels.back();
+			TextureImage dst;
+			dst.width = std::max(src.width / 2, 1);
+			dst.height = std::max(src.height / 2, 1);
+			dst.components = src.components;
+			dst.data.resize(static_cast<size_t>(dst.width) * dst.height * dst.components);
 
-			texture.Generate2D(width, height, colorFormat, pixelFormat, GL_UNSIGNED_BYTE, data);
-			stbi_image_free(data);
+			int c = src.components;
+
+			// odd edges repeat their last texel
+			for (int y = 0; y < dst.height; ++y)
+			{
+				int y0 = std::min(y * 2, src.height - 1), y1 = std::min(y * 2 + 1, src.height - 1);
+
+				for (int x = 0; x < dst.width; ++x)
+				{
+					int x0 = std::min(x * 2, src.width - 1), x1 = std::min(x * 2 + 1, src.width - 1);
+
+					for (int k = 0; k < c; ++k)
+					{
+						unsigned int sum =
+							src.data[(y0 * src.width + x0) * c + k] + src.data[(y0 * src.width + x1) * c + k] +
+							src.data[(y1 * src.width + x0) * c + k] + src.data[(y1 * src.width + x1) * c + k];
+						dst.data[(y * dst.width + x) * c + k] = static_cast<unsigned char>((sum + 2) / 4);
+					}
+				}
+			}
+
+			levels.push_back(std::move(dst));
 		}
-		else
+	}
+
+	Texture CreateTexture2D(const TextureImage& image, unsigned int colorFormat, bool srgb)
+	{
+		Texture texture;
+
+		if (image.width <= 0 || image.height <= 0) return texture;
+
+		if (image.compressedFormat)
+		{
+			texture.GenerateCompressed2D(image.width, image.height, image.compressedFormat, image.levels, image.data.empty() ? nullptr : image.data.data());
+			return texture;
+		}
+
+		// sized formats, so that textures can be pooled into texture arrays of the exact format
+		if (colorFormat == GL_RED)
+			colorFormat = GL_R8;
+		if (colorFormat == GL_RG)
+			colorFormat = GL_RG8;
+		if (colorFormat == GL_RGB || colorFormat == GL_SRGB)
+			colorFormat = srgb ? GL_SRGB8 : GL_RGB8;
+		if (colorFormat == GL_RGBA || colorFormat == GL_SRGB_ALPHA)
+			colorFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+
+		GLenum pixelFormat = GL_RGBA;
+		if (image.components == 1) pixelFormat = GL_RED;
+		else if (image.components == 2) pixelFormat = GL_RG;
+		else if (image.components == 3) pixelFormat = GL_RGB;
+
+		texture.Generate2D(image.width, image.height, colorFormat, pixelFormat, GL_UNSIGNED_BYTE,
+			image.data.empty() ? nullptr : const_cast<unsigned char*>(image.data.data()));
+
+		return texture;
+	}
+
+	Texture LoadTexture2D_Impl_Stbi(const std::string& filename, unsigned int colorFormat, bool srgb)
+	{
+		TextureImage image;
+
+		if (!PrepareTexture2D_Impl_Stbi(filename, colorFormat, srgb, image))
 		{
 			Log::Message("[TextureLoader] Cannot load 2D texture \"" + filename + "\"", Log::WARN);
-			stbi_image_free(data);
 			return Texture();
 		}
 
-		return texture;
+		return CreateTexture2D(image, colorFormat, srgb);
 	}
 
 	Texture LoadHDR_Impl_Stbi(const std::string& filename)
@@ -55,13 +202,39 @@ namespace xengine
 			return Texture();
 		}
 
+		unsigned int format = TextureCompressor::SelectHDR();
+		unsigned long long key = 0;
+		bool keyed = format && TextureCache::Enabled() && TextureCache::Key(filename, format, key);
+
+		TextureImage image;
+
+		if (keyed && TextureCache::Load(key, image))
+			return createHDR(image);
+
 		int width, height, nrComponents;
 
-		stbi_set_flip_vertically_on_load(true);
 		float *data = stbi_loadf(filename.c_str(), &width, &height, &nrComponents, 0);
 
 		if (data)
 		{
+			flipRows(reinterpret_cast<unsigned char*>(data), sizeof(float) * width * nrComponents, height);
+
+			if (format && nrComponents >= 3 && width % 4 == 0 && height % 4 == 0)
+			{
+				image.width = width;
+				image.height = height;
+				image.components = nrComponents;
+				image.compressedFormat = format;
+				image.data.resize(TextureCompressor::LevelSize(format, width, height));
+
+				TextureCompressor::CompressHDR(data, nrComponents, width, height, image.data.data());
+				stbi_image_free(data);
+
+				if (keyed) TextureCache::Store(key, image);
+
+				return createHDR(image);
+			}
+
 			GLenum colorFormat, pixelFormat;
 
 			if (nrComponents == 3)
@@ -99,9 +272,7 @@ namespace xengine
 	{
 		CubeMap texture;
 
-		// disable y flip on cubemaps
-		stbi_set_flip_vertically_on_load(false);
-
+		// no y flip on cubemaps
 		// order:  +X (right), -X (left), +Y (top), -Y (bottom), +Z (front), -Z (back)
 		std::vector<std::string> faces{ filenameRight, filenameLeft, filenameTop, filenameBottom, filenameFront, filenameBack };
 
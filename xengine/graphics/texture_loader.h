@@ -9,10 +9,37 @@
 
 namespace xengine
 {
-	// load a 2D texture with stb_image
+	// decoded 8-bit image, rows bottom-up as OpenGL expects
+	struct TextureImage
+	{
+		int width = 0;
+		int height = 0;
+		int components = 0;
+		std::vector<unsigned char> data;
+
+		// block-compressed image (see TextureCompressor): data holds levels from largest to smallest
+		unsigned int compressedFormat = 0;
+		int levels = 1;
+	};
+
+	// decode an image file with stb_image (thread-safe, no GL calls)
+	bool DecodeTexture2D_Impl_Stbi(const std::string& filename, TextureImage& image);
+
+	// decode an image file and compress it with its full mip chain if TextureCompressor picks a format for
+	// colorFormat, compressed images are read from and written to TextureCache (thread-safe, no GL calls)
+	bool PrepareTexture2D_Impl_Stbi(const std::string& filename, unsigned int colorFormat, bool srgb, TextureImage& image);
+
+	// append mip levels of an 8-bit image down to 1x1 (2x2 box filter)
+	void BuildMipmaps(std::vector<TextureImage>& levels);
+
+	// create a 2D texture from a decoded or compressed image (content left undefined if image has no data)
+	// colorFormat and srgb are ignored for compressed images
+	Texture CreateTexture2D(const TextureImage& image, unsigned int colorFormat, bool srgb);
+
+	// load a 2D texture with stb_image (compressed, see PrepareTexture2D_Impl_Stbi)
 	Texture LoadTexture2D_Impl_Stbi(const std::string& filename, unsigned int colorFormat, bool srgb);
 
-	// load a high-dynamical-range texture
+	// load a high-dynamical-range texture (compressed if TextureCompressor::SelectHDR gives a format)
 	Texture LoadHDR_Impl_Stbi(const std::string& filename);
 
 	// load a cubic texture from specific files
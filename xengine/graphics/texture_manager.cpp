@@ -1,18 +1,37 @@
 #include "texture_manager.h"
 
+#include <algorithm>
+
 #include <glad/glad.h>
 
 #include <utility/log.h>
 #include <utility/file_system.h>
 
 #include "texture_loader.h"
+#include "texture_streamer.h"
+#include "texture_compressor.h"
 
 namespace xengine
 {
 	std::unordered_map<std::string, Texture> TextureManager::g_localTable{};
 	std::unordered_map<std::string, Texture> TextureManager::g_globalTable{};
+	std::vector<TextureManager::TextureArray> TextureManager::g_arrays{};
 	Texture TextureManager::g_nullTexture2D;
 
+	namespace
+	{
+		// layers of first array of a kind, doubled for every further array up to maximum
+		const unsigned int kMinArrayLayers = 4;
+		const unsigned int kMaxArrayLayers = 64;
+
+		// 8-bit sized and block-compressed formats, stored identically in 2D and array textures
+		bool isPoolableFormat(unsigned int colorFormat)
+		{
+			return colorFormat == GL_R8 || colorFormat == GL_RG8 || colorFormat == GL_RGB8 || colorFormat == GL_RGBA8 ||
+				colorFormat == GL_SRGB8 || colorFormat == GL_SRGB8_ALPHA8 || TextureCompressor::IsCompressed(colorFormat);
+		}
+	}
+
 	void TextureManager::Initialize()
 	{
 		generateDefaultTexture();
@@ -29,11 +48,15 @@ namespace xengine
 	void TextureManager::ClearLocal()
 	{
 		g_localTable.clear();
+
+		// start new arrays for next scene, old ones are released along with their last texture
+		g_arrays.erase(std::remove_if(g_arrays.begin(), g_arrays.end(), [](const TextureArray& array) { return !array.global; }), g_arrays.end());
 	}
 
 	void TextureManager::ClearGlobal()
 	{
 		g_globalTable.clear();
+		g_arrays.erase(std::remove_if(g_arrays.begin(), g_arrays.end(), [](const TextureArray& array) { return array.global; }), g_arrays.end());
 	}
 
 	Texture TextureManager::Get(const std::string& name)
@@ -69,6 +92,26 @@ namespace xengine
 		return loadTexture2D(g_globalTable, name, path, format, srgb);
 	}
 
+	Texture TextureManager::CreateLocalTexture2D(const std::string & name, const TextureImage & image, unsigned int format, bool srgb)
+	{
+		return createTexture2D(g_localTable, name, image, format, srgb);
+	}
+
+	Texture TextureManager::CreateGlobalTexture2D(const std::string & name, const TextureImage & image, unsigned int format, bool srgb)
+	{
+		return createTexture2D(g_globalTable, name, image, format, srgb);
+	}
+
+	Texture TextureManager::RequestLocalTexture2D(const std::string & name, const std::string & path, unsigned int format, bool srgb)
+	{
+		return requestTexture2D(g_localTable, name, path, format, srgb);
+	}
+
+	Texture TextureManager::RequestGlobalTexture2D(const std::string & name, const std::string & path, unsigned int format, bool srgb)
+	{
+		return requestTexture2D(g_globalTable, name, path, format, srgb);
+	}
+
 	Texture TextureManager::LoadLocalTextureHDR(const std::string& name, const std::string& path)
 	{
 		return loadTextureHDR(g_localTable, name, path);
@@ -155,12 +198,62 @@ namespace xengine
 
 		Texture texture = LoadTexture2D_Impl_Stbi(path, format, srgb);
 
+		return registerTexture2D(table, name, texture);
+	}
+
+	Texture TextureManager::createTexture2D(
+		std::unordered_map<std::string, Texture>& table,
+		const std::string & name,
+		const TextureImage & image,
+		unsigned int format,
+		bool srgb)
+	{
+		auto it = table.find(name);
+		if (it != table.end()) return it->second;
+
+		Texture texture = CreateTexture2D(image, format, srgb);
+
+		return registerTexture2D(table, name, texture);
+	}
+
+	Texture TextureManager::requestTexture2D(
+		std::unordered_map<std::string, Texture>& table,
+		const std::string & name,
+		const std::string & path,
+		unsigned int format,
+		bool srgb)
+	{
+		auto it = table.find(name);
+		if (it != table.end()) return it->second;
+
+		Texture texture;
+
+		// own view of null texture, so swapping storage leaves null texture alone
+		if (!texture.ViewLayerOf(g_nullTexture2D))
+		{
+			Log::Message("[TextureManager] 2D Texture \"" + name + "\" can't be streamed, loading it at once", Log::WARN);
+			return loadTexture2D(table, name, path, format, srgb);
+		}
+
+		Log::Message("[TextureManager] Streaming 2D texture \"" + name + "\" from \"" + path + "\" ...", Log::INFO);
+
+		TextureStreamer::Request(texture, path, format, srgb, &table == &g_globalTable);
+
+		table[name] = texture;
+
+		return texture;
+	}
+
+	Texture TextureManager::registerTexture2D(std::unordered_map<std::string, Texture>& table, const std::string & name, Texture & texture)
+	{
 		if (!texture)
 		{
 			Log::Message("[TextureManager] 2D Texture \"" + name + "\" loading failed", Log::WARN);
 			return g_nullTexture2D;
 		}
 
+		poolTexture2D(texture, &table == &g_globalTable);
+
 		table[name] = texture;
 
 		Log::Message("[TextureManager] 2D Texture \"" + name + "\" loaded successfully", Log::INFO);
@@ -218,30 +311,91 @@ namespace xengine
 		return texture;
 	}
 
+	void TextureManager::poolTexture2D(Texture& texture, bool global)
+	{
+		if (!texture || texture.Target() != GL_TEXTURE_2D || texture.Pooled()) return;
+		if (!isPoolableFormat(texture.ColorFormat())) return;
+
+		TextureArray* target = nullptr;
+		unsigned int layer = 0;
+		unsigned int layers = kMinArrayLayers;
+
+		for (TextureArray& array : g_arrays)
+		{
+			const Texture& a = array.texture;
+
+			if (array.global != global) continue;
+
+			if (a.Width() != texture.Width() || a.Height() != texture.Height() || a.ColorFormat() != texture.ColorFormat() ||
+				a.Mipmap() != texture.Mipmap() || a.FilterMin() != texture.FilterMin() || a.FilterMax() != texture.FilterMax() ||
+				a.WrapS() != texture.WrapS() || a.WrapT() != texture.WrapT()) continue;
+
+			// layers of released textures first
+			if (a.FreeLayer(layer))
+			{
+				target = &array;
+				break;
+			}
+
+			if (array.used < a.Depth())
+			{
+				target = &array;
+				layer = array.used;
+				break;
+			}
+
+			layers = std::min(a.Depth() * 2, kMaxArrayLayers);
+		}
+
+		if (!target)
+		{
+			layer = 0;
+
+			Texture array;
+			array.SetFilterMin(texture.FilterMin());
+			array.SetFilterMax(texture.FilterMax());
+			array.SetWrapS(texture.WrapS());
+			array.SetWrapT(texture.WrapT());
+			array.Generate2DArray(texture.Width(), texture.Height(), layers, texture.ColorFormat(), texture.Mipmap());
+
+			g_arrays.push_back({ array, 0, global });
+			target = &g_arrays.back();
+
+			Log::Message("[TextureManager] Texture array of " + std::to_string(layers) + " layers (" +
+				std::to_string(texture.Width()) + "x" + std::to_string(texture.Height()) + ") generated", Log::DEBUG);
+		}
+
+		if (texture.MoveToArray(target->texture, layer) && layer == target->used) ++target->used;
+	}
+
 	void TextureManager::generateDefaultTexture()
 	{
 		{
 			unsigned char color[4]{ 255, 255, 255, 255 };
-			Texture texture = CreateTexture2DPureColor(GL_RGBA, GL_RGBA, 1, 1, color);
+			Texture texture = CreateTexture2DPureColor(GL_RGBA8, GL_RGBA, 1, 1, color);
+			poolTexture2D(texture, true);
 			RegisterGlobalTexture("white", texture);
 		}
 
 		{
 			unsigned char color[4]{   1,   1,   1, 255 };
-			Texture texture = CreateTexture2DPureColor(GL_RGBA, GL_RGBA, 1, 1, color);
+			Texture texture = CreateTexture2DPureColor(GL_RGBA8, GL_RGBA, 1, 1, color);
+			poolTexture2D(texture, true);
 			RegisterGlobalTexture("black", texture);
 		}
 
 		{
 			unsigned char color[4]{ 128, 128, 255, 255 };
-			Texture texture = CreateTexture2DPureColor(GL_RGBA, GL_RGBA, 1, 1, color);
+			Texture texture = CreateTexture2DPureColor(GL_RGBA8, GL_RGBA, 1, 1, color);
+			poolTexture2D(texture, true);
 			RegisterGlobalTexture("normal", texture);
 		}
 
 		{
 			unsigned char color1[4]{ 255, 255, 255, 255 };
 			unsigned char color2[4]{   1,   1,   1, 255 };
-			Texture texture = CreateTexture2DChessboard(GL_RGBA, GL_RGBA, 8, 8, color1, color2);
+			Texture texture = CreateTexture2DChessboard(GL_RGBA8, GL_RGBA, 8, 8, color1, color2);
+			poolTexture2D(texture, true);
 			RegisterGlobalTexture("chessboard", texture);
 		}
 	}
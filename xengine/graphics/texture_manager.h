@@ -11,8 +11,12 @@
 
 namespace xengine
 {
+	struct TextureImage;
+
 	class TextureManager
 	{
+		friend class TextureStreamer;
+
 	public:
 		// initialize shader manager (load default resources)
 		static void Initialize();
@@ -48,6 +52,33 @@ namespace xengine
 			unsigned int format,
 			bool srgb = false);
 
+		// create a 2D texture from an image decoded beforehand (e.g. on a worker thread)
+		static Texture CreateLocalTexture2D(
+			const std::string& name,
+			const TextureImage& image,
+			unsigned int format,
+			bool srgb = false);
+
+		static Texture CreateGlobalTexture2D(
+			const std::string& name,
+			const TextureImage& image,
+			unsigned int format,
+			bool srgb = false);
+
+		// request a 2D texture loaded in background (see TextureStreamer)
+		// returned texture is valid at once, it shows the null texture until the file is streamed in
+		static Texture RequestLocalTexture2D(
+			const std::string& name,
+			const std::string& path,
+			unsigned int format,
+			bool srgb = false);
+
+		static Texture RequestGlobalTexture2D(
+			const std::string& name,
+			const std::string& path,
+			unsigned int format,
+			bool srgb = false);
+
 		// load a 3D texture
 		// TODO
 
@@ -85,6 +116,28 @@ namespace xengine
 			unsigned int format,
 			bool srgb = false);
 
+		// create a 2D texture from decoded image
+		static Texture createTexture2D(
+			std::unordered_map<std::string, Texture>& table,
+			const std::string& name,
+			const TextureImage& image,
+			unsigned int format,
+			bool srgb = false);
+
+		// register a placeholder of a 2D texture and start streaming it
+		static Texture requestTexture2D(
+			std::unordered_map<std::string, Texture>& table,
+			const std::string& name,
+			const std::string& path,
+			unsigned int format,
+			bool srgb = false);
+
+		// pool a loaded 2D texture and add it to table (null texture if loading failed)
+		static Texture registerTexture2D(
+			std::unordered_map<std::string, Texture>& table,
+			const std::string& name,
+			Texture& texture);
+
 		// load a high-dynamical-range texture
 		static Texture loadTextureHDR(
 			std::unordered_map<std::string, Texture>& table,
@@ -97,8 +150,21 @@ namespace xengine
 			const std::string& name,
 			const std::string& directory);
 
+		// move a 2D texture into a layer of a 2D array texture shared with textures of the same size, format
+		// and sampling state, so draws using them share bindings (textures of other formats stay as they are)
+		// global and local textures are pooled apart, local arrays are dropped with scene
+		static void poolTexture2D(Texture& texture, bool global);
+
 		static void generateDefaultTexture();
 
+	private:
+		struct TextureArray
+		{
+			Texture texture;
+			unsigned int used; // layers handed out so far (given back ones are listed by texture, see Texture::FreeLayer)
+			bool global; // holds global textures
+		};
+
 	private:
 		// lookup tables
 		static std::unordered_map<std::string, Texture> g_localTable;
@@ -106,6 +172,9 @@ namespace xengine
 		// lookup tables
 		static std::unordered_map<std::string, Texture> g_globalTable;
 
+		// 2D texture arrays being filled (an array lives on while any of its textures does, even if dropped here)
+		static std::vector<TextureArray> g_arrays;
+
 		// null protector (if a texture fails to load, this texture will be the output)
 		static Texture g_nullTexture2D; // TODO: more types of protectors
 	};
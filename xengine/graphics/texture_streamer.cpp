@@ -0,0 +1,287 @@
+#include "texture_streamer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include <utility/log.h>
+
+#include "frame_sync.h"
+#include "ogl_status.h"
+#include "texture_manager.h"
+#include "texture_compressor.h"
+
+namespace xengine
+{
+	std::list<TextureStreamer::Stream> TextureStreamer::g_streams{};
+	unsigned int TextureStreamer::g_pbo = 0;
+	size_t TextureStreamer::g_regionSize = 0;
+	size_t TextureStreamer::g_budget = TextureStreamer::kDefaultBudget;
+
+	namespace
+	{
+		size_t levelSize(const TextureImage& image)
+		{
+			if (image.compressedFormat) return TextureCompressor::LevelSize(image.compressedFormat, image.width, image.height);
+			return static_cast<size_t>(image.width) * image.height * image.components;
+		}
+
+		// split compressed mip chain into one image per level
+		void splitLevels(const TextureImage& chain, std::vector<TextureImage>& levels)
+		{
+			size_t offset = 0;
+
+			for (int level = 0; level < chain.levels; ++level)
+			{
+				TextureImage image;
+				image.width = std::max(chain.width >> level, 1);
+				image.height = std::max(chain.height >> level, 1);
+				image.components = chain.components;
+				image.compressedFormat = chain.compressedFormat;
+
+				size_t size = levelSize(image);
+				image.data.assign(chain.data.begin() + offset, chain.data.begin() + offset + size);
+				offset += size;
+
+				levels.push_back(std::move(image));
+			}
+		}
+
+		unsigned int pixelFormat(int components)
+		{
+			if (components == 1) return GL_RED;
+			if (components == 2) return GL_RG;
+			if (components == 3) return GL_RGB;
+			return GL_RGBA;
+		}
+	}
+
+	void TextureStreamer::Request(const Texture& texture, const std::string& path, unsigned int format, bool srgb, bool global)
+	{
+		Stream stream;
+		stream.handle = texture;
+		stream.path = path;
+		stream.format = format;
+		stream.srgb = srgb;
+		stream.global = global;
+		stream.levels = std::make_shared<std::vector<TextureImage>>();
+
+		std::shared_ptr<std::vector<TextureImage>> levels = stream.levels;
+
+		// kept off frame waits, a large texture takes longer than a frame to decode and compress
+		stream.job = JobSystem::SubmitBackground([levels, path, format, srgb]()
+		{
+			TextureImage image;
+			if (!PrepareTexture2D_Impl_Stbi(path, format, srgb, image)) return;
+
+			if (image.compressedFormat)
+			{
+				splitLevels(image, *levels);
+				return;
+			}
+
+			levels->push_back(std::move(image));
+			BuildMipmaps(*levels);
+		});
+
+		g_streams.push_back(stream);
+	}
+
+	void TextureStreamer::Update()
+	{
+		if (g_streams.empty()) return;
+
+		// region size follows budget, orphaned storage stays alive for frames still reading it
+		if (g_regionSize != g_budget)
+		{
+			g_regionSize = g_budget;
+			if (!g_pbo) glGenBuffers(1, &g_pbo);
+			OglStatus::BindBuffer(GL_PIXEL_UNPACK_BUFFER, g_pbo);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, g_regionSize * FrameSync::kFrames, nullptr, GL_STREAM_DRAW);
+			OglStatus::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		struct Upload
+		{
+			Stream* stream;
+			int level;
+			size_t offset; // in region, SIZE_MAX if uploaded from client memory
+		};
+
+		std::vector<Upload> uploads;
+		size_t used = 0;
+		bool full = false;
+
+		// plan uploads of this frame in request order, streams still decoding are skipped
+		for (auto it = g_streams.begin(); it != g_streams.end() && !full;)
+		{
+			Stream& stream = *it;
+
+			// handle was released by everyone else (e.g. scene cleared)
+			if (stream.handle.UseCount() == 1)
+			{
+				it = g_streams.erase(it);
+				continue;
+			}
+
+			if (stream.job->unfinished > 0)
+			{
+				++it;
+				continue;
+			}
+
+			if (!stream.texture && !begin(stream))
+			{
+				Log::Message("[TextureStreamer] Cannot load 2D texture \"" + stream.path + "\"", Log::WARN);
+				it = g_streams.erase(it);
+				continue;
+			}
+
+			for (int level = stream.level; level >= 0; --level)
+			{
+				size_t size = levelSize((*stream.levels)[level]);
+				size_t aligned = (size + 3) / 4 * 4;
+
+				if (used + aligned <= g_regionSize)
+				{
+					uploads.push_back({ &stream, level, used });
+					used += aligned;
+				}
+				else if (used == 0)
+				{
+					// level alone exceeds the budget, it gets the whole frame
+					uploads.push_back({ &stream, level, SIZE_MAX });
+					used = g_regionSize;
+					full = true;
+					break;
+				}
+				else
+				{
+					full = true;
+					break;
+				}
+			}
+
+			++it;
+		}
+
+		if (uploads.empty()) return;
+
+		size_t regionOffset = FrameSync::Region() * g_regionSize;
+		OglStatus::BindBuffer(GL_PIXEL_UNPACK_BUFFER, g_pbo);
+
+		if (uploads.front().offset != SIZE_MAX)
+		{
+			// region is guarded by frame fences
+			unsigned char* region = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, regionOffset, used,
+				GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+
+			if (!region)
+			{
+				Log::Message("[TextureStreamer] Mapping region " + std::to_string(FrameSync::Region()) + " failed", Log::ERROR);
+				OglStatus::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				return; // levels are planned again next frame
+			}
+
+			for (const Upload& upload : uploads)
+			{
+				const TextureImage& image = (*upload.stream->levels)[upload.level];
+				std::memcpy(region + upload.offset, image.data.data(), levelSize(image));
+			}
+
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+		else
+		{
+			OglStatus::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		// rows of small levels are not 4-byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		for (const Upload& upload : uploads)
+		{
+			const TextureImage& image = (*upload.stream->levels)[upload.level];
+			const void* pixels = upload.offset == SIZE_MAX ? image.data.data() : reinterpret_cast<const void*>(regionOffset + upload.offset);
+
+			upload.stream->texture.Bind();
+
+			if (image.compressedFormat)
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, 0, image.width, image.height, image.compressedFormat, static_cast<GLsizei>(levelSize(image)), pixels);
+			else
+				glTexSubImage2D(GL_TEXTURE_2D, upload.level, 0, 0, image.width, image.height, pixelFormat(image.components), GL_UNSIGNED_BYTE, pixels);
+			upload.stream->level = upload.level - 1;
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		OglStatus::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		// swap in streams whose last (largest) level went up
+		for (auto it = g_streams.begin(); it != g_streams.end();)
+		{
+			if (it->texture && it->level < 0)
+			{
+				finish(*it);
+				it = g_streams.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	void TextureStreamer::Clear()
+	{
+		for (const Stream& stream : g_streams) JobSystem::Wait(stream.job);
+		g_streams.clear();
+
+		if (g_pbo)
+		{
+			OglStatus::ForgetBuffer(g_pbo);
+			glDeleteBuffers(1, &g_pbo);
+			g_pbo = 0;
+		}
+
+		g_regionSize = 0;
+	}
+
+	bool TextureStreamer::begin(Stream& stream)
+	{
+		const std::vector<TextureImage>& levels = *stream.levels;
+		if (levels.empty()) return false;
+
+		// smallest level is the average color, it stands in until the rest is uploaded (its layer is given back
+		// to the 1x1 array once finish replaces it)
+		Texture average = CreateTexture2D(levels.back(), stream.format, stream.srgb);
+		TextureManager::poolTexture2D(average, stream.global);
+		stream.handle.Replace(average);
+
+		// storage of all levels, content is uploaded level by level
+		const TextureImage& base = levels.front();
+
+		TextureImage storage;
+		storage.width = base.width;
+		storage.height = base.height;
+		storage.components = base.components;
+		storage.compressedFormat = base.compressedFormat;
+		storage.levels = static_cast<int>(levels.size());
+
+		stream.texture = CreateTexture2D(storage, stream.format, stream.srgb);
+		stream.level = static_cast<int>(levels.size()) - 1;
+
+		return static_cast<bool>(stream.texture);
+	}
+
+	void TextureStreamer::finish(Stream& stream)
+	{
+		stream.levels->clear();
+
+		TextureManager::poolTexture2D(stream.texture, stream.global);
+		stream.handle.Replace(stream.texture);
+
+		Log::Message("[TextureStreamer] 2D Texture \"" + stream.path + "\" streamed in", Log::INFO);
+	}
+}
\ No newline at end of file
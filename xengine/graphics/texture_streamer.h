@@ -0,0 +1,77 @@
+#pragma once
+#ifndef XE_TEXTURE_STREAMER_H
+#define XE_TEXTURE_STREAMER_H
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <utility/job_system.h>
+
+#include "texture.h"
+#include "texture_loader.h"
+
+namespace xengine
+{
+	// background loading of 2D textures into handles given out before loading
+	// A requested handle shows a placeholder, then a 1x1 texture of the average color once the file is
+	// decoded and compressed (on a background job), then the full texture once all its mip levels are uploaded. Levels go from
+	// smallest to largest through a pixel unpack buffer ring of FrameSync::kFrames regions, a region
+	// (the per-frame byte budget) is filled once per frame. Swaps replace storage of the handle, so all
+	// copies of it (e.g. in materials) follow (see Texture::Replace).
+	// Partly uploaded chains are not shown: pooled textures are sampled through their shared array, whose
+	// level range can't be narrowed for one layer. The layer of the average color is given back on the final swap.
+	class TextureStreamer
+	{
+	public:
+		static const size_t kDefaultBudget = 4 << 20; // bytes uploaded per frame
+
+	public:
+		// load file into texture (already showing a placeholder) in background, global if texture outlives scenes
+		static void Request(const Texture& texture, const std::string& path, unsigned int format, bool srgb, bool global);
+
+		// upload decoded levels within budget, swap in finished textures (once per frame, after FrameSync::BeginFrame)
+		static void Update();
+
+		// bytes uploaded per frame at most (a single level larger than that still goes in one frame)
+		// budget is rounded up to region alignment here, so region size is compared with it as is
+		static void SetBudget(size_t bytes) { g_budget = (bytes + 255) / 256 * 256; }
+
+		// number of requests not finished
+		static size_t NumPending() { return g_streams.size(); }
+
+		static void Clear();
+
+	private:
+		struct Stream
+		{
+			Texture handle; // given out to user
+			std::string path;
+			unsigned int format;
+			bool srgb;
+			bool global; // pooled with global textures
+
+			std::shared_ptr<std::vector<TextureImage>> levels; // mip chain, empty if decoding failed
+			JobHandle job; // decoding
+
+			Texture texture; // receiving uploads
+			int level = -1; // next level to upload, counting down
+		};
+
+		// take over decoded levels: show average color and allocate texture, false if decoding failed
+		static bool begin(Stream& stream);
+
+		// pool finished texture and swap it into handle
+		static void finish(Stream& stream);
+
+	private:
+		static std::list<Stream> g_streams; // elements stay put while others are erased
+
+		static unsigned int g_pbo;
+		static size_t g_regionSize;
+		static size_t g_budget;
+	};
+}
+
+#endif // !XE_TEXTURE_STREAMER_H
@@ -23,7 +23,7 @@ namespace xengine
 	{
 		unsigned int size = sizeof(glm::vec3);
 		unsigned int stride = sizeof(glm::vec4);
-		m_ub->Commit((void*)&data[0], m_position, size);
+		m_ub->Commit(&data[0], m_position, size);
 		m_position += stride;
 	}
 
@@ -31,7 +31,7 @@ namespace xengine
 	{
 		unsigned int size = sizeof(glm::vec4);
 		unsigned int stride = sizeof(glm::vec4);
-		m_ub->Commit((void*)&data[0], m_position, size);
+		m_ub->Commit(&data[0], m_position, size);
 		m_position += stride;
 	}
 
@@ -39,7 +39,7 @@ namespace xengine
 	{
 		unsigned int size = sizeof(glm::mat4);
 		unsigned int stride = sizeof(glm::mat4);
-		m_ub->Commit((void*)&data[0][0], m_position, size);
+		m_ub->Commit(&data[0][0], m_position, size);
 		m_position += stride;
 	}
 }
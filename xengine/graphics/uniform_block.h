@@ -16,7 +16,7 @@ namespace xengine
 		// clear runtime status before committing data
 		void Refresh();
 
-		// push data into uniform block
+		// push data into uniform block (CPU mirror of buffer, see UniformBuffer::Flush)
 		// data should be registered in the order they are defined in shaders
 		void CommitData(const glm::vec3& data);
 		void CommitData(const glm::vec4& data);
@@ -1,7 +1,14 @@
 #include "uniform_buffer.h"
 
+#include <cstring>
+
 #include <glad/glad.h>
 
+#include <utility/log.h>
+
+#include "frame_sync.h"
+#include "ogl_status.h"
+
 namespace xengine
 {
 	UniformBuffer::UniformBuffer()
@@ -20,27 +27,74 @@ namespace xengine
 
 	void UniformBuffer::Bind()
 	{
-		glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+		OglStatus::BindBuffer(GL_UNIFORM_BUFFER, m_id);
 	}
 
 	void UniformBuffer::Unbind()
 	{
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		OglStatus::BindBuffer(GL_UNIFORM_BUFFER, 0);
 	}
 
 	void UniformBuffer::Generate(unsigned int size, unsigned int bp)
 	{
+		GLint alignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+		if (alignment <= 0) alignment = 256;
+
 		m_bp = bp;
+		m_staging.assign(size, 0);
+		m_regionSize = (size + alignment - 1) / alignment * alignment;
+
 		if (m_id == 0) glGenBuffers(1, &m_id);
-		glBindBuffer(GL_UNIFORM_BUFFER, m_id);
-		glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
-		glBindBufferBase(GL_UNIFORM_BUFFER, m_bp, m_id);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		OglStatus::BindBuffer(GL_UNIFORM_BUFFER, m_id);
+		glBufferData(GL_UNIFORM_BUFFER, size_t(m_regionSize) * FrameSync::kFrames, nullptr, GL_STREAM_DRAW);
+		OglStatus::BindBufferRange(GL_UNIFORM_BUFFER, m_bp, m_id, 0, size);
 	}
 
-	void UniformBuffer::Commit(void * data, unsigned int offset, unsigned int size)
+	void UniformBuffer::Commit(const void * data, unsigned int offset, unsigned int size)
 	{
-		glBindBuffer(GL_UNIFORM_BUFFER, m_id);
-		glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+		if (offset + size > m_staging.size()) return;
+
+		std::memcpy(&m_staging[offset], data, size);
+	}
+
+	void UniformBuffer::Flush()
+	{
+		if (m_id == 0 || m_staging.empty()) return;
+
+		size_t offset = size_t(FrameSync::Region()) * m_regionSize;
+
+		// region is guarded by frame fences, unless it was already flushed (and maybe read) this frame
+		GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+		if (m_frame != FrameSync::Frame()) access |= GL_MAP_UNSYNCHRONIZED_BIT;
+		m_frame = FrameSync::Frame();
+
+		OglStatus::BindBuffer(GL_UNIFORM_BUFFER, m_id);
+		void* region = glMapBufferRange(GL_UNIFORM_BUFFER, offset, m_staging.size(), access);
+
+		if (!region)
+		{
+			Log::Message("[UniformBuffer] Mapping buffer " + std::to_string(m_id) + " failed", Log::ERROR);
+			return;
+		}
+
+		std::memcpy(region, m_staging.data(), m_staging.size());
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+
+		OglStatus::BindBufferRange(GL_UNIFORM_BUFFER, m_bp, m_id, offset, m_staging.size());
+	}
+
+	void UniformBuffer::Clear()
+	{
+		if (m_id)
+		{
+			OglStatus::ForgetBuffer(m_id);
+			glDeleteBuffers(1, &m_id);
+			m_id = 0;
+		}
+
+		m_staging.clear();
+		m_regionSize = 0;
+		m_frame = 0;
 	}
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 namespace xengine
 {
 	// Uniform Block Layout: std 140
+	// Commits only go to a CPU mirror of the block, Flush writes the mirror at once into the region
+	// of current frame (ring of FrameSync::kFrames regions) and binds that region to the binding point.
 	class UniformBuffer
 	{
 	public:
@@ -23,12 +25,22 @@ namespace xengine
 		// allocate memory and set binding point
 		void Generate(unsigned int size, unsigned int bp);
 
-		// send data to uniform block
-		void Commit(void* data, unsigned int offset, unsigned int size);
+		// write data to CPU mirror of uniform block
+		void Commit(const void* data, unsigned int offset, unsigned int size);
+
+		// upload mirror to GPU (once per frame, after all commits)
+		void Flush();
+
+		void Clear();
 
 	private:
 		unsigned int m_id = 0; // ubo (uniform buffer object)
 		unsigned int m_bp = 0; // binding point
+
+		// std140 mirror and ring layout
+		std::vector<unsigned char> m_staging;
+		unsigned int m_regionSize = 0; // block size rounded up to offset alignment
+		unsigned long long m_frame = 0; // frame of last flush
 	};
 }
 
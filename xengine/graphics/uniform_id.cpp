@@ -0,0 +1,52 @@
+#include "uniform_id.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace xengine
+{
+	namespace
+	{
+		struct Registry
+		{
+			std::unordered_multimap<unsigned int, unsigned int> ids; // hash -> ids (names sharing a hash get their own ids)
+			std::vector<std::string> names; // id -> name
+		};
+
+		// constructed on first use, ids may be interned during static initialization
+		Registry& registry()
+		{
+			static Registry instance;
+			return instance;
+		}
+	}
+
+	unsigned int UniformID::Intern(unsigned int hash, const char* name)
+	{
+		Registry& r = registry();
+		auto range = r.ids.equal_range(hash);
+
+		// hash only narrows the search, names decide
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (r.names[it->second] == name)
+				return it->second;
+		}
+
+		unsigned int id = static_cast<unsigned int>(r.names.size());
+		r.ids.emplace(hash, id);
+		r.names.push_back(name);
+
+		return id;
+	}
+
+	const std::string& UniformID::Name(unsigned int id)
+	{
+		return registry().names[id];
+	}
+
+	unsigned int UniformID::Count()
+	{
+		return static_cast<unsigned int>(registry().names.size());
+	}
+}
\ No newline at end of file
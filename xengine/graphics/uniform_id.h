@@ -0,0 +1,45 @@
+#pragma once
+#ifndef XE_UNIFORM_ID_H
+#define XE_UNIFORM_ID_H
+
+#include <string>
+
+#include <utility/hash.h>
+
+namespace xengine
+{
+	// interned uniform name
+	// Ids are dense (0, 1, 2, ...) and shared by all shaders, so a shader maps an id to
+	// its location by indexing an array. Create ids once (e.g. as static objects) and
+	// pass them on hot paths instead of strings.
+	// Note: interning is not thread-safe, ids must be created on the render thread or during static initialization
+	class UniformID
+	{
+	public:
+		static const unsigned int kInvalid = 0xffffffff;
+
+		UniformID() : m_id(kInvalid) {}
+
+		// name hash of a string literal is a constant expression, string work is left to interning
+		template <size_t N>
+		explicit UniformID(const char (&name)[N]) : m_id(Intern(hash::fnv1a(name), name)) {}
+
+		explicit UniformID(const std::string& name) : m_id(Intern(hash::fnv1a(name), name.c_str())) {}
+
+		inline unsigned int Value() const { return m_id; }
+
+		// id of a name given its fnv1a hash (new id if name is never met, even if its hash was)
+		static unsigned int Intern(unsigned int hash, const char* name);
+
+		// name of an interned id
+		static const std::string& Name(unsigned int id);
+
+		// number of interned names
+		static unsigned int Count();
+
+	private:
+		unsigned int m_id;
+	};
+}
+
+#endif // !XE_UNIFORM_ID_H
@@ -2,6 +2,10 @@
 
 #include <glad/glad.h>
 
+#include <graphics/ogl_status.h>
+
+#include "mesh_buffer.h"
+
 namespace xengine
 {
 	////////////////////////////////////////////////////////////////
@@ -14,20 +18,28 @@ namespace xengine
 
 	void MeshMomory::Destory()
 	{
+		if (pooled)
+		{
+			MeshBuffer::Free(*this);
+		}
+
 		if (vao)
 		{
+			OglStatus::ForgetVertexArray(vao);
 			glDeleteVertexArrays(1, &vao);
 			vao = 0;
 		}
 
 		if (vbo)
 		{
+			OglStatus::ForgetBuffer(vbo);
 			glDeleteBuffers(1, &vbo);
 			vbo = 0;
 		}
 
 		if (ibo)
 		{
+			OglStatus::ForgetBuffer(ibo);
 			glDeleteBuffers(1, &ibo);
 			ibo = 0;
 		}
@@ -48,6 +60,9 @@ namespace xengine
 	{
 		generate();
 
+		// release storage of a previous commit
+		m_ptr->Destory();
+
 		m_ptr->numVertices = static_cast<unsigned int>(m_ptr->positions.size());
 		m_ptr->numIndices = static_cast<unsigned int>(m_ptr->indices.size());
 		m_ptr->aabb.BuildFromVertices(m_ptr->positions);
@@ -70,109 +85,143 @@ namespace xengine
 		m_ptr->indices.clear();
 	}
 
-	void Mesh::commitOglVertexInter()
+	void Mesh::CommitInterleaved(unsigned int format, const float* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices, const AABB& aabb)
 	{
-		if (!m_ptr->vao)
-		{
-			glGenVertexArrays(1, &m_ptr->vao);
-			glGenBuffers(1, &m_ptr->vbo);
-		}
+		generate();
 
-		std::vector<float> data;
+		// release storage of a previous commit
+		m_ptr->Destory();
 
-		std::vector<glm::vec3>& positions  = m_ptr->positions;
-		std::vector<glm::vec2>& texCoords  = m_ptr->texCoords;
-		std::vector<glm::vec3>& normals    = m_ptr->normals;
-		std::vector<glm::vec3>& tangents   = m_ptr->tangents;
-		std::vector<glm::vec3>& bitangents = m_ptr->bitangents;
-		std::vector<unsigned int>& indices = m_ptr->indices;
+		m_ptr->numVertices = numVertices;
+		m_ptr->numIndices = numIndices;
+		m_ptr->aabb = aabb;
+
+		commitOglInterleaved(format, vertices, numVertices, indices, numIndices);
+	}
+
+	unsigned int Mesh::Interleave(std::vector<float>& data) const
+	{
+		const std::vector<glm::vec3>& positions  = m_ptr->positions;
+		const std::vector<glm::vec2>& texCoords  = m_ptr->texCoords;
+		const std::vector<glm::vec3>& normals    = m_ptr->normals;
+		const std::vector<glm::vec3>& tangents   = m_ptr->tangents;
+		const std::vector<glm::vec3>& bitangents = m_ptr->bitangents;
+
+		unsigned int format = 0;
+		if (texCoords.size() > 0)  format |= MeshBuffer::TEXCOORD;
+		if (normals.size() > 0)    format |= MeshBuffer::NORMAL;
+		if (tangents.size() > 0)   format |= MeshBuffer::TANGENT;
+		if (bitangents.size() > 0) format |= MeshBuffer::BITANGENT;
+
+		// size once and write in place
+		data.resize(positions.size() * MeshBuffer::Stride(format) / sizeof(float));
+		float* vertex = data.data();
 
 		for (size_t i = 0; i < positions.size(); ++i)
 		{
-			data.push_back(positions[i].x);
-			data.push_back(positions[i].y);
-			data.push_back(positions[i].z);
+			*vertex++ = positions[i].x;
+			*vertex++ = positions[i].y;
+			*vertex++ = positions[i].z;
 
-			if (texCoords.size() > 0)
+			if (format & MeshBuffer::TEXCOORD)
 			{
-				data.push_back(texCoords[i].x);
-				data.push_back(texCoords[i].y);
+				*vertex++ = texCoords[i].x;
+				*vertex++ = texCoords[i].y;
 			}
 
-			if (normals.size() > 0)
+			if (format & MeshBuffer::NORMAL)
 			{
-				data.push_back(normals[i].x);
-				data.push_back(normals[i].y);
-				data.push_back(normals[i].z);
+				*vertex++ = normals[i].x;
+				*vertex++ = normals[i].y;
+				*vertex++ = normals[i].z;
 			}
 
-			if (tangents.size() > 0)
+			if (format & MeshBuffer::TANGENT)
 			{
-				data.push_back(tangents[i].x);
-				data.push_back(tangents[i].y);
-				data.push_back(tangents[i].z);
+				*vertex++ = tangents[i].x;
+				*vertex++ = tangents[i].y;
+				*vertex++ = tangents[i].z;
 			}
 
-			if (bitangents.size() > 0)
+			if (format & MeshBuffer::BITANGENT)
 			{
-				data.push_back(bitangents[i].x);
-				data.push_back(bitangents[i].y);
-				data.push_back(bitangents[i].z);
+				*vertex++ = bitangents[i].x;
+				*vertex++ = bitangents[i].y;
+				*vertex++ = bitangents[i].z;
 			}
 		}
 
-		glBindVertexArray(m_ptr->vao);
-		glBindBuffer(GL_ARRAY_BUFFER, m_ptr->vbo);
-		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
+		return format;
+	}
 
-		if (indices.size() > 0)
+	void Mesh::commitOglVertexInter()
+	{
+		std::vector<float> data;
+		unsigned int format = Interleave(data);
+
+		commitOglInterleaved(format, data.data(), m_ptr->numVertices, m_ptr->indices.data(), m_ptr->numIndices);
+	}
+
+	void Mesh::commitOglInterleaved(unsigned int format, const float* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices)
+	{
+		// indexed meshes share buffers and vao with all meshes of the same format
+		if (MeshBuffer::Allocate(*m_ptr, format, vertices, numVertices, indices, numIndices))
+			return;
+
+		if (!m_ptr->vao)
+		{
+			glGenVertexArrays(1, &m_ptr->vao);
+			glGenBuffers(1, &m_ptr->vbo);
+		}
+
+		GLsizei stride = MeshBuffer::Stride(format);
+
+		OglStatus::BindVertexArray(m_ptr->vao);
+		OglStatus::BindBuffer(GL_ARRAY_BUFFER, m_ptr->vbo);
+		glBufferData(GL_ARRAY_BUFFER, size_t(numVertices) * stride, vertices, GL_STATIC_DRAW);
+
+		if (numIndices > 0)
 		{
 			glGenBuffers(1, &m_ptr->ibo);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ptr->ibo);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, size_t(numIndices) * sizeof(unsigned int), indices, GL_STATIC_DRAW);
 		}
 
-		GLsizei stride = 3 * sizeof(float);
-		if (texCoords.size() > 0)  stride += 2 * sizeof(float);
-		if (normals.size() > 0)    stride += 3 * sizeof(float);
-		if (tangents.size() > 0)   stride += 3 * sizeof(float);
-		if (bitangents.size() > 0) stride += 3 * sizeof(float);
-
 		size_t offset = 0;
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offset);
 
 		offset += 3 * sizeof(float);
 
-		if (texCoords.size() > 0)
+		if (format & MeshBuffer::TEXCOORD)
 		{
 			glEnableVertexAttribArray(1);
 			glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offset);
 			offset += 2 * sizeof(float);
 		}
 
-		if (normals.size() > 0)
+		if (format & MeshBuffer::NORMAL)
 		{
 			glEnableVertexAttribArray(2);
 			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offset);
 			offset += 3 * sizeof(float);
 		}
 
-		if (tangents.size() > 0)
+		if (format & MeshBuffer::TANGENT)
 		{
 			glEnableVertexAttribArray(3);
 			glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offset);
 			offset += 3 * sizeof(float);
 		}
 
-		if (bitangents.size() > 0)
+		if (format & MeshBuffer::BITANGENT)
 		{
 			glEnableVertexAttribArray(4);
 			glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (GLvoid*)offset);
 			offset += 3 * sizeof(float);
 		}
 
-		glBindVertexArray(0);
+		OglStatus::BindVertexArray(0);
 	}
 
 	void Mesh::commitOglVertexBatch()
@@ -226,8 +275,8 @@ namespace xengine
 			data.push_back(bitangents[i].z);
 		}
 
-		glBindVertexArray(m_ptr->vao);
-		glBindBuffer(GL_ARRAY_BUFFER, m_ptr->vbo);
+		OglStatus::BindVertexArray(m_ptr->vao);
+		OglStatus::BindBuffer(GL_ARRAY_BUFFER, m_ptr->vbo);
 		glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
 
 		if (indices.size() > 0)
@@ -271,6 +320,6 @@ namespace xengine
 			offset += bitangents.size() * sizeof(float);
 		}
 
-		glBindVertexArray(0);
+		OglStatus::BindVertexArray(0);
 	}
 }
\ No newline at end of file
@@ -27,6 +27,12 @@ namespace xengine
 		unsigned int ibo = 0;
 		unsigned int topology;
 
+		// range in shared buffers of MeshBuffer (vao is shared by meshes of the same format)
+		bool pooled = false;
+		unsigned int format = 0;
+		unsigned int baseVertex = 0;
+		unsigned int firstIndex = 0;
+
 		// geometry info
 		unsigned int numVertices = 0;
 		unsigned int numIndices = 0;
@@ -46,6 +52,12 @@ namespace xengine
 		// Commit data to all resources
 		void Commit(bool flag = true);
 
+		// commit vertices already interleaved in MeshBuffer layout (e.g. mapped from a cache file)
+		void CommitInterleaved(unsigned int format, const float* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices, const AABB& aabb);
+
+		// write vertices not committed yet into data in MeshBuffer layout, return MeshBuffer::Attribute bits (no GL calls)
+		unsigned int Interleave(std::vector<float>& data) const;
+
 		explicit operator bool() const { return m_ptr && m_ptr->vao; }
 
 		inline unsigned int VAO() const { return m_ptr->vao; }
@@ -53,6 +65,10 @@ namespace xengine
 		inline unsigned int NumVtx() const { return m_ptr->numVertices; }
 		inline unsigned int NumIds() const { return m_ptr->numIndices; }
 		inline unsigned int Topology() const { return m_ptr->topology; }
+		inline bool Pooled() const { return m_ptr->pooled; }
+		inline unsigned int BaseVertex() const { return m_ptr->baseVertex; }
+		inline unsigned int FirstIndex() const { return m_ptr->firstIndex; }
+		inline bool SameData(const Mesh& other) const { return m_ptr == other.m_ptr; }
 		inline const AABB & Aabb() const { return m_ptr->aabb; }
 
 		inline unsigned int& Topology() { return m_ptr->topology; }
@@ -66,8 +82,9 @@ namespace xengine
 		std::vector<unsigned int>& Indices();
 
 	protected:
-		// commit vertices data to GPU in an interleaved way
+		// commit vertices data to GPU in an interleaved way (into MeshBuffer if mesh is indexed)
 		void commitOglVertexInter();
+		void commitOglInterleaved(unsigned int format, const float* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices);
 
 		// commit vertices data to GPU separately (in batch)
 		void commitOglVertexBatch();
@@ -0,0 +1,211 @@
+#include "mesh_buffer.h"
+
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include <graphics/ogl_status.h>
+#include <utility/log.h>
+
+namespace xengine
+{
+	namespace
+	{
+		// initial capacity of buffers, they double when full
+		const unsigned int kVertexBlock = 1 << 16;
+		const unsigned int kIndexBlock = 1 << 18;
+
+		unsigned int grownCapacity(unsigned int capacity, unsigned int size, unsigned int block)
+		{
+			unsigned int target = std::max(capacity * 2, block);
+			while (target < capacity + size) target *= 2;
+			return target;
+		}
+	}
+
+	std::unordered_map<unsigned int, MeshBuffer::Pool> MeshBuffer::g_pools;
+	unsigned int MeshBuffer::g_ibo = 0;
+	RangeAllocator MeshBuffer::g_indices;
+
+	bool MeshBuffer::Allocate(MeshMomory& mesh, unsigned int format, const float* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices)
+	{
+		if (numVertices == 0 || numIndices == 0) return false;
+
+		Pool& pool = getPool(format);
+
+		unsigned int baseVertex = pool.vertices.Allocate(numVertices);
+
+		if (baseVertex == RangeAllocator::kInvalid)
+		{
+			unsigned int capacity = pool.vertices.Capacity();
+			unsigned int grown = grownCapacity(capacity, numVertices, kVertexBlock);
+
+			growBuffer(pool.vbo, size_t(capacity) * pool.stride, size_t(grown) * pool.stride);
+			pool.vertices.Grow(grown);
+
+			OglStatus::BindVertexArray(pool.vao);
+			glBindVertexBuffer(kVertexBinding, pool.vbo, 0, pool.stride);
+			OglStatus::BindVertexArray(0);
+
+			baseVertex = pool.vertices.Allocate(numVertices);
+		}
+
+		unsigned int firstIndex = g_indices.Allocate(numIndices);
+
+		if (firstIndex == RangeAllocator::kInvalid)
+		{
+			unsigned int capacity = g_indices.Capacity();
+			unsigned int grown = grownCapacity(capacity, numIndices, kIndexBlock);
+
+			growBuffer(g_ibo, size_t(capacity) * sizeof(unsigned int), size_t(grown) * sizeof(unsigned int));
+			g_indices.Grow(grown);
+
+			// element buffer binding is part of vao state
+			for (auto& it : g_pools)
+			{
+				OglStatus::BindVertexArray(it.second.vao);
+				glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ibo);
+			}
+			OglStatus::BindVertexArray(0);
+
+			firstIndex = g_indices.Allocate(numIndices);
+		}
+
+		if (baseVertex == RangeAllocator::kInvalid || firstIndex == RangeAllocator::kInvalid)
+		{
+			Log::Message("[MeshBuffer] Allocation of " + std::to_string(numVertices) + " vertices failed", Log::ERROR);
+			pool.vertices.Free(baseVertex, numVertices);
+			g_indices.Free(firstIndex, numIndices);
+			return false;
+		}
+
+		OglStatus::BindBuffer(GL_COPY_WRITE_BUFFER, pool.vbo);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, size_t(baseVertex) * pool.stride, size_t(numVertices) * pool.stride, vertices);
+		OglStatus::BindBuffer(GL_COPY_WRITE_BUFFER, g_ibo);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, size_t(firstIndex) * sizeof(unsigned int), size_t(numIndices) * sizeof(unsigned int), indices);
+		OglStatus::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		mesh.vao = pool.vao;
+		mesh.pooled = true;
+		mesh.format = format;
+		mesh.baseVertex = baseVertex;
+		mesh.firstIndex = firstIndex;
+
+		return true;
+	}
+
+	void MeshBuffer::Free(MeshMomory& mesh)
+	{
+		if (!mesh.pooled) return;
+
+		auto it = g_pools.find(mesh.format);
+
+		// buffers may have been cleared already
+		if (it != g_pools.end())
+		{
+			it->second.vertices.Free(mesh.baseVertex, mesh.numVertices);
+			g_indices.Free(mesh.firstIndex, mesh.numIndices);
+		}
+
+		mesh.vao = 0;
+		mesh.pooled = false;
+		mesh.baseVertex = 0;
+		mesh.firstIndex = 0;
+	}
+
+	void MeshBuffer::Clear()
+	{
+		for (auto& it : g_pools)
+		{
+			OglStatus::ForgetVertexArray(it.second.vao);
+			glDeleteVertexArrays(1, &it.second.vao);
+			OglStatus::ForgetBuffer(it.second.vbo);
+			glDeleteBuffers(1, &it.second.vbo);
+		}
+
+		g_pools.clear();
+
+		if (g_ibo)
+		{
+			OglStatus::ForgetBuffer(g_ibo);
+			glDeleteBuffers(1, &g_ibo);
+			g_ibo = 0;
+		}
+
+		g_indices.Clear();
+	}
+
+	unsigned int MeshBuffer::Stride(unsigned int format)
+	{
+		unsigned int size = 3;
+		if (format & TEXCOORD)  size += 2;
+		if (format & NORMAL)    size += 3;
+		if (format & TANGENT)   size += 3;
+		if (format & BITANGENT) size += 3;
+		return size * sizeof(float);
+	}
+
+	MeshBuffer::Pool& MeshBuffer::getPool(unsigned int format)
+	{
+		auto it = g_pools.find(format);
+		if (it != g_pools.end()) return it->second;
+
+		Pool& pool = g_pools[format];
+		pool.stride = Stride(format);
+
+		if (!g_ibo)
+		{
+			growBuffer(g_ibo, 0, size_t(kIndexBlock) * sizeof(unsigned int));
+			g_indices.Clear(kIndexBlock);
+		}
+
+		growBuffer(pool.vbo, 0, size_t(kVertexBlock) * pool.stride);
+		pool.vertices.Clear(kVertexBlock);
+
+		glGenVertexArrays(1, &pool.vao);
+		OglStatus::BindVertexArray(pool.vao);
+
+		// same attribute locations as meshes with their own vao
+		unsigned int offset = 0;
+		auto attribute = [&](unsigned int location, int size)
+		{
+			glEnableVertexAttribArray(location);
+			glVertexAttribFormat(location, size, GL_FLOAT, GL_FALSE, offset);
+			glVertexAttribBinding(location, kVertexBinding);
+			offset += size * sizeof(float);
+		};
+
+		attribute(0, 3);
+		if (format & TEXCOORD)  attribute(1, 2);
+		if (format & NORMAL)    attribute(2, 3);
+		if (format & TANGENT)   attribute(3, 3);
+		if (format & BITANGENT) attribute(4, 3);
+
+		glBindVertexBuffer(kVertexBinding, pool.vbo, 0, pool.stride);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ibo);
+
+		OglStatus::BindVertexArray(0);
+
+		return pool;
+	}
+
+	void MeshBuffer::growBuffer(unsigned int& buffer, size_t oldSize, size_t newSize)
+	{
+		unsigned int grown = 0;
+		glGenBuffers(1, &grown);
+		OglStatus::BindBuffer(GL_COPY_WRITE_BUFFER, grown);
+		glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+
+		if (buffer)
+		{
+			OglStatus::BindBuffer(GL_COPY_READ_BUFFER, buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+			OglStatus::BindBuffer(GL_COPY_READ_BUFFER, 0);
+			OglStatus::ForgetBuffer(buffer);
+			glDeleteBuffers(1, &buffer);
+		}
+
+		OglStatus::BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		buffer = grown;
+	}
+}
\ No newline at end of file
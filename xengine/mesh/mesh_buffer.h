@@ -0,0 +1,68 @@
+#pragma once
+#ifndef XE_MESH_BUFFER_H
+#define XE_MESH_BUFFER_H
+
+#include <unordered_map>
+#include <vector>
+
+#include <utility/range_allocator.h>
+
+#include "mesh.h"
+
+namespace xengine
+{
+	// Shared vertex/index storage of indexed meshes (geometry megabuffer)
+	// Vertices live in one buffer per vertex format, indices of all formats in one buffer.
+	// Each format has a single vao (set up with vertex attrib binding), so meshes of the same
+	// format draw without rebinding and can be submitted together by multi-draw indirect.
+	class MeshBuffer
+	{
+	public:
+		static const unsigned int kVertexBinding = 0;
+
+		// optional vertex attributes of a format (position is always present)
+		enum Attribute
+		{
+			TEXCOORD  = 1 << 0,
+			NORMAL    = 1 << 1,
+			TANGENT   = 1 << 2,
+			BITANGENT = 1 << 3,
+		};
+
+	public:
+		// copy interleaved vertices (attribute order: position, texcoord, normal, tangent, bitangent) and
+		// mesh relative indices into the shared buffers, and point the mesh at its ranges
+		static bool Allocate(MeshMomory& mesh, unsigned int format, const float* vertices, unsigned int numVertices, const unsigned int* indices, unsigned int numIndices);
+
+		// release ranges of a mesh
+		static void Free(MeshMomory& mesh);
+
+		// delete all buffers and vaos
+		static void Clear();
+
+		// size of a vertex of given format in bytes
+		static unsigned int Stride(unsigned int format);
+
+	private:
+		struct Pool
+		{
+			unsigned int vao = 0;
+			unsigned int vbo = 0;
+			unsigned int stride = 0;
+			RangeAllocator vertices; // in vertices
+		};
+
+		// get pool of a format, create its vao on first use
+		static Pool& getPool(unsigned int format);
+
+		// reallocate a buffer with larger storage, keeping its content
+		static void growBuffer(unsigned int& buffer, size_t oldSize, size_t newSize);
+
+	private:
+		static std::unordered_map<unsigned int, Pool> g_pools; // format -> pool
+		static unsigned int g_ibo;
+		static RangeAllocator g_indices; // in indices
+	};
+}
+
+#endif // !XE_MESH_BUFFER_H
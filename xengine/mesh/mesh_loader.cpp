@@ -13,22 +13,8 @@
 
 namespace xengine
 {
-	Mesh LoadMesh_Impl_Assimp(aiMesh * aMesh)
+	Mesh ConvertMesh_Impl_Assimp(const aiMesh * aMesh)
 	{
-		// Note: Meshes can be named, but this is not a requirement and leaving
-		// this field empty is totally fine. There are mainly three uses for mesh names:
-		// @ some formats name nodes and meshes independently.
-		// @ Vertex animations refer to meshes by their names.
-		// @ importers tend to split meshes up to meet the one - material - per - mesh
-		//   requirement.  Assigning the same(dummy) name to each of the result meshes aids
-		//   the caller at recovering the original mesh partitioning.
-
-		// Note: Sometime mesh(es) in a node is nameless. Assimp importer writes mesh name
-		// the same as material name i.e., mesh name is NOT unique through out the model.
-
-		aiString aString = aMesh->mName;
-		std::string name{ aString.C_Str() };
-
 		Mesh mesh;
 
 		std::vector<glm::vec3>& positions = mesh.Positions();
@@ -72,9 +58,30 @@ namespace xengine
 			indices[i * 3 + 2] = aMesh->mFaces[i].mIndices[2];
 		}
 
-		mesh.Commit();
 		mesh.Topology() = GL_TRIANGLES;
 
+		return mesh;
+	}
+
+	Mesh LoadMesh_Impl_Assimp(aiMesh * aMesh)
+	{
+		// Note: Meshes can be named, but this is not a requirement and leaving
+		// this field empty is totally fine. There are mainly three uses for mesh names:
+		// @ some formats name nodes and meshes independently.
+		// @ Vertex animations refer to meshes by their names.
+		// @ importers tend to split meshes up to meet the one - material - per - mesh
+		//   requirement.  Assigning the same(dummy) name to each of the result meshes aids
+		//   the caller at recovering the original mesh partitioning.
+
+		// Note: Sometime mesh(es) in a node is nameless. Assimp importer writes mesh name
+		// the same as material name i.e., mesh name is NOT unique through out the model.
+
+		aiString aString = aMesh->mName;
+		std::string name{ aString.C_Str() };
+
+		Mesh mesh = ConvertMesh_Impl_Assimp(aMesh);
+		mesh.Commit();
+
 		Log::Message("[MeshLoader] Mesh \"" + name + "\" loaded successfully", Log::INFO);
 
 		return mesh;
@@ -8,6 +8,10 @@ struct aiMesh;
 
 namespace xengine
 {
+	// copy vertices and indices of aMesh into a mesh not committed yet (no GL calls, any thread)
+	Mesh ConvertMesh_Impl_Assimp(const aiMesh* aMesh);
+
+	// convert and commit aMesh
 	Mesh LoadMesh_Impl_Assimp(aiMesh* aMesh);
 }
 
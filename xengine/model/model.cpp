@@ -6,6 +6,8 @@
 namespace xengine
 {
 	Model::Model()
+		:
+		hierarchyUpdated(false)
 	{
 	}
 
@@ -20,7 +22,9 @@ namespace xengine
 		:
 		GeometryObject(other),
 		meshes(other.meshes),
-		materials(other.materials)
+		materials(other.materials),
+		aabbHierarchy(other.aabbHierarchy),
+		hierarchyUpdated(other.hierarchyUpdated)
 	{
 		for (Model* child : other.children)
 		{
@@ -34,6 +38,8 @@ namespace xengine
 		GeometryObject::operator=(other);
 		meshes = other.meshes;
 		materials = other.materials;
+		aabbHierarchy = other.aabbHierarchy;
+		hierarchyUpdated = other.hierarchyUpdated;
 
 		for (Model* child : other.children)
 		{
@@ -48,7 +54,9 @@ namespace xengine
 		:
 		GeometryObject(*other),
 		meshes(other->meshes),
-		materials(other->materials)
+		materials(other->materials),
+		aabbHierarchy(other->aabbHierarchy),
+		hierarchyUpdated(other->hierarchyUpdated)
 	{
 		// copy node contents only
 		// class private method
@@ -159,12 +167,14 @@ namespace xengine
 		meshes.push_back(mesh);
 		materials.push_back(material);
 		aabbLocal.UnionAABB(mesh.Aabb());
+		dirty = true; // global box and render commands need update
 	}
 
 	void Model::InsertChild(Model* node)
 	{
 		node->dirty = true;
 		children.push_back(node);
+		dirty = true; // notify renderer of hierarchy change
 		// Note: child won't affect parent's bounding box
 	}
 
@@ -176,16 +186,17 @@ namespace xengine
 		{
 			node->dirty = true;
 			children.erase(it);
+			dirty = true; // notify renderer of hierarchy change
 			// Note: child won't affect parent's bounding box
 		}
 	}
 
 	void Model::UpdateTransform()
 	{
-		UpdateTransform(glm::mat4{});
+		UpdateTransform(Affine());
 	}
 
-	void Model::UpdateTransform(const glm::mat4 & parentTransform)
+	void Model::UpdateTransform(const Affine & parentTransform)
 	{
 		if (dirty)
 		{
@@ -203,6 +214,21 @@ namespace xengine
 		{
 			children[i]->UpdateTransform(transform);
 		}
+
+		// gather hierarchy bounds (node without mesh has no box of its own)
+		aabbHierarchy = meshes.empty() ? AABB() : aabbGlobal;
+		hierarchyUpdated = updated;
+
+		for (Model* child : children)
+		{
+			if (child->aabbHierarchy.Valid())
+				aabbHierarchy.UnionAABB(child->aabbHierarchy);
+
+			hierarchyUpdated = hierarchyUpdated || child->hierarchyUpdated;
+		}
+
+		// scene learns of moved models without scanning them
+		if (hierarchyMoved && hierarchyUpdated) *hierarchyMoved = true;
 	}
 
 #if 0
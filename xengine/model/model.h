@@ -2,6 +2,7 @@
 #ifndef XE_MODEL_H
 #define XE_MODEL_H
 
+#include <atomic>
 #include <vector>
 #include <memory>
 
@@ -27,7 +28,7 @@ namespace xengine
 		virtual void UpdateTransform();
 
 		// update model's and all its children's transform matrices, given a parent transform matrix
-		virtual void UpdateTransform(const glm::mat4& parentTransform);
+		virtual void UpdateTransform(const Affine& parentTransform);
 
 		// insert a mesh with material
 		void InsertMesh(const Mesh & mesh, const Material & material);
@@ -63,6 +64,15 @@ namespace xengine
 
 		// hierarchical structure
 		std::vector<Model*> children;
+
+		// bounds of this node and all its descendants (refreshed by UpdateTransform)
+		AABB aabbHierarchy;
+
+		// this node or any descendant was updated by latest UpdateTransform
+		bool hierarchyUpdated;
+
+		// raised by UpdateTransform whenever hierarchy is updated (set on root models by scene, not copied)
+		std::atomic<bool>* hierarchyMoved = nullptr;
 	};
 }
 
@@ -0,0 +1,387 @@
+#include "model_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <utility/log.h>
+#include <utility/hash.h>
+#include <utility/file_system.h>
+#include <mesh/mesh_buffer.h>
+
+namespace xengine
+{
+	bool ModelCache::g_enabled = false;
+	std::string ModelCache::g_directory{};
+	std::atomic<unsigned int> ModelCache::g_hits{ 0 };
+	std::atomic<unsigned int> ModelCache::g_misses{ 0 };
+
+	namespace
+	{
+		// bump when file layout or conversion changes
+		const unsigned int kMagic = 0x31434d58; // "XMC1"
+
+		// blobs start at multiples of this, keeps mapped vertices and indices aligned
+		const size_t kBlobAlignment = 16;
+
+		const unsigned int kFormatBits = MeshBuffer::TEXCOORD | MeshBuffer::NORMAL | MeshBuffer::TANGENT | MeshBuffer::BITANGENT;
+
+		// file: header, mesh records, material and node table, blobs
+		struct FileHeader
+		{
+			unsigned int magic;
+			unsigned int numMeshes;
+			unsigned int numMaterials;
+			unsigned int numNodes;
+			unsigned long long key; // guards against hash collisions in file names
+			unsigned long long tableSize; // in bytes
+		};
+
+		struct MeshRecord
+		{
+			unsigned int format;
+			unsigned int numVertices;
+			unsigned int numIndices;
+			unsigned int material;
+			unsigned int tangents;
+			unsigned int reserved;
+			float vmin[3];
+			float vmax[3];
+			unsigned long long vertexOffset; // from start of file
+			unsigned long long indexOffset;
+		};
+
+		static_assert(sizeof(FileHeader) == 32 && sizeof(MeshRecord) == 64, "cache records must not be padded");
+
+		std::atomic<unsigned int> g_tempId{ 0 };
+
+		size_t align(size_t offset)
+		{
+			return (offset + kBlobAlignment - 1) / kBlobAlignment * kBlobAlignment;
+		}
+
+		void putUint(std::string& table, unsigned int value)
+		{
+			table.append(reinterpret_cast<const char*>(&value), sizeof(value));
+		}
+
+		void putString(std::string& table, const std::string& str)
+		{
+			putUint(table, static_cast<unsigned int>(str.size()));
+			table.append(str);
+		}
+
+		// bounds checked cursor over the table
+		struct Reader
+		{
+			const unsigned char* cur;
+			const unsigned char* end;
+
+			// false if table can't hold count records of at least recordSize bytes (checked before sizing containers)
+			bool fits(unsigned int count, size_t recordSize) const
+			{
+				return count <= size_t(end - cur) / recordSize;
+			}
+
+			bool getUint(unsigned int& value)
+			{
+				if (size_t(end - cur) < sizeof(value)) return false;
+				memcpy(&value, cur, sizeof(value));
+				cur += sizeof(value);
+				return true;
+			}
+
+			bool getString(std::string& str)
+			{
+				unsigned int size = 0;
+				if (!getUint(size) || size_t(end - cur) < size) return false;
+				str.assign(reinterpret_cast<const char*>(cur), size);
+				cur += size;
+				return true;
+			}
+		};
+
+		bool read(const MappedFile& file, unsigned long long key, const std::string& directory, ModelData& data)
+		{
+			const unsigned char* bytes = file.Data();
+			size_t size = file.Size();
+
+			FileHeader header{};
+			if (size < sizeof(header)) return false;
+			memcpy(&header, bytes, sizeof(header));
+
+			if (header.magic != kMagic || header.key != key) return false;
+
+			size_t tableOffset = sizeof(header) + size_t(header.numMeshes) * sizeof(MeshRecord);
+			if (tableOffset > size || header.tableSize > size - tableOffset) return false;
+
+			data.meshes.resize(header.numMeshes);
+
+			for (unsigned int i = 0; i < header.numMeshes; ++i)
+			{
+				MeshRecord record;
+				memcpy(&record, bytes + sizeof(header) + i * sizeof(MeshRecord), sizeof(record));
+
+				if ((record.format & ~kFormatBits) || record.material >= header.numMaterials) return false;
+
+				unsigned long long vertexSize = (unsigned long long)record.numVertices * MeshBuffer::Stride(record.format);
+				unsigned long long indexSize = (unsigned long long)record.numIndices * sizeof(unsigned int);
+
+				if (record.vertexOffset % kBlobAlignment || record.indexOffset % kBlobAlignment) return false;
+				if (record.vertexOffset > size || vertexSize > size - record.vertexOffset) return false;
+				if (record.indexOffset > size || indexSize > size - record.indexOffset) return false;
+
+				ModelData::MeshData& mesh = data.meshes[i];
+				mesh.format = record.format;
+				mesh.numVertices = record.numVertices;
+				mesh.numIndices = record.numIndices;
+				mesh.material = record.material;
+				mesh.tangents = record.tangents != 0;
+				mesh.aabb = AABB(glm::vec3(record.vmin[0], record.vmin[1], record.vmin[2]), glm::vec3(record.vmax[0], record.vmax[1], record.vmax[2]));
+				mesh.vertices = reinterpret_cast<const float*>(bytes + record.vertexOffset);
+				mesh.indices = reinterpret_cast<const unsigned int*>(bytes + record.indexOffset);
+			}
+
+			Reader reader{ bytes + tableOffset, bytes + tableOffset + header.tableSize };
+
+			// material: alpha, number of textures
+			if (!reader.fits(header.numMaterials, 2 * sizeof(unsigned int))) return false;
+			data.materials.resize(header.numMaterials);
+
+			for (ModelData::MaterialData& material : data.materials)
+			{
+				unsigned int alpha = 0, numTextures = 0;
+				if (!reader.getUint(alpha) || !reader.getUint(numTextures)) return false;
+
+				material.alpha = alpha != 0;
+
+				for (unsigned int i = 0; i < numTextures; ++i)
+				{
+					MaterialTexture texture;
+					unsigned int relative = 0, srgb = 0;
+
+					if (!reader.getString(texture.uniform) || !reader.getUint(relative) || !reader.getString(texture.path) ||
+						!reader.getUint(texture.format) || !reader.getUint(srgb)) return false;
+
+					if (relative) texture.path = directory + "/" + texture.path;
+					texture.srgb = srgb != 0;
+
+					material.textures.push_back(texture);
+				}
+			}
+
+			// node: name length, parent, number of meshes
+			if (!reader.fits(header.numNodes, 3 * sizeof(unsigned int))) return false;
+			data.nodes.resize(header.numNodes);
+
+			for (unsigned int i = 0; i < header.numNodes; ++i)
+			{
+				ModelData::NodeData& node = data.nodes[i];
+				unsigned int numMeshes = 0;
+
+				if (!reader.getString(node.name) || !reader.getUint(node.parent) || !reader.getUint(numMeshes)) return false;
+				if (node.parent != ModelData::kNoParent && node.parent >= i) return false;
+
+				if (!reader.fits(numMeshes, sizeof(unsigned int))) return false;
+				node.meshes.resize(numMeshes);
+
+				for (unsigned int& mesh : node.meshes)
+				{
+					if (!reader.getUint(mesh) || mesh >= header.numMeshes) return false;
+				}
+			}
+
+			return true;
+		}
+	}
+
+	void ModelData::ReleaseGeometry()
+	{
+		for (MeshData& mesh : meshes)
+		{
+			mesh.vertices = nullptr;
+			mesh.indices = nullptr;
+		}
+
+		vertexBlobs.clear();
+		vertexBlobs.shrink_to_fit();
+		indexBlobs.clear();
+		indexBlobs.shrink_to_fit();
+		file.Close();
+	}
+
+	void ModelCache::Initialize(const std::string& directory)
+	{
+		if (!FileSystem::CreateDirectories(directory))
+		{
+			Log::Message("[ModelCache] Cannot create cache directory \"" + directory + "\", cache disabled", Log::WARN);
+			return;
+		}
+
+		g_directory = directory;
+		g_enabled = true;
+
+		Log::Message("[ModelCache] Imported models cached in \"" + directory + "\"", Log::INFO);
+	}
+
+	bool ModelCache::Key(const std::string& path, unsigned int flags, unsigned long long& key)
+	{
+		MappedFile source;
+		if (!source.Open(path)) return false;
+
+		key = hash::fnv1a64(&kMagic, sizeof(kMagic));
+		key = hash::fnv1a64(&flags, sizeof(flags), key);
+		key = hash::fnv1a64(source.Data(), source.Size(), key);
+
+		return true;
+	}
+
+	bool ModelCache::Load(unsigned long long key, const std::string& directory, ModelData& data)
+	{
+		if (!g_enabled) return false;
+
+		std::string file = path(key);
+		MappedFile mapped;
+
+		if (!mapped.Open(file))
+		{
+			++g_misses;
+			return false;
+		}
+
+		if (!read(mapped, key, directory, data))
+		{
+			Log::Message("[ModelCache] Cached model \"" + file + "\" corrupted, importing again", Log::WARN);
+
+			data.meshes.clear();
+			data.materials.clear();
+			data.nodes.clear();
+
+			mapped.Close();
+			std::remove(file.c_str());
+			++g_misses;
+			return false;
+		}
+
+		// meshes point into the mapping
+		data.file = std::move(mapped);
+
+		++g_hits;
+		return true;
+	}
+
+	void ModelCache::Store(unsigned long long key, const std::string& directory, const ModelData& data)
+	{
+		if (!g_enabled) return;
+
+		std::string prefix = directory + "/";
+		std::string table;
+
+		for (const ModelData::MaterialData& material : data.materials)
+		{
+			putUint(table, material.alpha ? 1 : 0);
+			putUint(table, static_cast<unsigned int>(material.textures.size()));
+
+			for (const MaterialTexture& texture : material.textures)
+			{
+				// relative paths keep the cache valid for a copy of the model elsewhere
+				bool relative = texture.path.compare(0, prefix.size(), prefix) == 0;
+
+				putString(table, texture.uniform);
+				putUint(table, relative ? 1 : 0);
+				putString(table, relative ? texture.path.substr(prefix.size()) : texture.path);
+				putUint(table, texture.format);
+				putUint(table, texture.srgb ? 1 : 0);
+			}
+		}
+
+		for (const ModelData::NodeData& node : data.nodes)
+		{
+			putString(table, node.name);
+			putUint(table, node.parent);
+			putUint(table, static_cast<unsigned int>(node.meshes.size()));
+
+			for (unsigned int mesh : node.meshes) putUint(table, mesh);
+		}
+
+		FileHeader header{ kMagic, static_cast<unsigned int>(data.meshes.size()), static_cast<unsigned int>(data.materials.size()),
+			static_cast<unsigned int>(data.nodes.size()), key, table.size() };
+
+		// lay out blobs after the table
+		std::vector<MeshRecord> records(data.meshes.size());
+		size_t offset = sizeof(header) + records.size() * sizeof(MeshRecord) + table.size();
+
+		for (size_t i = 0; i < data.meshes.size(); ++i)
+		{
+			const ModelData::MeshData& mesh = data.meshes[i];
+			MeshRecord& record = records[i];
+
+			record = MeshRecord{ mesh.format, mesh.numVertices, mesh.numIndices, mesh.material, mesh.tangents ? 1u : 0u, 0,
+				{ mesh.aabb.vmin.x, mesh.aabb.vmin.y, mesh.aabb.vmin.z }, { mesh.aabb.vmax.x, mesh.aabb.vmax.y, mesh.aabb.vmax.z }, 0, 0 };
+
+			record.vertexOffset = offset = align(offset);
+			offset += data.vertexBlobs[i].size() * sizeof(float);
+			record.indexOffset = offset = align(offset);
+			offset += data.indexBlobs[i].size() * sizeof(unsigned int);
+		}
+
+		// write whole file under a temporary name, a crash never leaves a truncated model behind
+		std::string file = path(key);
+		std::string temp = file + "." + std::to_string(g_tempId++) + ".tmp";
+
+		{
+			std::ofstream out(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!out) return;
+
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(MeshRecord));
+			out.write(table.data(), table.size());
+
+			const char padding[kBlobAlignment] = {};
+			size_t written = sizeof(header) + records.size() * sizeof(MeshRecord) + table.size();
+
+			for (size_t i = 0; i < data.meshes.size(); ++i)
+			{
+				out.write(padding, records[i].vertexOffset - written);
+				out.write(reinterpret_cast<const char*>(data.vertexBlobs[i].data()), data.vertexBlobs[i].size() * sizeof(float));
+				written = records[i].vertexOffset + data.vertexBlobs[i].size() * sizeof(float);
+
+				out.write(padding, records[i].indexOffset - written);
+				out.write(reinterpret_cast<const char*>(data.indexBlobs[i].data()), data.indexBlobs[i].size() * sizeof(unsigned int));
+				written = records[i].indexOffset + data.indexBlobs[i].size() * sizeof(unsigned int);
+			}
+
+			if (!out)
+			{
+				out.close();
+				std::remove(temp.c_str());
+				return;
+			}
+		}
+
+		std::remove(file.c_str());
+
+		if (std::rename(temp.c_str(), file.c_str()) != 0)
+		{
+			Log::Message("[ModelCache] Cannot write \"" + file + "\"", Log::WARN);
+			std::remove(temp.c_str());
+		}
+	}
+
+	void ModelCache::Clear()
+	{
+		if (g_enabled)
+			Log::Message("[ModelCache] " + std::to_string(g_hits) + " models loaded from cache, " + std::to_string(g_misses) + " imported", Log::INFO);
+
+		g_enabled = false;
+		g_hits = 0;
+		g_misses = 0;
+	}
+
+	std::string ModelCache::path(unsigned long long key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.xmc", key);
+		return g_directory + "/" + name;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef XE_MODEL_CACHE_H
+#define XE_MODEL_CACHE_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <geometry/aabb.h>
+#include <graphics/material_loader.h>
+#include <utility/mapped_file.h>
+
+namespace xengine
+{
+	// model in engine-native layout, converted from an imported scene or mapped from a cache file
+	struct ModelData
+	{
+		static const unsigned int kNoParent = 0xffffffff;
+
+		struct MeshData
+		{
+			unsigned int format = 0; // MeshBuffer::Attribute bits
+			unsigned int numVertices = 0;
+			unsigned int numIndices = 0;
+			unsigned int material = 0; // index into materials
+			bool tangents = false; // source mesh has tangent space
+			AABB aabb;
+			const float* vertices = nullptr; // interleaved in MeshBuffer layout
+			const unsigned int* indices = nullptr;
+		};
+
+		struct MaterialData
+		{
+			bool alpha = false;
+			std::vector<MaterialTexture> textures;
+		};
+
+		struct NodeData
+		{
+			std::string name;
+			unsigned int parent = kNoParent; // parents precede their children
+			std::vector<unsigned int> meshes; // indices into meshes
+		};
+
+		std::vector<MeshData> meshes;
+		std::vector<MaterialData> materials;
+		std::vector<NodeData> nodes;
+
+		// storage behind vertices and indices of meshes: converted blobs or a mapped cache file
+		std::vector<std::vector<float>> vertexBlobs;
+		std::vector<std::vector<unsigned int>> indexBlobs;
+		MappedFile file;
+
+		// drop vertices and indices once they are uploaded
+		void ReleaseGeometry();
+	};
+
+	// on-disk cache of imported models
+	// A model is keyed by a hash of its source file and the import flags. The cache file holds the mesh
+	// table, materials and node hierarchy followed by vertex and index blobs, which are mapped and handed
+	// to GL without a copy. Files referenced by the source (e.g. .mtl) are not part of the key, delete the
+	// cache directory after editing them.
+	class ModelCache
+	{
+	public:
+		// open cache directory (created if missing)
+		static void Initialize(const std::string& directory = "cache/models");
+
+		// key of a model file imported with flags, return false if file cannot be read
+		static bool Key(const std::string& path, unsigned int flags, unsigned long long& key);
+
+		// map cached model of key, texture paths are resolved against directory (any thread)
+		static bool Load(unsigned long long key, const std::string& directory, ModelData& data);
+
+		// write model under key, texture paths are stored relative to directory (any thread)
+		static void Store(unsigned long long key, const std::string& directory, const ModelData& data);
+
+		static bool Enabled() { return g_enabled; }
+
+		static void Clear();
+
+	private:
+		static std::string path(unsigned long long key);
+
+	private:
+		static bool g_enabled;
+		static std::string g_directory;
+
+		static std::atomic<unsigned int> g_hits;
+		static std::atomic<unsigned int> g_misses;
+	};
+}
+
+#endif // !XE_MODEL_CACHE_H
@@ -1,72 +1,221 @@
 #include "model_loader.h"
 
+#include <memory>
+
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 
+#include <glad/glad.h>
+
 #include <geometry/constant.h>
 #include <utility/log.h>
+#include <utility/job_system.h>
 #include <mesh/mesh_loader.h>
 #include <graphics/material_loader.h>
+#include <graphics/texture_manager.h>
+
+#include "model_cache.h"
 
 namespace xengine
 {
-	static Model * LoadModel_Impl_Assimp(aiNode * aNode, const aiScene * aScene, const std::string & path)
+	namespace
 	{
-		// Note: The name might be empty (length of zero) but all nodes which need
-		// to be accessed afterwards by bones or anims are usually named. Multiple
-		// nodes may have the same name, but nodes which are accessed by bones (see
-		// aiBone and aiMesh::mBones) must be unique.
+		// part of cache key, cached models of other flags are not reused
+		const unsigned int kImportFlags = aiProcess_Triangulate | aiProcess_CalcTangentSpace;
+
+		struct Import
+		{
+			std::string path;
+			std::string directory;
+			bool loaded = false;
+			ModelData data; // converted or mapped from cache
+			std::vector<Mesh> meshes; // committed from data on main thread
+		};
 
-		aiString aString = aNode->mName;
-		std::string name{ aString.C_Str() };
-		Model* node = new Model;
+		// flatten node tree in pre-order, parents precede their children
+		void flatten(const aiNode* aNode, unsigned int parent, ModelData& data)
+		{
+			unsigned int index = static_cast<unsigned int>(data.nodes.size());
+
+			// Note: The name might be empty (length of zero) but all nodes which need
+			// to be accessed afterwards by bones or anims are usually named. Multiple
+			// nodes may have the same name, but nodes which are accessed by bones (see
+			// aiBone and aiMesh::mBones) must be unique.
+
+			ModelData::NodeData node;
+			node.name = aNode->mName.C_Str();
+			node.parent = parent;
+			node.meshes.assign(aNode->mMeshes, aNode->mMeshes + aNode->mNumMeshes);
+			data.nodes.push_back(node);
+
+			for (unsigned int i = 0; i < aNode->mNumChildren; ++i)
+				flatten(aNode->mChildren[i], index, data);
+		}
 
-		for (unsigned int i = 0; i < aNode->mNumMeshes; ++i)
+		// convert scene into engine layout, meshes in parallel (worker thread)
+		void convert(const aiScene* aScene, Import& import)
 		{
-			aiMesh* aMesh = aScene->mMeshes[aNode->mMeshes[i]];
-			aiMaterial* aMaterial = aScene->mMaterials[aMesh->mMaterialIndex];
+			ModelData& data = import.data;
 
-			Mesh mesh = LoadMesh_Impl_Assimp(aMesh);
-			Material material = LoadMaterial_Impl_Assimp(aMaterial, path, aMesh);
+			data.meshes.resize(aScene->mNumMeshes);
+			data.vertexBlobs.resize(aScene->mNumMeshes);
+			data.indexBlobs.resize(aScene->mNumMeshes);
 
-			node->meshes.push_back(mesh);
-			node->materials.push_back(material);
-			node->aabbLocal.UnionAABB(mesh.Aabb()); // update local bounding box
+			JobSystem::ParallelFor(aScene->mNumMeshes, 1, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					const aiMesh* aMesh = aScene->mMeshes[i];
+					Mesh mesh = ConvertMesh_Impl_Assimp(aMesh);
+
+					ModelData::MeshData& meshData = data.meshes[i];
+					meshData.format = mesh.Interleave(data.vertexBlobs[i]);
+					meshData.numVertices = static_cast<unsigned int>(mesh.Positions().size());
+					meshData.numIndices = static_cast<unsigned int>(mesh.Indices().size());
+					meshData.material = aMesh->mMaterialIndex;
+					meshData.tangents = aMesh->HasTangentsAndBitangents();
+					meshData.aabb.BuildFromVertices(mesh.Positions());
+
+					data.indexBlobs[i].swap(mesh.Indices());
+					meshData.vertices = data.vertexBlobs[i].data();
+					meshData.indices = data.indexBlobs[i].data();
+				}
+			});
+
+			data.materials.resize(aScene->mNumMaterials);
+
+			for (unsigned int i = 0; i < aScene->mNumMaterials; ++i)
+			{
+				data.materials[i].alpha = IsAlpha_Impl_Assimp(aScene->mMaterials[i]);
+				data.materials[i].textures = ListTextures_Impl_Assimp(aScene->mMaterials[i], import.directory);
+			}
+
+			flatten(aScene->mRootNode, ModelData::kNoParent, data);
 		}
 
-		for (unsigned int i = 0; i < aNode->mNumChildren; ++i)
+		// map model from cache, or import file and cache it (worker thread)
+		void parse(Import& import)
 		{
-			Model * child = LoadModel_Impl_Assimp(aNode->mChildren[i], aScene, path);
-			node->InsertChild(child);
-			// current node won't update bounding box based on children's box
+			unsigned long long key = 0;
+			bool keyed = ModelCache::Enabled() && ModelCache::Key(import.path, kImportFlags, key);
+
+			if (keyed && ModelCache::Load(key, import.directory, import.data))
+			{
+				Log::Message("[ModelLoader] Model \"" + import.path + "\" loaded from cache", Log::INFO);
+				import.loaded = true;
+				return;
+			}
+
+			// scene is released as soon as it is converted
+			Assimp::Importer importer;
+			const aiScene* aScene = importer.ReadFile(import.path, kImportFlags);
+
+			if (!aScene || aScene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !aScene->mRootNode)
+			{
+				Log::Message("[ModelLoader] Model \"" + import.path + "\" failed to load", Log::ERROR);
+				return;
+			}
+
+			convert(aScene, import);
+			import.loaded = true;
+
+			if (keyed) ModelCache::Store(key, import.directory, import.data);
 		}
 
-		Log::Message("[ModelLoader] Node \"" + name + "\" loaded successfully", Log::INFO);
+		// build node hierarchy, return root
+		Model* build(const Import& import)
+		{
+			const ModelData& data = import.data;
+			std::vector<Model*> nodes(data.nodes.size());
+
+			for (size_t i = 0; i < data.nodes.size(); ++i)
+			{
+				const ModelData::NodeData& nodeData = data.nodes[i];
+				Model* node = new Model;
+
+				for (unsigned int index : nodeData.meshes)
+				{
+					const ModelData::MeshData& meshData = data.meshes[index];
+					const ModelData::MaterialData& materialData = data.materials[meshData.material];
+
+					// meshes referenced by several nodes share their buffers
+					const Mesh& mesh = import.meshes[index];
+					Material material = LoadMaterial(materialData.alpha, meshData.tangents, materialData.textures);
+
+					node->meshes.push_back(mesh);
+					node->materials.push_back(material);
+					node->aabbLocal.UnionAABB(mesh.Aabb()); // update local bounding box
+				}
 
-		return node;
+				// current node won't update bounding box based on children's box
+				if (nodeData.parent != ModelData::kNoParent)
+					nodes[nodeData.parent]->InsertChild(node);
+
+				nodes[i] = node;
+
+				Log::Message("[ModelLoader] Node \"" + nodeData.name + "\" loaded successfully", Log::INFO);
+			}
+
+			return nodes.empty() ? nullptr : nodes.front();
+		}
 	}
 
 	Model * LoadModel_Impl_Assimp(const std::string & path)
 	{
-		Assimp::Importer importer;
-		const aiScene* aScene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_CalcTangentSpace);
+		return LoadModels_Impl_Assimp({ path }).front();
+	}
+
+	std::vector<Model*> LoadModels_Impl_Assimp(const std::vector<std::string>& paths)
+	{
+		// 1. map cached models, or parse files and convert meshes on workers
+		std::vector<Import> imports(paths.size());
+		std::vector<JobHandle> parses;
+
+		for (size_t i = 0; i < paths.size(); ++i)
+		{
+			Import& import = imports[i];
+			import.path = paths[i];
+			import.directory = paths[i].substr(0, paths[i].find_last_of("/"));
+			parses.push_back(JobSystem::Submit([&import]() { parse(import); }));
+		}
 
-		if (!aScene || aScene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !aScene->mRootNode)
+		for (const JobHandle& job : parses) JobSystem::Wait(job);
+
+		// 2. request every texture file once, files are decoded in background and streamed in over frames
+		// (see TextureStreamer), materials show the null texture until then
+		for (const Import& import : imports)
 		{
-			Log::Message("[ModelLoader] Model \"" + path + "\" failed to load", Log::ERROR);
-			return nullptr;
+			for (const ModelData::MaterialData& material : import.data.materials)
+			{
+				// a path already requested (or loaded) is found in texture table
+				for (const MaterialTexture& texture : material.textures)
+					TextureManager::RequestLocalTexture2D(texture.path, texture.path, texture.format, texture.srgb);
+			}
+		}
+
+		// 3. upload meshes while images decode, mapped vertices go to GL without a copy
+		for (Import& import : imports)
+		{
+			for (const ModelData::MeshData& meshData : import.data.meshes)
+			{
+				Mesh mesh;
+				mesh.CommitInterleaved(meshData.format, meshData.vertices, meshData.numVertices, meshData.indices, meshData.numIndices, meshData.aabb);
+				mesh.Topology() = GL_TRIANGLES;
+				import.meshes.push_back(mesh);
+			}
+
+			import.data.ReleaseGeometry();
 		}
 
-		std::string directory = path.substr(0, path.find_last_of("/"));
-		Model * node = LoadModel_Impl_Assimp(aScene->mRootNode, aScene, directory);
+		// 4. build node hierarchy, materials find requested textures in TextureManager
+		std::vector<Model*> models;
 
-		if (!node)
+		for (const Import& import : imports)
 		{
-			Log::Message("[ModelManager] Model \"" + path + "\" loading failed", Log::ERROR);
-			return nullptr;
+			models.push_back(import.loaded ? build(import) : nullptr);
 		}
 
-		return node;
+		return models;
 	}
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
 #ifndef XE_MODEL_LOADER_H
 #define XE_MODEL_LOADER_H
 
+#include <string>
+#include <vector>
+
 #include "model.h"
 
 struct aiNode;
@@ -11,6 +14,12 @@ namespace xengine
 {
 	// load model from file of wave-front format
 	Model * LoadModel_Impl_Assimp(const std::string& path);
+
+	// load models from files (nullptr for files failed to load)
+	// Files are parsed and their meshes converted on job system workers, several files at once,
+	// meshes are created on calling (main) thread. Textures are requested from TextureManager
+	// and streamed in over following frames (see TextureStreamer).
+	std::vector<Model*> LoadModels_Impl_Assimp(const std::vector<std::string>& paths);
 }
 
 #endif // !XE_MODEL_LOADER_H
@@ -60,6 +60,16 @@ namespace xengine
 		return loadModel(name, path, g_globalTable);
 	}
 
+	std::vector<Model*> ModelManager::LoadLocalModels(const std::vector<std::string>& names, const std::vector<std::string>& paths)
+	{
+		return loadModels(names, paths, g_localTable);
+	}
+
+	std::vector<Model*> ModelManager::LoadGlobalModels(const std::vector<std::string>& names, const std::vector<std::string>& paths)
+	{
+		return loadModels(names, paths, g_globalTable);
+	}
+
 	Model * ModelManager::Get(const std::string & name)
 	{
 		{
@@ -78,18 +88,50 @@ namespace xengine
 
 	Model * ModelManager::loadModel(const std::string & name, const std::string & path, std::unordered_map<std::string, Model*>& table)
 	{
-		auto it = table.find(name);
-		if (it != table.end()) return it->second;
+		return loadModels({ name }, { path }, table).front();
+	}
+
+	std::vector<Model*> ModelManager::loadModels(const std::vector<std::string>& names, const std::vector<std::string>& paths, std::unordered_map<std::string, Model*>& table)
+	{
+		std::vector<Model*> models(names.size(), nullptr);
+		std::vector<std::string> loadPaths;
+		std::vector<size_t> loadIndices;
 
-		Log::Message("[ModelManager] Loading model \"" + name + "\" from \"" + path + "\" ...", Log::INFO);
+		for (size_t i = 0; i < names.size() && i < paths.size(); ++i)
+		{
+			auto it = table.find(names[i]);
+
+			if (it != table.end())
+			{
+				models[i] = it->second;
+				continue;
+			}
+
+			Log::Message("[ModelManager] Loading model \"" + names[i] + "\" from \"" + paths[i] + "\" ...", Log::INFO);
+
+			loadPaths.push_back(paths[i]);
+			loadIndices.push_back(i);
+		}
 
-		Model * node = LoadModel_Impl_Assimp(path);
+		if (loadPaths.empty()) return models;
 
-		g_localTable[name] = node; // only added root node to model lookup table
+		std::vector<Model*> loaded = LoadModels_Impl_Assimp(loadPaths);
 
-		Log::Message("[ModelManager] Model \"" + name + "\" loaded successfully", Log::INFO);
+		for (size_t i = 0; i < loaded.size(); ++i)
+		{
+			const std::string& name = names[loadIndices[i]];
+			Model * node = loaded[i];
+
+			table[name] = node; // only added root node to model lookup table
+			models[loadIndices[i]] = node;
+
+			if (node)
+				Log::Message("[ModelManager] Model \"" + name + "\" loaded successfully", Log::INFO);
+			else
+				Log::Message("[ModelManager] Model \"" + name + "\" loading failed", Log::ERROR);
+		}
 
-		return node;
+		return models;
 	}
 
 	void ModelManager::generateDefaultModel()
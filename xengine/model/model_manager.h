@@ -34,11 +34,16 @@ namespace xengine
 		static Model* LoadLocalModel(const std::string& name, const std::string& path);
 		static Model* LoadGlobalModel(const std::string& name, const std::string& path);
 
+		// load models from files in parallel (names and paths are paired by index)
+		static std::vector<Model*> LoadLocalModels(const std::vector<std::string>& names, const std::vector<std::string>& paths);
+		static std::vector<Model*> LoadGlobalModels(const std::vector<std::string>& names, const std::vector<std::string>& paths);
+
 		// get named model
 		static Model* Get(const std::string& name);
 
 	private:
 		static Model* loadModel(const std::string& name, const std::string& path, std::unordered_map<std::string, Model*>& table);
+		static std::vector<Model*> loadModels(const std::vector<std::string>& names, const std::vector<std::string>& paths, std::unordered_map<std::string, Model*>& table);
 
 		static void generateDefaultModel();
 
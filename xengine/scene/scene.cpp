@@ -8,12 +8,23 @@
 
 namespace xengine
 {
+	Counter Scene::g_revisionCounter;
+
 	Scene::Scene()
+		:
+		m_stillTreeDirty(false),
+		m_stillMoved(false),
+		m_movingMoved(false),
+		m_identity(g_revisionCounter.Increment()),
+		m_revision(m_identity)
 	{
 	}
 
 	Scene::~Scene()
 	{
+		// models may outlive the scene
+		for (Model* model : models)
+			model->hierarchyMoved = nullptr;
 	}
 
 	void Scene::Initialize()
@@ -41,15 +52,135 @@ namespace xengine
 	{
 		models.push_back(model);
 
-		if (isStill) stillModels.push_back(model);
-		else movingModels.push_back(model);
+		if (isStill)
+		{
+			stillModels.push_back(model);
+			model->hierarchyMoved = &m_stillMoved;
+			m_stillTreeDirty = true;
+		}
+		else
+		{
+			movingModels.push_back(model);
+			model->hierarchyMoved = &m_movingMoved;
+			m_movingProxies[model] = AABBTree::kNull; // inserted once transformed
+			m_movingMoved = true;
+		}
+
+		m_revision = g_revisionCounter.Increment();
 	}
 
 	void Scene::RemoveModel(Model* model)
 	{
-		models.erase(std::find(models.begin(), models.end(), model));
-		stillModels.erase(std::find(stillModels.begin(), stillModels.end(), model));
-		movingModels.erase(std::find(movingModels.begin(), movingModels.end(), model));
+		auto it = std::find(models.begin(), models.end(), model);
+		if (it == models.end()) return;
+
+		models.erase(it);
+		model->hierarchyMoved = nullptr;
+
+		// model is either still or moving
+		it = std::find(stillModels.begin(), stillModels.end(), model);
+		if (it != stillModels.end())
+		{
+			stillModels.erase(it);
+			m_stillTreeDirty = true;
+		}
+
+		it = std::find(movingModels.begin(), movingModels.end(), model);
+		if (it != movingModels.end()) movingModels.erase(it);
+
+		auto itp = m_movingProxies.find(model);
+		if (itp != m_movingProxies.end())
+		{
+			if (itp->second != AABBTree::kNull) movingTree.Remove(itp->second);
+			m_movingProxies.erase(itp);
+		}
+
+		m_revision = g_revisionCounter.Increment();
+	}
+
+	void Scene::updateBounds()
+	{
+		// a fat leaf box still holding the hierarchy leaves tree alone, so refitting all is cheap
+		if (m_movingMoved.exchange(false))
+		{
+			for (Model* model : movingModels)
+			{
+				int& proxy = m_movingProxies[model];
+
+				if (!model->aabbHierarchy.Valid()) continue;
+
+				if (proxy == AABBTree::kNull)
+					proxy = movingTree.Insert(model->aabbHierarchy, model);
+				else
+					movingTree.Update(proxy, model->aabbHierarchy);
+			}
+		}
+
+		// still model is not expected to move, but keep tree correct if it does
+		if (m_stillMoved.exchange(false)) m_stillTreeDirty = true;
+
+		if (m_stillTreeDirty)
+		{
+			std::vector<AABB> aabbs;
+			std::vector<void*> data;
+
+			for (Model* model : stillModels)
+			{
+				if (!model->aabbHierarchy.Valid()) continue;
+
+				aabbs.push_back(model->aabbHierarchy);
+				data.push_back(model);
+			}
+
+			stillTree.Build(aabbs, data);
+			m_stillTreeDirty = false;
+		}
+	}
+
+	void Scene::gatherResults(std::vector<void*>& found, std::vector<Model*>& results) const
+	{
+		for (void* data : found)
+			results.push_back(static_cast<Model*>(data));
+	}
+
+	void Scene::QueryFrustum(const Frustum& frustum, std::vector<Model*>& results)
+	{
+		updateBounds();
+
+		std::vector<void*> found;
+		stillTree.QueryFrustum(frustum, found);
+		movingTree.QueryFrustum(frustum, found);
+		gatherResults(found, results);
+	}
+
+	void Scene::QuerySphere(const glm::vec3& center, float radius, std::vector<Model*>& results)
+	{
+		updateBounds();
+
+		std::vector<void*> found;
+		stillTree.QuerySphere(center, radius, found);
+		movingTree.QuerySphere(center, radius, found);
+		gatherResults(found, results);
+	}
+
+	void Scene::QueryBox(const AABB& aabb, std::vector<Model*>& results)
+	{
+		updateBounds();
+
+		std::vector<void*> found;
+		stillTree.QueryBox(aabb, found);
+		movingTree.QueryBox(aabb, found);
+		gatherResults(found, results);
+	}
+
+	void Scene::QueryRay(const glm::vec3& origin, const glm::vec3& dir, float tmax, std::vector<Model*>& results)
+	{
+		updateBounds();
+
+		std::vector<void*> found;
+		stillTree.QueryRay(origin, dir, tmax, found);
+		movingTree.QueryRay(origin, dir, tmax, found);
+		gatherResults(found, results);
 	}
 
 	////////////////////////////////////////////////////////////////
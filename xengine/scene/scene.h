@@ -2,8 +2,10 @@
 #ifndef XE_SCENE_H
 #define XE_SCENE_H
 
+#include <atomic>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 #include <graphics/texture.h>
 #include <graphics/material.h>
@@ -11,6 +13,8 @@
 #include <model/model.h>
 #include <graphics/light.h>
 #include <graphics/particle_system.h>
+#include <geometry/aabb_tree.h>
+#include <utility/counter.h>
 
 namespace xengine
 {
@@ -33,6 +37,13 @@ namespace xengine
 		void InsertModel(Model* model, bool isStill = false);
 		void RemoveModel(Model* model);
 
+		// models overlapping a volume (both still and moving ones)
+		// trees are brought up to date on query, only after UpdateTransform reported a moved hierarchy
+		void QueryFrustum(const Frustum& frustum, std::vector<Model*>& results);
+		void QuerySphere(const glm::vec3& center, float radius, std::vector<Model*>& results);
+		void QueryBox(const AABB& aabb, std::vector<Model*>& results);
+		void QueryRay(const glm::vec3& origin, const glm::vec3& dir, float tmax, std::vector<Model*>& results);
+
 		// light
 		void AddLight(ParallelLight* light);
 		void AddLight(PointLight* light);
@@ -40,14 +51,24 @@ namespace xengine
 		// particle
 		void AddParticle(ParticleSystem* particle);
 
+		// unique stamp of this scene
+		inline unsigned long long Identity() const { return m_identity; }
+
+		// unique stamp of current model set (renewed whenever a model is inserted or removed)
+		inline unsigned long long Revision() const { return m_revision; }
+
 	public:
 		// all models in the scene
 		std::vector<Model*> models;
 
-		// TODO
+		// models never moved after insertion, and the others
 		std::vector<Model*> stillModels;
 		std::vector<Model*> movingModels;
 
+		// bounding volume hierarchies over model hierarchies
+		AABBTree stillTree; // built at once (on first query)
+		AABBTree movingTree; // refit incrementally (on query)
+
 		// lights
 		std::vector<ParallelLight*> parallelLights;
 		std::vector<PointLight*> pointLights;
@@ -58,6 +79,31 @@ namespace xengine
 		// ambient (IBL) (bad practice to put a big module in general scene class)
 		CubeMap irradianceMap;
 		CubeMap reflectionMap;
+
+	private:
+		// refit moving tree if a moving model moved, rebuild still tree if a still model moved
+		void updateBounds();
+
+		// append query results of both trees
+		void gatherResults(std::vector<void*>& found, std::vector<Model*>& results) const;
+
+	private:
+		// proxy of each moving model in moving tree (kNull until its bounds are known)
+		std::unordered_map<Model*, int> m_movingProxies;
+
+		// still model set changed since last build
+		bool m_stillTreeDirty;
+
+		// raised by UpdateTransform of inserted models (Model::hierarchyMoved points here)
+		std::atomic<bool> m_stillMoved;
+		std::atomic<bool> m_movingMoved;
+
+		// stamps (unique through all scenes, so renderer can tell scenes apart)
+		unsigned long long m_identity;
+		unsigned long long m_revision;
+
+		// stamp generator
+		static Counter g_revisionCounter;
 	};
 }
 
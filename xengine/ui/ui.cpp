@@ -7,6 +7,7 @@
 #include <imgui/imgui_impl_opengl3.h>
 
 #include <graphics/render_config.h>
+#include <graphics/render_stats.h>
 
 namespace xengine
 {
@@ -49,6 +50,8 @@ namespace xengine
 			ImGui::Checkbox("Irradiance Probe [WIP]", &RenderConfig::_config.useIrradianceGI);
 			ImGui::Checkbox("Parallel Shadow", &RenderConfig::_config.useParallelShadow);
 			ImGui::Checkbox("Pt Lights Sphere", &RenderConfig::_config.useRenderLights);
+			ImGui::Checkbox("Clustered Pt Lights", &RenderConfig::_config.useClusteredLights);
+			ImGui::Checkbox("GPU Light Culling", &RenderConfig::_config.useGpuLightCulling);
 		}
 
 		if (ImGui::CollapsingHeader("Effect Options"))
@@ -68,6 +71,12 @@ namespace xengine
 			ImGui::Checkbox("Ambient Probes", &RenderConfig::_config.useRenderProbes);
 		}
 
+		if (ImGui::CollapsingHeader("Statistics"))
+		{
+			ImGui::Text("Proxies %u (touched %u)", RenderStats::_stats.numProxies, RenderStats::_stats.numProxiesTouched);
+			ImGui::Text("OpenGL state calls %u (skipped %u)", RenderStats::_stats.numOglCalls, RenderStats::_stats.numOglCallsSkipped);
+		}
+
 		ImGui::End();
 
 		ImGui::Render();
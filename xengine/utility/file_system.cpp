@@ -18,4 +18,12 @@ namespace xengine
 		std::error_code ec;
 		return std::filesystem::is_directory(path, ec);
 	}
+
+	bool FileSystem::CreateDirectories(const std::string& directory)
+	{
+		std::filesystem::path path(directory);
+		std::error_code ec;
+		std::filesystem::create_directories(path, ec);
+		return std::filesystem::is_directory(path, ec);
+	}
 }
\ No newline at end of file
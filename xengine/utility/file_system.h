@@ -11,6 +11,9 @@ namespace xengine
 	public:
 		static bool Exist(const std::string& path);
 		static bool IsDirectory(const std::string& path);
+
+		// create directory and missing parents, return true if directory exists afterwards
+		static bool CreateDirectories(const std::string& path);
 	};
 }
 
@@ -19,6 +19,40 @@ namespace xengine
 
 			return code;
 		}
+
+		// 32-bit FNV-1a, usable in constant expressions (e.g. names known at compile time)
+		constexpr unsigned int fnv1a(const char* str)
+		{
+			unsigned int code = 2166136261u;
+
+			for (; *str; ++str)
+			{
+				code ^= static_cast<unsigned char>(*str);
+				code *= 16777619u;
+			}
+
+			return code;
+		}
+
+		inline unsigned int fnv1a(const std::string& str)
+		{
+			return fnv1a(str.c_str());
+		}
+
+		// 64-bit FNV-1a over bytes, chain calls by passing previous code as seed
+		inline unsigned long long fnv1a64(const void* data, size_t size, unsigned long long seed = 14695981039346656037ull)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			unsigned long long code = seed;
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				code ^= bytes[i];
+				code *= 1099511628211ull;
+			}
+
+			return code;
+		}
 	}
 }
 
@@ -0,0 +1,338 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+#include "log.h"
+
+namespace xengine
+{
+	////////////////////////////////////////////////////////////////
+	// Job System
+	//
+	// Every thread (main thread included) owns a queue. Jobs are
+	// pushed to the queue of the submitting thread, popped LIFO by
+	// the owner and stolen FIFO by idle threads. Waiting threads
+	// keep executing jobs, so waits never block the whole pool.
+	// Background jobs share one FIFO left to workers, a frame
+	// waiting on its own jobs never picks up seconds of streaming.
+	////////////////////////////////////////////////////////////////
+
+	std::vector<std::unique_ptr<JobSystem::WorkQueue>> JobSystem::g_queues;
+	JobSystem::WorkQueue JobSystem::g_backgroundQueue;
+	std::vector<std::thread> JobSystem::g_workers;
+
+	std::mutex JobSystem::g_sleepMutex;
+	std::condition_variable JobSystem::g_sleepCond;
+	std::atomic<int> JobSystem::g_numQueued(0);
+	std::atomic<bool> JobSystem::g_running(false);
+
+	std::vector<std::function<void()>> JobSystem::g_mainThreadJobs;
+	std::mutex JobSystem::g_mainThreadMutex;
+	std::thread::id JobSystem::g_mainThreadId;
+
+	namespace
+	{
+		// queue index of current thread
+		thread_local unsigned int t_queueIndex = 0;
+
+		// current thread is running a background job
+		thread_local bool t_background = false;
+	}
+
+	void JobSystem::Initialize(unsigned int numWorkers)
+	{
+		if (g_running) return;
+
+		if (numWorkers == 0)
+		{
+			unsigned int hw = std::thread::hardware_concurrency();
+			numWorkers = hw > 1 ? hw - 1 : 0;
+		}
+
+		g_mainThreadId = std::this_thread::get_id();
+		t_queueIndex = 0;
+
+		g_queues.clear();
+		for (unsigned int i = 0; i <= numWorkers; ++i)
+			g_queues.emplace_back(new WorkQueue());
+
+		g_running = true;
+
+		for (unsigned int i = 1; i <= numWorkers; ++i)
+			g_workers.emplace_back(&JobSystem::workerLoop, i);
+
+		Log::Message("[JobSystem] Workers: " + std::to_string(numWorkers), Log::INFO);
+	}
+
+	void JobSystem::Clear()
+	{
+		if (!g_running) return;
+
+		// drain jobs still queued
+		while (g_numQueued > 0) execute(true);
+
+		{
+			std::lock_guard<std::mutex> lock(g_sleepMutex);
+			g_running = false;
+		}
+
+		g_sleepCond.notify_all();
+
+		for (std::thread& worker : g_workers)
+			worker.join();
+
+		g_workers.clear();
+		g_queues.clear();
+
+		ProcessMainThreadJobs();
+	}
+
+	JobHandle JobSystem::Submit(const std::function<void()>& func, const std::vector<JobHandle>& dependencies, const JobHandle& parent)
+	{
+		return submit(func, dependencies, parent, t_background);
+	}
+
+	JobHandle JobSystem::SubmitBackground(const std::function<void()>& func)
+	{
+		return submit(func, {}, nullptr, true);
+	}
+
+	JobHandle JobSystem::submit(const std::function<void()>& func, const std::vector<JobHandle>& dependencies, const JobHandle& parent, bool background)
+	{
+		JobHandle job = std::make_shared<Job>();
+		job->func = func;
+		job->parent = parent;
+		job->background = background;
+
+		if (parent) ++parent->unfinished;
+
+		// pendingDeps starts at 1 so that job cannot be scheduled while dependencies are registered
+		for (const JobHandle& dep : dependencies)
+		{
+			if (!dep) continue;
+
+			std::lock_guard<std::mutex> lock(dep->mutex);
+
+			if (!dep->done)
+			{
+				++job->pendingDeps;
+				dep->dependents.push_back(job);
+			}
+		}
+
+		if (--job->pendingDeps == 0)
+			schedule(job);
+
+		return job;
+	}
+
+	void JobSystem::Wait(const JobHandle& job)
+	{
+		if (!job) return;
+
+		// a wait inside frame work (on any thread) must not pick up a background job
+		bool background = t_background || job->background;
+
+		while (job->unfinished > 0)
+		{
+			if (!execute(background)) std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& func)
+	{
+		if (count == 0) return;
+
+		// a few chunks per thread leaves room for stealing on uneven work
+		size_t numChunks = std::max<size_t>(1, std::min<size_t>(count / std::max<size_t>(grain, 1), NumThreads() * 4));
+
+		if (numChunks == 1)
+		{
+			func(0, count);
+			return;
+		}
+
+		size_t chunk = (count + numChunks - 1) / numChunks;
+
+		JobHandle root = std::make_shared<Job>();
+
+		// caller runs the first chunk itself
+		for (size_t begin = chunk; begin < count; begin += chunk)
+		{
+			size_t end = std::min(begin + chunk, count);
+			Submit([&func, begin, end]() { func(begin, end); }, {}, root);
+		}
+
+		func(0, std::min(chunk, count));
+
+		finish(root);
+		Wait(root);
+	}
+
+	void JobSystem::RunOnMainThread(const std::function<void()>& func)
+	{
+		if (IsMainThread())
+		{
+			func();
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(g_mainThreadMutex);
+		g_mainThreadJobs.push_back(func);
+	}
+
+	void JobSystem::ProcessMainThreadJobs()
+	{
+		std::vector<std::function<void()>> jobs;
+
+		{
+			std::lock_guard<std::mutex> lock(g_mainThreadMutex);
+			jobs.swap(g_mainThreadJobs);
+		}
+
+		for (const auto& func : jobs) func();
+
+		// nobody else runs background jobs
+		if (g_workers.empty()) execute(true);
+	}
+
+	unsigned int JobSystem::NumThreads()
+	{
+		return static_cast<unsigned int>(g_workers.size()) + 1;
+	}
+
+	bool JobSystem::IsMainThread()
+	{
+		// before initialization every caller is regarded as main thread
+		return !g_running || std::this_thread::get_id() == g_mainThreadId;
+	}
+
+	void JobSystem::workerLoop(unsigned int index)
+	{
+		t_queueIndex = index;
+
+		while (true)
+		{
+			if (execute(true)) continue;
+
+			std::unique_lock<std::mutex> lock(g_sleepMutex);
+			g_sleepCond.wait(lock, []() { return g_numQueued > 0 || !g_running; });
+
+			if (!g_running) break;
+		}
+	}
+
+	void JobSystem::schedule(const JobHandle& job)
+	{
+		// not initialized, run inline
+		if (g_queues.empty())
+		{
+			job->func();
+			finish(job);
+			return;
+		}
+
+		WorkQueue& queue = job->background ? g_backgroundQueue : *g_queues[t_queueIndex];
+
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back(job);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(g_sleepMutex);
+			++g_numQueued;
+		}
+
+		g_sleepCond.notify_one();
+	}
+
+	void JobSystem::finish(const JobHandle& job)
+	{
+		if (--job->unfinished > 0) return;
+
+		std::vector<JobHandle> dependents;
+
+		{
+			std::lock_guard<std::mutex> lock(job->mutex);
+			job->done = true;
+			dependents.swap(job->dependents);
+		}
+
+		for (const JobHandle& dep : dependents)
+		{
+			if (--dep->pendingDeps == 0)
+				schedule(dep);
+		}
+
+		if (job->parent)
+		{
+			finish(job->parent);
+			job->parent.reset();
+		}
+	}
+
+	bool JobSystem::execute(bool background)
+	{
+		if (g_queues.empty()) return false;
+
+		JobHandle job;
+		size_t numQueues = g_queues.size();
+
+		// own queue first (newest job, cache friendly)
+		{
+			WorkQueue& queue = *g_queues[t_queueIndex];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			if (!queue.jobs.empty())
+			{
+				job = queue.jobs.back();
+				queue.jobs.pop_back();
+			}
+		}
+
+		// steal oldest job from others
+		for (size_t i = 1; !job && i < numQueues; ++i)
+		{
+			WorkQueue& queue = *g_queues[(t_queueIndex + i) % numQueues];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			if (!queue.jobs.empty())
+			{
+				job = queue.jobs.front();
+				queue.jobs.pop_front();
+			}
+		}
+
+		// background jobs in submission order, but newest first inside one (most likely its own children)
+		if (!job && background)
+		{
+			std::lock_guard<std::mutex> lock(g_backgroundQueue.mutex);
+
+			if (!g_backgroundQueue.jobs.empty() && t_background)
+			{
+				job = g_backgroundQueue.jobs.back();
+				g_backgroundQueue.jobs.pop_back();
+			}
+			else if (!g_backgroundQueue.jobs.empty())
+			{
+				job = g_backgroundQueue.jobs.front();
+				g_backgroundQueue.jobs.pop_front();
+			}
+		}
+
+		if (!job) return false;
+
+		--g_numQueued;
+
+		// jobs submitted by a background job are background jobs too
+		bool outer = t_background;
+		t_background = job->background;
+		job->func();
+		t_background = outer;
+
+		finish(job);
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#ifndef XE_JOB_SYSTEM_H
+#define XE_JOB_SYSTEM_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace xengine
+{
+	////////////////////////////////////////////////////////////////
+	// Job System
+	////////////////////////////////////////////////////////////////
+
+	struct Job
+	{
+		std::function<void()> func;
+
+		// this job plus unfinished children (job is done at zero)
+		std::atomic<int> unfinished;
+
+		// dependencies not finished yet (job is scheduled at zero)
+		std::atomic<int> pendingDeps;
+
+		// parent waiting for this job, may be null
+		std::shared_ptr<Job> parent;
+
+		// jobs depending on this one (guarded by mutex)
+		std::vector<std::shared_ptr<Job>> dependents;
+		std::mutex mutex;
+		bool done;
+
+		// queued apart from frame work (see JobSystem::SubmitBackground)
+		bool background;
+
+		Job() : unfinished(1), pendingDeps(1), done(false), background(false) {}
+	};
+
+	typedef std::shared_ptr<Job> JobHandle;
+
+	class JobSystem
+	{
+	public:
+		// spawn worker threads (hardware concurrency - 1 if numWorkers is 0)
+		// calling thread becomes main thread, the only one executing main thread jobs
+		static void Initialize(unsigned int numWorkers = 0);
+
+		// join all workers (pending jobs are finished first)
+		static void Clear();
+
+		// schedule a job once all dependencies are done, parent is not done until job is done
+		static JobHandle Submit(const std::function<void()>& func, const std::vector<JobHandle>& dependencies = {}, const JobHandle& parent = nullptr);
+
+		// schedule a long job (e.g. decoding a streamed texture) on a queue that idle workers take from, so waits
+		// on frame work never run it, jobs it submits are background jobs as well
+		// without workers, main thread runs one per ProcessMainThreadJobs
+		static JobHandle SubmitBackground(const std::function<void()>& func);
+
+		// block until job is done, executing other jobs meanwhile (background jobs only if waiting inside one,
+		// or on one)
+		static void Wait(const JobHandle& job);
+
+		// split [0, count) into chunks of at least grain elements, run func(begin, end) on every chunk and wait
+		static void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& func);
+
+		// queue a job that must run on main thread (e.g. OpenGL calls)
+		static void RunOnMainThread(const std::function<void()>& func);
+
+		// execute all queued main thread jobs (call from main thread once per frame)
+		static void ProcessMainThreadJobs();
+
+		// number of threads executing jobs (workers + main thread)
+		static unsigned int NumThreads();
+
+		static bool IsMainThread();
+
+	private:
+		// per-thread work-stealing queue (owner pops from back, thieves steal from front)
+		struct WorkQueue
+		{
+			std::deque<JobHandle> jobs;
+			std::mutex mutex;
+		};
+
+		static JobHandle submit(const std::function<void()>& func, const std::vector<JobHandle>& dependencies, const JobHandle& parent, bool background);
+		static void workerLoop(unsigned int index);
+		static void schedule(const JobHandle& job);
+		static void finish(const JobHandle& job);
+		static bool execute(bool background); // run a single job (background queue last if allowed), false if nothing found
+
+	private:
+		static std::vector<std::unique_ptr<WorkQueue>> g_queues; // [0] is main thread's
+		static WorkQueue g_backgroundQueue; // shared FIFO of background jobs
+		static std::vector<std::thread> g_workers;
+
+		static std::mutex g_sleepMutex;
+		static std::condition_variable g_sleepCond;
+		static std::atomic<int> g_numQueued;
+		static std::atomic<bool> g_running;
+
+		static std::vector<std::function<void()>> g_mainThreadJobs;
+		static std::mutex g_mainThreadMutex;
+		static std::thread::id g_mainThreadId;
+	};
+}
+
+#endif // !XE_JOB_SYSTEM_H
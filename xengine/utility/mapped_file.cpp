@@ -0,0 +1,102 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace xengine
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+		:
+		m_data(other.m_data),
+		m_size(other.m_size)
+	{
+		other.m_data = nullptr;
+		other.m_size = 0;
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			std::swap(m_data, other.m_data);
+			std::swap(m_size, other.m_size);
+		}
+
+		return *this;
+	}
+
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		HANDLE mapping = nullptr;
+
+		if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		// view keeps mapping alive after handles are closed
+		if (mapping)
+		{
+			m_data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			m_size = m_data ? static_cast<size_t>(size.QuadPart) : 0;
+			CloseHandle(mapping);
+		}
+
+		CloseHandle(file);
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0) return false;
+
+		struct stat info;
+
+		if (fstat(file, &info) == 0 && info.st_size > 0)
+		{
+			void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+			if (data != MAP_FAILED)
+			{
+				m_data = static_cast<const unsigned char*>(data);
+				m_size = static_cast<size_t>(info.st_size);
+			}
+		}
+
+		// mapping stays valid after descriptor is closed
+		close(file);
+#endif
+
+		return m_data != nullptr;
+	}
+
+	void MappedFile::Close()
+	{
+		if (!m_data) return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_data);
+#else
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+
+		m_data = nullptr;
+		m_size = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#ifndef XE_MAPPED_FILE_H
+#define XE_MAPPED_FILE_H
+
+#include <string>
+
+namespace xengine
+{
+	// read-only memory mapping of a whole file
+	// Pages are loaded by the OS on first access, no copy into user memory is made.
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		// map file (closing former mapping), return false if file cannot be opened or is empty
+		bool Open(const std::string& path);
+
+		void Close();
+
+		inline const unsigned char* Data() const { return m_data; }
+		inline size_t Size() const { return m_size; }
+
+		explicit operator bool() const { return m_data != nullptr; }
+
+	private:
+		const unsigned char* m_data = nullptr;
+		size_t m_size = 0;
+	};
+}
+
+#endif // !XE_MAPPED_FILE_H
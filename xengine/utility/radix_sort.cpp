@@ -0,0 +1,70 @@
+#include "radix_sort.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace xengine
+{
+	////////////////////////////////////////////////////////////////
+	// Radix Sort
+	//
+	// Least significant digit first, 8 passes of 8-bit digits.
+	// Histograms of all digits are gathered in one sweep, so that
+	// passes where every key shares the same digit (typically the
+	// high bits of render keys) are skipped.
+	////////////////////////////////////////////////////////////////
+
+	void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch)
+	{
+		const size_t n = items.size();
+		if (n < 2) return;
+
+		if (scratch.size() < n) scratch.resize(n);
+
+		unsigned int histogram[8][256] = {};
+
+		for (const SortItem& item : items)
+		{
+			std::uint64_t key = item.key;
+
+			for (int d = 0; d < 8; ++d)
+			{
+				++histogram[d][key & 0xff];
+				key >>= 8;
+			}
+		}
+
+		SortItem* src = items.data();
+		SortItem* dst = scratch.data();
+
+		for (int d = 0; d < 8; ++d)
+		{
+			unsigned int* count = histogram[d];
+			unsigned int shift = d * 8;
+
+			// all keys share this digit, order is unchanged
+			if (count[(src[0].key >> shift) & 0xff] == n) continue;
+
+			// exclusive prefix sum gives the first slot of each bucket
+			unsigned int offset = 0;
+
+			for (int b = 0; b < 256; ++b)
+			{
+				unsigned int c = count[b];
+				count[b] = offset;
+				offset += c;
+			}
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				dst[count[(src[i].key >> shift) & 0xff]++] = src[i];
+			}
+
+			std::swap(src, dst);
+		}
+
+		// result is left in scratch after an odd number of passes
+		if (src != items.data())
+			std::copy(src, src + n, items.data());
+	}
+}
\ No newline at end of file
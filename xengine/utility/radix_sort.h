@@ -0,0 +1,21 @@
+#pragma once
+#ifndef XE_RADIX_SORT_H
+#define XE_RADIX_SORT_H
+
+#include <vector>
+#include <cstdint>
+
+namespace xengine
+{
+	struct SortItem
+	{
+		std::uint64_t key;
+		unsigned int value;
+	};
+
+	// stable LSD radix sort of items in ascending key order (8-bit digits, constant digits are skipped)
+	// scratch is only used as temporary storage; keep it alive to avoid re-allocation
+	void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch);
+}
+
+#endif // !XE_RADIX_SORT_H
@@ -0,0 +1,82 @@
+#include "range_allocator.h"
+
+#include <iterator>
+
+namespace xengine
+{
+	RangeAllocator::RangeAllocator(unsigned int capacity)
+	{
+		Clear(capacity);
+	}
+
+	unsigned int RangeAllocator::Allocate(unsigned int size)
+	{
+		if (size == 0) return kInvalid;
+
+		for (auto it = m_free.begin(); it != m_free.end(); ++it)
+		{
+			if (it->second < size) continue;
+
+			unsigned int offset = it->first;
+			unsigned int remain = it->second - size;
+
+			m_free.erase(it);
+			if (remain > 0) m_free[offset + size] = remain;
+
+			m_used += size;
+			return offset;
+		}
+
+		return kInvalid;
+	}
+
+	void RangeAllocator::Free(unsigned int offset, unsigned int size)
+	{
+		if (size == 0 || offset == kInvalid) return;
+
+		m_used -= size;
+		release(offset, size);
+	}
+
+	void RangeAllocator::Grow(unsigned int capacity)
+	{
+		if (capacity <= m_capacity) return;
+
+		release(m_capacity, capacity - m_capacity);
+		m_capacity = capacity;
+	}
+
+	void RangeAllocator::release(unsigned int offset, unsigned int size)
+	{
+		auto next = m_free.lower_bound(offset);
+
+		// merge with following free range
+		if (next != m_free.end() && offset + size == next->first)
+		{
+			size += next->second;
+			next = m_free.erase(next);
+		}
+
+		// merge with preceding free range
+		if (next != m_free.begin())
+		{
+			auto prev = std::prev(next);
+
+			if (prev->first + prev->second == offset)
+			{
+				prev->second += size;
+				return;
+			}
+		}
+
+		m_free[offset] = size;
+	}
+
+	void RangeAllocator::Clear(unsigned int capacity)
+	{
+		m_free.clear();
+		if (capacity > 0) m_free[0] = capacity;
+		m_capacity = capacity;
+		m_used = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#ifndef XE_RANGE_ALLOCATOR_H
+#define XE_RANGE_ALLOCATOR_H
+
+#include <map>
+
+namespace xengine
+{
+	// first-fit sub-allocator of ranges [offset, offset + size) out of a linear space of capacity units
+	// Note: it only does bookkeeping, owner of the space (e.g. a GPU buffer) is managed by the caller
+	class RangeAllocator
+	{
+	public:
+		static const unsigned int kInvalid = 0xffffffff;
+
+		RangeAllocator(unsigned int capacity = 0);
+
+		// reserve size units, return offset of the range or kInvalid if no free range is large enough
+		unsigned int Allocate(unsigned int size);
+
+		// release a range returned by Allocate (adjacent free ranges are merged)
+		void Free(unsigned int offset, unsigned int size);
+
+		// extend the space to capacity units, existing ranges are kept
+		void Grow(unsigned int capacity);
+
+		void Clear(unsigned int capacity = 0);
+
+		inline unsigned int Capacity() const { return m_capacity; }
+		inline unsigned int Used() const { return m_used; }
+
+	private:
+		// put range back to free list, merging with neighbours
+		void release(unsigned int offset, unsigned int size);
+
+	private:
+		std::map<unsigned int, unsigned int> m_free; // offset -> size
+		unsigned int m_capacity;
+		unsigned int m_used;
+	};
+}
+
+#endif // !XE_RANGE_ALLOCATOR_H
@@ -84,6 +84,9 @@ namespace xengine
 			return *this;
 		}
 
+		// number of handles sharing the memory (0 if none allocated)
+		unsigned long long UseCount() const { return m_ptr ? m_ptr->ReferenceCount() : 0; }
+
 	protected:
 		// allocate handle memory on the platform (like CPU)
 		virtual void allocateMemory()
@@ -9,6 +9,7 @@ namespace xengine
 	{
 		// initialize system
 		Log::Initialize();
+		JobSystem::Initialize();
 
 		// initialize GLFW
 		if (!glfwInit())
@@ -71,6 +72,13 @@ namespace xengine
 		// https://learnopengl.com/PBR/IBL/Specular-IBL
 		glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
+		// program binaries, imported models and compressed textures of former runs
+		ProgramCache::Initialize();
+		ShaderBuildQueue::Initialize();
+		ModelCache::Initialize();
+		TextureCache::Initialize();
+		TextureCompressor::Initialize();
+
 		// default resources
 		ShaderManager::Initialize();
 		TextureManager::Initialize();
@@ -86,16 +94,33 @@ namespace xengine
 
 		// generate uniform buffers
 		Renderer::Initialize();
+
+		// wait for programs of default resources
+		ShaderBuildQueue::Flush();
 	}
 
 	void xe_terminate()
 	{
 		UI::Clear();
 		ModelManager::Clear();
+		ModelCache::Clear();
 		MeshManager::Clear();
 		MaterialManager::Clear();
+		TextureStreamer::Clear();
 		TextureManager::Clear();
+		TextureCache::Clear();
+		ShaderBuildQueue::Clear();
 		ShaderManager::Clear();
+		ProgramCache::Clear();
+		InstanceBuffer::Clear();
+		ObjectBuffer::Clear();
+		IndirectBuffer::Clear();
+		MaterialBuffer::Clear();
+		MeshBuffer::Clear();
+		LightCluster::Clear();
+		FrameSync::Clear();
+
+		JobSystem::Clear();
 
 		glfwTerminate();
 	}
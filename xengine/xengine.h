@@ -7,18 +7,32 @@
 #include <glm/glm.hpp>
 
 #include <utility/log.h>
+#include <utility/job_system.h>
 #include <mesh/mesh.h>
 #include <mesh/primitive.h>
 #include <mesh/mesh_manager.h>
+#include <mesh/mesh_buffer.h>
 #include <model/model.h>
 #include <model/skybox.h>
 #include <model/model_manager.h>
+#include <model/model_cache.h>
 #include <scene/scene.h>
 #include <geometry/camera.h>
 #include <graphics/shader_manager.h>
+#include <graphics/program_cache.h>
+#include <graphics/shader_build_queue.h>
 #include <graphics/texture_manager.h>
+#include <graphics/texture_streamer.h>
+#include <graphics/texture_compressor.h>
+#include <graphics/texture_cache.h>
 #include <graphics/material_manager.h>
+#include <graphics/material_buffer.h>
 #include <graphics/renderer.h>
+#include <graphics/instance_buffer.h>
+#include <graphics/object_buffer.h>
+#include <graphics/frame_sync.h>
+#include <graphics/light_cluster.h>
+#include <graphics/indirect_buffer.h>
 #include <graphics/ibl_renderer.h>
 #include <ui/ui.h>
 